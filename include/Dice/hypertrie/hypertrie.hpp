@@ -4,6 +4,8 @@
 #include "Dice/hypertrie/internal/Hypertrie.hpp"
 #include "Dice/hypertrie/internal/HashJoin.hpp"
 #include "Dice/hypertrie/internal/BulkInserter.hpp"
+#include "Dice/hypertrie/internal/BulkRemover.hpp"
+#include "Dice/hypertrie/internal/AsyncBulkInserter.hpp"
 #include "Dice/einsum/internal/Einsum.hpp"
 
 namespace hypertrie {
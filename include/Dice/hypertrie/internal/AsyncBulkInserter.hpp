@@ -0,0 +1,194 @@
+#ifndef HYPERTRIE_ASYNCBULKINSERTER_HPP
+#define HYPERTRIE_ASYNCBULKINSERTER_HPP
+
+#include "Dice/hypertrie/internal/BulkInserter.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hypertrie {
+
+	/**
+	 * Bulk inserter that modifies the hypertrie on a background thread while producers keep adding entries.
+	 *
+	 * Entries are collected in a buffer. When it is full, it is handed over to the background thread and producers
+	 * continue with a second buffer. If the background thread is still busy with the previous buffer, the producer waits
+	 * for it. So at most two buffers exist at a time.
+	 *
+	 * add() may be called from multiple threads; they are serialized by a mutex. Adding batches of entries reduces
+	 * the contention. The background thread is the only one that modifies the hypertrie: it must not be accessed otherwise
+	 * until flush() or close() returned.
+	 *
+	 * Entries that are already contained are sorted out by the background thread (see BulkInserter::LookupMode::batched).
+	 * For valued hypertries, values of the same key are combined with the duplicate policy.
+	 */
+	template<HypertrieTrait tr_t>
+	class AsyncBulkInserter {
+	public:
+		using tr = tr_t;
+		using Entry = typename tr::IteratorEntry;
+		using value_type = typename tr::value_type;
+		using DuplicatePolicy = internal::raw::DuplicatePolicy;
+
+	private:
+		Hypertrie<tr> *hypertrie;
+		size_t buffer_size;
+		DuplicatePolicy duplicate_policy;
+
+		std::mutex mutex;
+		/**
+		 * Notifies the background thread about a handed over buffer or about closing.
+		 */
+		std::condition_variable work_available;
+		/**
+		 * Notifies producers that the background thread finished a buffer.
+		 */
+		std::condition_variable work_done;
+
+		std::vector<Entry> filling;
+		std::vector<Entry> handed_over;
+		/**
+		 * A buffer was handed over and is not inserted completely yet.
+		 */
+		bool busy = false;
+		bool closing = false;
+		std::exception_ptr error = nullptr;
+
+		std::thread background;
+
+	public:
+		/**
+		 * @param hypertrie the hypertrie to insert into
+		 * @param buffer_size number of entries per buffer. Must be larger than 0.
+		 * @param duplicate_policy how values of repeated and contained keys are combined. Only used for valued hypertries.
+		 */
+		explicit AsyncBulkInserter(Hypertrie<tr> &hypertrie, size_t buffer_size = 1'000'000, DuplicatePolicy duplicate_policy = DuplicatePolicy::overwrite)
+			: hypertrie(&hypertrie), buffer_size(std::max<size_t>(1, buffer_size)), duplicate_policy(duplicate_policy) {
+			filling.reserve(this->buffer_size);
+			background = std::thread([this]() { run(); });
+		}
+
+		AsyncBulkInserter(const AsyncBulkInserter &) = delete;
+		AsyncBulkInserter &operator=(const AsyncBulkInserter &) = delete;
+
+		/**
+		 * Inserts the remaining entries and stops the background thread. Errors are not reported; call close() to observe them.
+		 */
+		~AsyncBulkInserter() {
+			try {
+				close();
+			} catch (...) {
+			}
+		}
+
+		/**
+		 * Adds an entry. Blocks if the buffer is full while the previous one is still inserted.
+		 * @throws the exception of a failed insertion of a previous buffer
+		 */
+		void add(Entry &&entry) {
+			std::unique_lock lock{mutex};
+			rethrowError();
+			filling.push_back(std::move(entry));
+			if (filling.size() >= buffer_size)
+				handOver(lock);
+		}
+
+		/**
+		 * Adds a batch of entries. Blocks if the buffer is full while the previous one is still inserted.
+		 * @throws the exception of a failed insertion of a previous buffer
+		 */
+		void add(std::vector<Entry> &&entries) {
+			std::unique_lock lock{mutex};
+			rethrowError();
+			for (auto &entry : entries) {
+				filling.push_back(std::move(entry));
+				if (filling.size() >= buffer_size)
+					handOver(lock);
+			}
+			entries.clear();
+		}
+
+		/**
+		 * Inserts all entries added so far and waits until the hypertrie is not modified anymore.
+		 * @throws the exception of a failed insertion
+		 */
+		void flush() {
+			std::unique_lock lock{mutex};
+			if (not filling.empty())
+				handOver(lock);
+			work_done.wait(lock, [this]() { return not busy; });
+			rethrowError();
+		}
+
+		/**
+		 * Flushes and stops the background thread. Entries must not be added afterwards.
+		 * @throws the exception of a failed insertion
+		 */
+		void close() {
+			if (not background.joinable())
+				return;
+			std::exception_ptr flush_error = nullptr;
+			try {
+				flush();
+			} catch (...) {
+				flush_error = std::current_exception();
+			}
+			{
+				std::lock_guard lock{mutex};
+				closing = true;
+			}
+			work_available.notify_one();
+			background.join();
+			if (flush_error)
+				std::rethrow_exception(flush_error);
+		}
+
+	private:
+		void rethrowError() {
+			if (error)
+				std::rethrow_exception(error);
+		}
+
+		/**
+		 * Waits until the background thread is idle and hands the filled buffer over.
+		 */
+		void handOver(std::unique_lock<std::mutex> &lock) {
+			work_done.wait(lock, [this]() { return not busy; });
+			rethrowError();
+			std::swap(filling, handed_over);
+			busy = true;
+			work_available.notify_one();
+		}
+
+		void run() {
+			std::unique_lock lock{mutex};
+			while (true) {
+				work_available.wait(lock, [this]() { return busy or closing; });
+				if (not busy)
+					return;
+				std::vector<Entry> entries = std::move(handed_over);
+				lock.unlock();
+				std::exception_ptr insert_error = nullptr;
+				try {
+					BulkInserter<tr>::insert(*hypertrie, entries, BulkInserter<tr>::LookupMode::batched, duplicate_policy);
+				} catch (...) {
+					insert_error = std::current_exception();
+				}
+				entries.clear();
+				lock.lock();
+				if (insert_error and not error)
+					error = insert_error;
+				// keep the capacity for the next buffer
+				handed_over = std::move(entries);
+				busy = false;
+				work_done.notify_all();
+			}
+		}
+	};
+}// namespace hypertrie
+
+#endif//HYPERTRIE_ASYNCBULKINSERTER_HPP
@@ -8,12 +8,27 @@ namespace hypertrie {
 	template<HypertrieTrait tr_t>
 	class BulkInserter {
 	public:
+		/**
+		 * When entries that are already contained in the hypertrie are sorted out. Only used for bool-valued hypertries.
+		 */
+		enum class LookupMode {
+			/**
+			 * add() looks up every entry before it is buffered.
+			 */
+			per_entry,
+			/**
+			 * flush() filters all buffered entries in one walk over the hypertrie. Nothing is looked up while the hypertrie is empty.
+			 */
+			batched
+		};
+
 		using tr = tr_t;
 		using tri = internal::raw::Hypertrie_internal_t<tr>;
 		using Entry = typename tr::IteratorEntry;
 		using Key = typename tr::Key;
 		using value_type = typename tr::value_type;
 		using EntryFunctions = typename tr::iterator_entry;
+		using DuplicatePolicy = internal::raw::DuplicatePolicy;
 
 	private:
 		using collection_type = std::conditional_t<(tr::is_bool_valued),
@@ -24,13 +39,19 @@ namespace hypertrie {
 
 		collection_type new_entries;
 		size_t threshold = 1'000'000;
+		LookupMode lookup_mode = LookupMode::per_entry;
+		DuplicatePolicy duplicate_policy = DuplicatePolicy::overwrite;
 
 	public:
-		BulkInserter(Hypertrie<tr> &hypertrie, size_t threshold = 1'000'000) : hypertrie(&hypertrie), threshold(threshold) {
-			if constexpr (not tr::is_bool_valued) {
-				throw std::logic_error("Bulk loading is only supported for bool-valued Hypertries yet.");
-			}
-		}
+		BulkInserter(Hypertrie<tr> &hypertrie, size_t threshold = 1'000'000, LookupMode lookup_mode = LookupMode::per_entry)
+			: hypertrie(&hypertrie), threshold(threshold), lookup_mode(lookup_mode) {}
+
+		/**
+		 * Bulk inserter for valued hypertries. Values of a key that is added multiple times or that is already contained
+		 * are combined according to duplicate_policy. Keys that end up with value zero are removed.
+		 */
+		BulkInserter(Hypertrie<tr> &hypertrie, size_t threshold, DuplicatePolicy duplicate_policy)
+			: hypertrie(&hypertrie), threshold(threshold), duplicate_policy(duplicate_policy) {}
 
 		~BulkInserter() {
 			flush();
@@ -38,7 +59,15 @@ namespace hypertrie {
 
 		void add(Entry &&entry) {
 			assert(EntryFunctions::key(entry).size() == hypertrie->depth());
-			if ((*hypertrie)[EntryFunctions::key(entry)] == value_type{}) {
+			if constexpr (not tr::is_bool_valued) {
+				// the present values are looked up when flushing
+				if (auto found = new_entries.find(entry.first); found != new_entries.end())
+					found.value() = internal::raw::combineDuplicate(duplicate_policy, found->second, entry.second);
+				else
+					new_entries.insert(std::forward<Entry>(entry));
+				if (threshold != 0 and new_entries.size() > threshold)
+					flush();
+			} else if (lookup_mode == LookupMode::batched or (*hypertrie)[EntryFunctions::key(entry)] == value_type{}) {
 				new_entries.insert(std::forward<Entry>(entry));
 				if (threshold != 0 and new_entries.size() > threshold)
 					flush();
@@ -46,24 +75,56 @@ namespace hypertrie {
 		}
 
 		void flush() {
+			insert(*hypertrie, new_entries, lookup_mode, duplicate_policy);
+		}
 
+		/**
+		 * Inserts a batch of entries into a hypertrie. The entries are cleared before the hypertrie is modified.
+		 * @param hypertrie the hypertrie
+		 * @param entries range of keys (bool-valued) or of pairs of key and value (valued). Keys may repeat.
+		 * @param lookup_mode LookupMode::per_entry if the keys are known to be not contained in the hypertrie and to be
+		 * pairwise distinct. Only used for bool-valued hypertries.
+		 * @param duplicate_policy how values of repeated and contained keys are combined. Only used for valued hypertries.
+		 */
+		template<typename Entries>
+		static void insert(Hypertrie<tr> &hypertrie, Entries &entries, LookupMode lookup_mode, DuplicatePolicy duplicate_policy) {
 			internal::compiled_switch<hypertrie_depth_limit, 1>::switch_void(
-					hypertrie->depth(),
+					hypertrie.depth(),
 					[&](auto depth_arg) {
 						using RawKey = typename tri::template RawKey<depth_arg>;
-						std::vector<RawKey> keys(new_entries.size());
-						for (auto [i, entry] : iter::enumerate(new_entries)) {
-							RawKey &raw_key = keys[i];
-							for (auto i : iter::range(size_t(depth_arg)))
-								raw_key[i] = entry[i];// todo: add support for non-boolean
-						}
+						auto &typed_nodec = *reinterpret_cast<internal::raw::NodeContainer<depth_arg, tri> *>(const_cast<hypertrie::internal::raw::RawNodeContainer *>(hypertrie.rawNodeContainer()));
+						auto &raw_context = hypertrie.context()->rawContext();
+						if constexpr (tr::is_bool_valued) {
+							std::vector<RawKey> keys(entries.size());
+							for (auto [i, entry] : iter::enumerate(entries)) {
+								RawKey &raw_key = keys[i];
+								for (auto i : iter::range(size_t(depth_arg)))
+									raw_key[i] = entry[i];
+							}
+
+							entries.clear();
+							if (lookup_mode == LookupMode::batched)
+								raw_context.template filter_contained<depth_arg>(typed_nodec, keys);
+							raw_context.template bulk_insert<depth_arg>(typed_nodec, std::move(keys));
+						} else {
+							std::vector<std::pair<RawKey, value_type>> raw_entries(entries.size());
+							for (auto [i, entry] : iter::enumerate(entries)) {
+								auto &[raw_key, value] = raw_entries[i];
+								for (auto i : iter::range(size_t(depth_arg)))
+									raw_key[i] = entry.first[i];
+								value = entry.second;
+							}
 
-						new_entries.clear();
-						auto &typed_nodec = *reinterpret_cast<internal::raw::NodeContainer<depth_arg, tri> *>(const_cast<hypertrie::internal::raw::RawNodeContainer *>(hypertrie->rawNodeContainer()));
-						hypertrie->context()->rawContext().template bulk_insert<depth_arg>(typed_nodec, std::move(keys));
+							entries.clear();
+							raw_context.template bulk_set<depth_arg>(typed_nodec, std::move(raw_entries), duplicate_policy);
+						}
 					});
 		}
 
+		/**
+		 * Number of buffered entries. In LookupMode::batched and for valued hypertries, it includes entries that are already
+		 * contained in the hypertrie.
+		 */
 		[[nodiscard]] size_t size() const{
 			return new_entries.size();
 		}
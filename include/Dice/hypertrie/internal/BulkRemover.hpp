@@ -0,0 +1,95 @@
+#ifndef HYPERTRIE_BULKREMOVER_HPP
+#define HYPERTRIE_BULKREMOVER_HPP
+
+#include "Dice/hypertrie/internal/Hypertrie.hpp"
+
+namespace hypertrie {
+
+	/**
+	 * Counterpart of BulkInserter. Keys are buffered and removed from the hypertrie in one modification per flush.
+	 * Nodes that are affected by multiple keys are rewritten once and nodes that are not referenced anymore are
+	 * released together at the end of the flush.
+	 */
+	template<HypertrieTrait tr_t>
+	class BulkRemover {
+	public:
+		using tr = tr_t;
+		using tri = internal::raw::Hypertrie_internal_t<tr>;
+		using Key = typename tr::Key;
+
+	private:
+		using collection_type = tsl::sparse_set<Key, absl::Hash<Key>>;
+
+		Hypertrie<tr> *hypertrie;
+
+		collection_type removed_keys;
+		size_t threshold = 1'000'000;
+
+	public:
+		BulkRemover(Hypertrie<tr> &hypertrie, size_t threshold = 1'000'000)
+			: hypertrie(&hypertrie), threshold(threshold) {}
+
+		~BulkRemover() {
+			flush();
+		}
+
+		/**
+		 * Buffers a key for removal. Keys that are not contained in the hypertrie are ignored when flushing.
+		 */
+		void add(Key &&key) {
+			assert(key.size() == hypertrie->depth());
+			removed_keys.insert(std::move(key));
+			if (threshold != 0 and removed_keys.size() > threshold)
+				flush();
+		}
+
+		void add(const Key &key) {
+			add(Key{key});
+		}
+
+		void flush() {
+			remove(*hypertrie, removed_keys);
+		}
+
+		/**
+		 * Removes a batch of keys from a hypertrie. The keys are cleared before the hypertrie is modified.
+		 * @param hypertrie the hypertrie
+		 * @param keys range of keys. Keys may repeat and may be not contained in the hypertrie.
+		 */
+		template<typename Keys>
+		static void remove(Hypertrie<tr> &hypertrie, Keys &keys) {
+			if (keys.empty())
+				return;
+			if (hypertrie.empty()) {
+				keys.clear();
+				return;
+			}
+			internal::compiled_switch<hypertrie_depth_limit, 1>::switch_void(
+					hypertrie.depth(),
+					[&](auto depth_arg) {
+						using RawKey = typename tri::template RawKey<depth_arg>;
+						auto &typed_nodec = *reinterpret_cast<internal::raw::NodeContainer<depth_arg, tri> *>(const_cast<hypertrie::internal::raw::RawNodeContainer *>(hypertrie.rawNodeContainer()));
+						auto &raw_context = hypertrie.context()->rawContext();
+						std::vector<RawKey> raw_keys(keys.size());
+						for (auto [i, key] : iter::enumerate(keys)) {
+							RawKey &raw_key = raw_keys[i];
+							for (auto i : iter::range(size_t(depth_arg)))
+								raw_key[i] = key[i];
+						}
+
+						keys.clear();
+						raw_context.template bulk_remove<depth_arg>(typed_nodec, std::move(raw_keys));
+					});
+		}
+
+		/**
+		 * Number of buffered keys. It includes keys that are not contained in the hypertrie.
+		 */
+		[[nodiscard]] size_t size() const {
+			return removed_keys.size();
+		}
+	};
+}// namespace hypertrie
+
+
+#endif//HYPERTRIE_BULKREMOVER_HPP
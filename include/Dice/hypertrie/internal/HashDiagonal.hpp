@@ -5,6 +5,8 @@
 #include "Dice/hypertrie/internal/HypertrieContext.hpp"
 #include "Dice/hypertrie/internal/Hypertrie_predeclare.hpp"
 
+#include <memory>
+
 namespace hypertrie {
 
 	template<HypertrieTrait tr_t = default_bool_Hypertrie_t>
@@ -90,8 +92,11 @@ namespace hypertrie {
 							const auto &value = raw_diagonal.currentValue();
 							if (value.is_managed) {
 								return const_Hypertrie<tr>(result_depth, context, {value.nodec.hash().hash(), value.nodec.node()});
+							} else if constexpr (result_depth == 1 and tri::is_bool_valued and tri::is_lsb_unused) {
+								// the key part of a compressed node is stored in the hash
+								return const_Hypertrie<tr>(result_depth, nullptr, {value.nodec.hash().hash(), nullptr});
 							} else {
-								return const_Hypertrie<tr>(result_depth, nullptr, {value.nodec.hash().hash(), new internal::raw::CompressedNode<result_depth, tri>(*value.nodec.compressed_node())});
+								return const_Hypertrie<tr>::template contextlessCompressed<result_depth>(value.nodec.hash().hash(), *value.nodec.compressed_node());
 							}
 						} else {
 							assert(false);
@@ -156,18 +161,69 @@ namespace hypertrie {
 			return raw_method_cache[compression][depth - 1][diag_depth-1];
 		};
 
+		/**
+		 * Checks if the diagonal can be iterated on the nodes of hypertrie (see NodeContext::diagonalIndexed).
+		 */
+		static bool diagonalIndexed(const const_Hypertrie<tr> &hypertrie, const KeyPositions &diag_poss) {
+			if (hypertrie.contextless() or hypertrie.size() <= 1)
+				return true;
+			return internal::compiled_switch<hypertrie_depth_limit, 1>::switch_(
+					hypertrie.depth(),
+					[&](auto depth_arg) -> bool {
+						RawKeyPositions<depth_arg> raw_diag_poss;
+						for (auto pos : diag_poss)
+							raw_diag_poss[pos] = true;
+						const auto &nodec = *reinterpret_cast<const internal::raw::NodeContainer<depth_arg, tri> *>(hypertrie.rawNodeContainer());
+						return hypertrie.context()->rawContext().template diagonalIndexed<depth_arg>(nodec, raw_diag_poss);
+					},
+					[]() -> bool { assert(false); return true; });
+		}
+
+		/**
+		 * Collects the entries of hypertrie that have the same key part at all diagonal positions into a temporary
+		 * hypertrie (see const_Hypertrie::temporary). The entries are visited through position 0, so no other position
+		 * needs to be indexed (see NodeContext::forEachEntry).
+		 */
+		static std::shared_ptr<const const_Hypertrie<tr>> scanDiagonal(const const_Hypertrie<tr> &hypertrie, const KeyPositions &diag_poss) {
+			return internal::compiled_switch<hypertrie_depth_limit, 1>::switch_(
+					hypertrie.depth(),
+					[&](auto depth_arg) -> std::shared_ptr<const const_Hypertrie<tr>> {
+						using red = internal::raw::RawEntry_t<depth_arg, tri>;
+						std::vector<typename red::RawEntry> entries;
+						const auto &nodec = *reinterpret_cast<const internal::raw::NodeContainer<depth_arg, tri> *>(hypertrie.rawNodeContainer());
+						hypertrie.context()->rawContext().template forEachEntry<depth_arg>(nodec, [&](const auto &key, value_type value) {
+							for (auto pos : diag_poss)
+								if (key[pos] != key[diag_poss.front()])
+									return;
+							entries.push_back(red::make_Entry(key, value));
+						});
+						return std::make_shared<const const_Hypertrie<tr>>(const_Hypertrie<tr>::template temporary<depth_arg>(std::move(entries)));
+					},
+					[]() -> std::shared_ptr<const const_Hypertrie<tr>> { assert(false); return {}; });
+		}
+
 	protected:
+		/**
+		 * Holds the entries on the diagonal if the diagonal needs positions that are not indexed. The diagonal is iterated on it instead.
+		 */
+		std::shared_ptr<const const_Hypertrie<tr>> scanned_;
 		RawMethods const * raw_methods = nullptr;
 		void* raw_hash_diagonal;
 		HypertrieContext<tr> *context_;
 
+		const const_Hypertrie<tr> &iterated(const const_Hypertrie<tr> &hypertrie) const {
+			return (scanned_ != nullptr) ? *scanned_ : hypertrie;
+		}
+
 	public:
 		HashDiagonal(const const_Hypertrie<tr> &hypertrie, const KeyPositions &diag_poss)
-			: raw_methods(&getRawMethods(hypertrie.depth(), diag_poss.size(), hypertrie.size() == 1)),
-			  raw_hash_diagonal(raw_methods->construct(hypertrie, diag_poss)), context_(hypertrie.context()) {}
+			: scanned_(diagonalIndexed(hypertrie, diag_poss) ? nullptr : scanDiagonal(hypertrie, diag_poss)),
+			  raw_methods(&getRawMethods(hypertrie.depth(), diag_poss.size(), iterated(hypertrie).size() == 1)),
+			  raw_hash_diagonal(raw_methods->construct(iterated(hypertrie), diag_poss)), context_(iterated(hypertrie).context()) {}
 
 		HashDiagonal(HashDiagonal &&other)
-			: raw_methods(other.raw_methods),
+			: scanned_(std::move(other.scanned_)),
+			  raw_methods(other.raw_methods),
 			  raw_hash_diagonal(other.raw_hash_diagonal),
 			  context_(other.context_) {
 			other.raw_hash_diagonal = nullptr;
@@ -180,6 +236,7 @@ namespace hypertrie {
 				raw_methods->destruct(raw_hash_diagonal);
 				raw_hash_diagonal = nullptr;
 			}
+			this->scanned_ = std::move(other.scanned_);
 			this->raw_methods = other.raw_methods;
 			this->raw_hash_diagonal = other.raw_hash_diagonal;
 			this->context_ = other.context_;
@@ -211,7 +268,10 @@ namespace hypertrie {
 		}
 
 		const_Hypertrie<tr> currentHypertrie() const{
-			return raw_methods->currentHypertrie(raw_hash_diagonal,context_);
+			auto result = raw_methods->currentHypertrie(raw_hash_diagonal,context_);
+			if (scanned_ != nullptr and not result.contextless())
+				result.temporary_context_ = scanned_->temporary_context_;
+			return result;
 		}
 
 
@@ -5,11 +5,20 @@
 
 #include "Dice/hypertrie/internal/HashDiagonal.hpp"
 #include "Dice/hypertrie/internal/HypertrieContext.hpp"
+#include "Dice/hypertrie/internal/SliceCache.hpp"
 #include "Dice/hypertrie/internal/Hypertrie_traits.hpp"
 #include "Dice/hypertrie/internal/Iterator.hpp"
 
 #include "Dice/hypertrie/internal/util/CONSTANTS.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <new>
 #include <optional>
+#include <span>
 #include <variant>
 #include <vector>
 #include <itertools.hpp>
@@ -30,6 +39,9 @@ namespace hypertrie {
 
 		typedef typename internal::raw::RawNodeContainer NodeContainer;
 
+		template<size_t depth>
+		using RawEntries = std::vector<typename internal::raw::RawEntry_t<depth, tri>::RawEntry>;
+
 	protected:
 		NodeContainer node_container_;
 
@@ -37,46 +49,122 @@ namespace hypertrie {
 
 		size_t depth_ = 0;
 
+		using InlineNode = internal::raw::CompressedNode<hypertrie_depth_limit, tri>;
+		static_assert(std::is_trivially_copyable_v<InlineNode>);
+		/**
+		 * Storage for a compressed node that is not in the node storage (contextless compressed node). It fits a
+		 * compressed node of any depth, so slices and diagonals return such results without allocating.
+		 */
+		alignas(InlineNode) std::array<std::byte, sizeof(InlineNode)> inline_node_;
+
+		/**
+		 * Owns the context if this hypertrie lives in a temporary context (see temporary). It is shared by all hypertries
+		 * of that context. Otherwise, it is empty.
+		 */
+		std::shared_ptr<HypertrieContext<tr>> temporary_context_;
+
 		const_Hypertrie(size_t depth, HypertrieContext<tr> *context, NodeContainer node_container = {}) : node_container_(std::move(node_container)), context_(context), depth_(depth) {}
 
+		/**
+		 * Creates a contextless hypertrie that holds a copy of the compressed node inline.
+		 * @tparam depth depth of the compressed node
+		 * @param hash hash of the compressed node
+		 * @param node the compressed node
+		 * @return a contextless hypertrie
+		 */
+		template<size_t depth>
+		static const_Hypertrie contextlessCompressed(internal::raw::TensorHash hash, const internal::raw::CompressedNode<depth, tri> &node) {
+			static_assert(sizeof(internal::raw::CompressedNode<depth, tri>) <= sizeof(InlineNode));
+			const_Hypertrie result(depth, nullptr, {hash, nullptr});
+			result.node_container_.pointer_sized = new (result.inline_node_.data()) internal::raw::CompressedNode<depth, tri>(node);
+			return result;
+		}
+
+		/**
+		 * Creates a hypertrie of the given entries that is not part of any existing context. It is used for sub-tensors
+		 * that are not in the node storage because they need positions that are not indexed. A single entry is stored
+		 * inline (see contextlessCompressed). Otherwise, the entries are inserted into a new temporary context, which
+		 * costs about as much as inserting them into a new hypertrie.
+		 * @tparam depth depth of the entries
+		 * @param entries the entries. They must be pairwise distinct.
+		 * @return a read-only hypertrie of the entries
+		 */
+		template<size_t depth>
+		static const_Hypertrie temporary(RawEntries<depth> entries) {
+			using red = internal::raw::RawEntry_t<depth, tri>;
+			if (entries.size() == 1) {
+				if constexpr (depth == 1 and tri::is_bool_valued and tri::is_lsb_unused) {
+					// the key part of a compressed node is stored in the hash
+					return const_Hypertrie(depth, nullptr, {internal::raw::TaggedTensorHash<tri>(red::key(entries[0])[0]).hash(), nullptr});
+				} else {
+					internal::raw::CompressedNode<depth, tri> node;
+					node.key() = red::key(entries[0]);
+					if constexpr (not tri::is_bool_valued)
+						node.value() = red::value(entries[0]);
+					return contextlessCompressed<depth>(internal::raw::TensorHash().addFirstEntry(node.key(), node.value()), node);
+				}
+			}
+			auto context = std::make_shared<HypertrieContext<tr>>();
+			internal::raw::NodeContainer<depth, tri> nodec{};
+			if (not entries.empty()) {
+				if constexpr (tri::is_bool_valued) {
+					context->rawContext().template bulk_insert<depth>(nodec, std::move(entries));
+				} else {
+					std::vector<std::pair<RawKey<depth>, value_type>> raw_entries;
+					raw_entries.reserve(entries.size());
+					for (const auto &entry : entries)
+						raw_entries.emplace_back(red::key(entry), red::value(entry));
+					entries.clear();
+					context->rawContext().template bulk_set<depth>(nodec, std::move(raw_entries));
+				}
+			}
+			// the reference of the root is never released. The nodes are freed with the context.
+			const_Hypertrie result(depth, context.get(), {nodec.hash().hash(), nodec.node()});
+			result.temporary_context_ = std::move(context);
+			return result;
+		}
+
+		/**
+		 * Creates a hypertrie of a node in the context of this hypertrie. A temporary context is kept alive.
+		 */
+		const_Hypertrie sameContext(size_t depth, NodeContainer node_container) const {
+			const_Hypertrie result(depth, context_, node_container);
+			result.temporary_context_ = temporary_context_;
+			return result;
+		}
+
 		constexpr bool contextless() const noexcept {
 			return context_ == nullptr;
 		}
 
 		friend class HashDiagonal<tr>;
 
-
-	public:
-		~const_Hypertrie() {
-			if (contextless() and node_container_.hash_sized != 0) {
-				using namespace internal;
-				assert(node_container_.pointer_sized != nullptr);
-				compiled_switch<hypertrie_depth_limit, 1>::switch_void(
-						this->depth_,
-						[&](auto depth_arg) {
-							using CND = typename internal::raw::template CompressedNodeContainer<depth_arg, tri>;
-							if constexpr (not(depth_arg == 1 and tri::is_bool_valued and tri::is_lsb_unused))
-								delete reinterpret_cast<CND *>(&this->node_container_)->compressed_node();
-						},
-						[]() { assert(false); });
+	private:
+		/**
+		 * Copies the node container. A contextless compressed node is copied into the own inline storage.
+		 */
+		void copyNodeContainer(const const_Hypertrie &other) noexcept {
+			node_container_ = other.node_container_;
+			if (node_container_.pointer_sized == other.inline_node_.data()) {
+				std::memcpy(inline_node_.data(), other.inline_node_.data(), sizeof(InlineNode));
+				node_container_.pointer_sized = inline_node_.data();
 			}
 		}
 
+	public:
 		const_Hypertrie(const const_Hypertrie &const_hypertrie)
-			: node_container_(const_hypertrie.node_container_), context_(const_hypertrie.context_), depth_(const_hypertrie.depth_) {
-			if (contextless() and not empty()) {
-				internal::compiled_switch<hypertrie_depth_limit, 1>::switch_void(
-						this->depth_,
-						[&](auto depth_arg) {
-							using CND = typename internal::raw::template CompressedNodeContainer<depth_arg, tri>;
-							if constexpr (not(depth_arg == 1 and tri::is_bool_valued and tri::is_lsb_unused)) {
-								// create a copy of the contextless compressed node
-								auto nodec = reinterpret_cast<CND *>(&this->node_container_);
-								nodec->compressed_node() = new internal::raw::CompressedNode<depth_arg, tri>(*nodec->compressed_node());
-							}
-						},
-						[]() { assert(false); });
+			: context_(const_hypertrie.context_), depth_(const_hypertrie.depth_), temporary_context_(const_hypertrie.temporary_context_) {
+			copyNodeContainer(const_hypertrie);
+		}
+
+		const_Hypertrie &operator=(const const_Hypertrie &const_hypertrie) noexcept {
+			if (this != &const_hypertrie) {
+				context_ = const_hypertrie.context_;
+				depth_ = const_hypertrie.depth_;
+				temporary_context_ = const_hypertrie.temporary_context_;
+				copyNodeContainer(const_hypertrie);
 			}
+			return *this;
 		}
 
 		const_Hypertrie() = default;
@@ -107,6 +195,7 @@ namespace hypertrie {
 
 		using Key = typename tr::Key;
 		using SliceKey = typename tr::SliceKey;
+		using key_part_type = typename tr::key_part_type;
 		using value_type = typename tr::value_type;
 
 		[[nodiscard]] size_t size() const{
@@ -132,7 +221,7 @@ namespace hypertrie {
 		[[nodiscard]] value_type operator[](const Key &key) const {
 			return internal::compiled_switch<hypertrie_depth_limit, 1>::switch_(
 					this->depth_,
-					[&](auto depth_arg) mutable -> bool {
+					[&](auto depth_arg) mutable -> value_type {
 						RawKey<depth_arg> raw_key;
 						std::copy_n(key.begin(), depth_arg, raw_key.begin());
 						const auto &node_container = *reinterpret_cast<const internal::raw::NodeContainer<depth_arg, tri> *>(&this->node_container_);
@@ -140,11 +229,57 @@ namespace hypertrie {
 								node_container,
 								raw_key);
 					},
-					[]() -> bool { assert(false); return {}; });
+					[]() -> value_type { assert(false); return {}; });
 		}
 
+		/**
+		 * Looks up the values of many keys. The result is the same as calling operator[] for each key, but the keys are
+		 * resolved in batches so that the memory accesses of different keys overlap (see NodeContext::get_many).
+		 * @param keys the keys
+		 * @return the values of the keys in the order of keys
+		 */
+		[[nodiscard]] std::vector<value_type> get_many(std::span<const Key> keys) const {
+			std::vector<value_type> values(keys.size());
+			lookupMany(keys, [&](size_t i, value_type value) { values[i] = value; });
+			return values;
+		}
 
+		/**
+		 * Checks for many keys if they are contained, i.e. if their value is not zero (see get_many).
+		 * @param keys the keys
+		 * @return for each key if it is contained
+		 */
+		[[nodiscard]] std::vector<bool> contains_many(std::span<const Key> keys) const {
+			std::vector<bool> contained(keys.size());
+			lookupMany(keys, [&](size_t i, value_type value) { contained[i] = value != value_type{}; });
+			return contained;
+		}
+
+	private:
+		template<typename SetValue>
+		void lookupMany(std::span<const Key> keys, SetValue &&set_value) const {
+			if (empty())
+				return;
+			if (contextless()) {
+				for (auto [i, key] : iter::enumerate(keys))
+					set_value(i, this->operator[](key));
+				return;
+			}
+			internal::compiled_switch<hypertrie_depth_limit, 1>::switch_void(
+					this->depth_,
+					[&](auto depth_arg) {
+						std::vector<RawKey<depth_arg>> raw_keys(keys.size());
+						for (auto [i, key] : iter::enumerate(keys)) {
+							assert(key.size() == depth_arg);
+							std::copy_n(key.begin(), depth_arg, raw_keys[i].begin());
+						}
+						const auto &node_container = *reinterpret_cast<const internal::raw::NodeContainer<depth_arg, tri> *>(&this->node_container_);
+						this->context()->rawContext().template get_many<depth_arg>(node_container, raw_keys, set_value);
+					},
+					[]() { assert(false); });
+		}
 
+	public:
 		[[nodiscard]]
 		std::variant<std::optional<const_Hypertrie>, value_type> operator[](const SliceKey &slice_key) const {
 			assert(slice_key.size() == depth());
@@ -165,15 +300,34 @@ namespace hypertrie {
 						  internal::compiled_switch<depth_arg, 1>::switch_void(
 								  slice_key_depth,
 								  [&](auto slice_key_depth_arg) {
+									constexpr size_t result_depth = depth_arg - slice_key_depth_arg;
+									SliceCache<tr> *cache = (not contextless() and this->context()->sliceCache().enabled()) ? &this->context()->sliceCache() : nullptr;
+									if (cache != nullptr)
+										if (auto cached = cache->find(depth_arg, this->node_container_.hash_sized, slice_key); cached.has_value()) {
+											if (auto resolved = fromCachedSlice<result_depth>(*cached); resolved.has_value()) {
+												result = std::move(resolved);
+												return;
+											}
+											// the cached node was deleted. it is sliced again below
+											cache->evictStale(depth_arg, this->node_container_.hash_sized, slice_key);
+										}
+
 									RawSliceKey<slice_key_depth_arg> raw_slice_key(slice_key);
 
 									const auto &node_container = *reinterpret_cast<const internal::raw::NodeContainer<depth_arg, tri> *>(&this->node_container_);
 
-									auto [node_cont, is_managed] = this->context()->rawContext().template slice<depth_arg, slice_key_depth_arg>(node_container, raw_slice_key);
-									if (is_managed)
-										result = const_Hypertrie<tr>(depth_arg - slice_key_depth_arg, this->context(), {node_cont.hash().hash(), node_cont.node()});
-									else
-										result = const_Hypertrie<tr>(depth_arg - slice_key_depth_arg, nullptr, {node_cont.hash().hash(), node_cont.node()});
+									// a compressed result that is not in the node storage is written here instead of to the heap
+									internal::raw::CompressedNode<result_depth, tri> compressed_result;
+									RawEntries<result_depth> scanned_entries;
+									auto [node_cont, is_managed] = this->context()->rawContext().template slice<depth_arg, slice_key_depth_arg>(node_container, raw_slice_key, &compressed_result, &scanned_entries);
+									if (not scanned_entries.empty()) {
+										// a sliced position is not indexed, so the result is not in the node storage. It is not cached.
+										result = temporary<result_depth>(std::move(scanned_entries));
+										return;
+									}
+									if (cache != nullptr)
+										cache->insert(depth_arg, this->node_container_.hash_sized, slice_key, toCachedSlice<result_depth>(node_cont, is_managed));
+									result = fromSlice<result_depth>(node_cont, is_managed);
 								  });
 
 						});
@@ -181,6 +335,121 @@ namespace hypertrie {
 			}
 		}
 
+		/**
+		 * Slices the hypertrie once for each of many key parts at one position, e.g. T[s, p, :] for a set of s. The
+		 * results are the same as calling operator[] with slice_key and the key part at pos, but the fixed key parts are
+		 * resolved only once and the key parts are probed in batches (see NodeContext::slice_many).
+		 * @param slice_key the slice key. The entry at pos is ignored.
+		 * @param pos the position that is sliced with each of the key parts
+		 * @param key_parts the key parts. Duplicates are ignored.
+		 * @return pairs of a key part and its result, sorted by key part. Key parts with an empty result are left out.
+		 */
+		[[nodiscard]]
+		std::vector<std::pair<key_part_type, std::variant<std::optional<const_Hypertrie>, value_type>>>
+		slice_many(SliceKey slice_key, size_t pos, std::vector<key_part_type> key_parts) const {
+			assert(slice_key.size() == depth() and pos < depth());
+			std::vector<std::pair<key_part_type, std::variant<std::optional<const_Hypertrie>, value_type>>> results;
+			if (empty() or key_parts.empty())
+				return results;
+			std::sort(key_parts.begin(), key_parts.end());
+			key_parts.erase(std::unique(key_parts.begin(), key_parts.end()), key_parts.end());
+
+			slice_key[pos] = std::nullopt;
+			const size_t slice_key_depth = tri::sliceKeyDepth(slice_key);
+			if (contextless()) {
+				for (const key_part_type key_part : key_parts) {
+					slice_key[pos] = key_part;
+					auto result = this->operator[](slice_key);
+					if (result.index() == 0 ? std::get<0>(result).has_value() and not std::get<0>(result)->empty() : std::get<1>(result) != value_type{})
+						results.emplace_back(key_part, std::move(result));
+				}
+				return results;
+			}
+			internal::compiled_switch<hypertrie_depth_limit, 1>::switch_void(
+					this->depth_,
+					[&](auto depth_arg) {
+						internal::compiled_switch<depth_arg, 0>::switch_void(
+								slice_key_depth,
+								[&](auto slice_key_depth_arg) {
+									constexpr size_t result_depth = depth_arg - slice_key_depth_arg - 1;
+									RawSliceKey<slice_key_depth_arg> raw_slice_key(slice_key);
+									const auto &node_container = *reinterpret_cast<const internal::raw::NodeContainer<depth_arg, tri> *>(&this->node_container_);
+									this->context()->rawContext().template slice_many<depth_arg, slice_key_depth_arg>(
+											node_container, raw_slice_key, pos, key_parts,
+											[&](key_part_type key_part, auto &&sliced) {
+												if constexpr (result_depth == 0)
+													results.emplace_back(key_part, sliced);
+												else if constexpr (std::is_same_v<std::decay_t<decltype(sliced)>, RawEntries<result_depth>>)
+													results.emplace_back(key_part, std::optional<const_Hypertrie>{temporary<result_depth>(std::move(sliced))});
+												else
+													results.emplace_back(key_part, std::optional<const_Hypertrie>{fromSlice<result_depth>(sliced.first, sliced.second)});
+											});
+								});
+					});
+			return results;
+		}
+
+	private:
+		/**
+		 * Creates the result of a slice from the node container that NodeContext::slice returned.
+		 */
+		template<size_t result_depth>
+		const_Hypertrie fromSlice(const internal::raw::NodeContainer<result_depth, tri> &nodec, bool is_managed) const {
+			if (is_managed)
+				return sameContext(result_depth, {nodec.hash().hash(), nodec.node()});
+			if constexpr (not(result_depth == 1 and tri::is_bool_valued and tri::is_lsb_unused))
+				if (nodec.node() != nullptr)
+					return contextlessCompressed<result_depth>(nodec.hash().hash(), *nodec.compressed_node());
+			return const_Hypertrie(result_depth, nullptr, {nodec.hash().hash(), nullptr});
+		}
+
+	private:
+		template<size_t result_depth>
+		static typename SliceCache<tr>::Result toCachedSlice(const internal::raw::NodeContainer<result_depth, tri> &nodec, bool is_managed) {
+			typename SliceCache<tr>::Result cached{nodec.hash().hash(), is_managed};
+			if constexpr (not(result_depth == 1 and tri::is_bool_valued and tri::is_lsb_unused))
+				if (not is_managed and not nodec.empty()) {
+					const auto *node = nodec.compressed_node();
+					std::copy(node->key().begin(), node->key().end(), cached.key.begin());
+					cached.value = node->value();
+				}
+			return cached;
+		}
+
+		/**
+		 * Creates the result of a slice from a cached result. Nodes in the node storage are resolved by their hash,
+		 * compressed results that are not in the node storage are copied.
+		 * @return the result or std::nullopt if the cached node is not in the node storage anymore
+		 */
+		template<size_t result_depth>
+		std::optional<const_Hypertrie> fromCachedSlice(const typename SliceCache<tr>::Result &cached) const {
+			if (cached.hash.empty())
+				return const_Hypertrie(result_depth, nullptr, {});
+			auto &storage = this->context()->rawContext().storage;
+			if constexpr (result_depth == 1 and tri::is_bool_valued and tri::is_lsb_unused) {
+				// the key part of a compressed node is stored in the hash
+				if (internal::raw::TaggedTensorHash<tri>(cached.hash).isCompressed())
+					return const_Hypertrie(result_depth, cached.managed ? this->context() : nullptr, {cached.hash, nullptr});
+				auto *node = storage.template getUncompressedNode<result_depth>(cached.hash).node();
+				if (node == nullptr)
+					return std::nullopt;
+				return sameContext(result_depth, {cached.hash, node});
+			} else {
+				if (cached.managed) {
+					auto *node = storage.template getNode<result_depth>(cached.hash).node();
+					if (node == nullptr)
+						return std::nullopt;
+					return sameContext(result_depth, {cached.hash, node});
+				}
+				internal::raw::CompressedNode<result_depth, tri> node;
+				std::copy_n(cached.key.begin(), result_depth, node.key().begin());
+				if constexpr (not tri::is_bool_valued)
+					node.value() = cached.value;
+				return contextlessCompressed<result_depth>(cached.hash, node);
+			}
+		}
+
+	public:
 		[[nodiscard]]
 		std::vector<size_t> getCards(const std::vector<pos_type> &positions) const {
 			assert(positions.size() <= depth());
@@ -197,7 +466,7 @@ namespace hypertrie {
 						this->depth_,
 						[&](auto depth_arg) -> std::vector<size_t> {
 							const auto &node_container = *reinterpret_cast<const internal::raw::UncompressedNodeContainer<depth_arg, tri> *>(&this->node_container_);
-							return node_container.uncompressed_node()->getCards(positions);
+							return this->context()->rawContext().template getCards<depth_arg>(node_container, positions);
 						},
 						[&]() ->std::vector<size_t> {
 							assert(false); return {};
@@ -271,6 +540,32 @@ namespace hypertrie {
 					[]() -> value_type { assert(false); return {}; });
 		}
 
+		/**
+		 * Sets the values of many keys in one modification. It behaves like calling set for each entry in order,
+		 * but nodes that are affected by multiple entries are rewritten once per batch instead of once per key.
+		 * @tparam Entries range of std::pair<Key, value_type>
+		 * @param entries keys and their new values. A value of zero (false) removes the key. If a key occurs multiple times, the last value wins.
+		 */
+		template<typename Entries>
+		void set_many(const Entries &entries) {
+			internal::compiled_switch<hypertrie_depth_limit, 1>::switch_void(
+					this->depth_,
+					[&](auto depth_arg) {
+						std::vector<std::pair<RawKey<depth_arg>, value_type>> raw_entries;
+						if constexpr (requires { std::size(entries); })
+							raw_entries.reserve(std::size(entries));
+						for (const auto &[key, value] : entries) {
+							assert(key.size() == depth_arg);
+							auto &[raw_key, raw_value] = raw_entries.emplace_back();
+							std::copy_n(key.begin(), depth_arg, raw_key.begin());
+							raw_value = value;
+						}
+						auto &node_container = *reinterpret_cast<internal::raw::NodeContainer<depth_arg, tri> *>(&this->node_container_);
+						this->context_->rawContext().template bulk_set<depth_arg>(node_container, std::move(raw_entries));
+					},
+					[]() { assert(false); });
+		}
+
 		Hypertrie(const Hypertrie<tr> &hypertrie) : const_Hypertrie<tr>(hypertrie) {
 			if (not this->empty())
 				internal::compiled_switch<hypertrie_depth_limit, 1>::switch_void(
@@ -313,6 +608,96 @@ namespace hypertrie {
 
 		Hypertrie(size_t depth = 1, HypertrieContext<tr> &context = DefaultHypertrieContext<tr>::instance())
 			: const_Hypertrie<tr>(depth, &context) {}
+
+		/**
+		 * Writes this hypertrie to a snapshot file. See HypertrieContext::save.
+		 * @param path file to be written
+		 */
+		void save(const std::filesystem::path &path) const {
+			this->context_->save(path, {*this});
+		}
+
+		/**
+		 * Loads a hypertrie from a snapshot file that contains exactly one hypertrie. See HypertrieContext::load.
+		 * @param path snapshot file
+		 * @param context context to load the hypertrie into
+		 * @return the loaded hypertrie
+		 */
+		static Hypertrie load(const std::filesystem::path &path, HypertrieContext<tr> &context = DefaultHypertrieContext<tr>::instance()) {
+			auto hypertries = context.load(path);
+			if (hypertries.size() != 1)
+				throw std::runtime_error{fmt::format("Snapshot {} contains {} hypertries, expected 1.", path.string(), hypertries.size())};
+			return std::move(hypertries.front());
+		}
+
+		/**
+		 * Pins the current version of this hypertrie. See HypertrieSnapshot.
+		 * @return snapshot of the current version
+		 */
+		HypertrieSnapshot<tr> snapshot() const {
+			return HypertrieSnapshot<tr>(*this);
+		}
+
+	private:
+		/**
+		 * Takes over a reference to a root node that was already counted for it.
+		 */
+		Hypertrie(size_t depth, HypertrieContext<tr> *context, internal::raw::RawNodeContainer node_container)
+			: const_Hypertrie<tr>(depth, context, node_container) {}
+
+		friend class HypertrieContext<tr>;
+	};
+
+	/**
+	 * A read-only version of a hypertrie. Taking a snapshot is O(1): it counts one more reference to the root node.
+	 * Nodes that are referenced more than once are never changed in place, so later modifications of the hypertrie
+	 * create new nodes and the snapshot keeps seeing the version it was taken of. Nodes are shared with the hypertrie
+	 * as long as they are not modified.
+	 *
+	 * Slices of a snapshot are valid as long as the snapshot lives. A snapshot may be read by other threads while the
+	 * hypertrie is modified if they hold HypertrieContext::readGuard(): lookups, slices, cardinalities and iteration never
+	 * modify nodes. Taking and destructing snapshots are modifications of the context and must be done by the writing thread.
+	 */
+	template<HypertrieTrait tr>
+	class HypertrieSnapshot : public const_Hypertrie<tr> {
+	public:
+		using tri = internal::raw::Hypertrie_internal_t<tr>;
+
+		explicit HypertrieSnapshot(const Hypertrie<tr> &hypertrie) : const_Hypertrie<tr>(hypertrie) {
+			pin();
+		}
+
+		HypertrieSnapshot(const HypertrieSnapshot &snapshot) : const_Hypertrie<tr>(snapshot) {
+			pin();
+		}
+
+		HypertrieSnapshot(HypertrieSnapshot &&snapshot) noexcept : const_Hypertrie<tr>(snapshot) {
+			snapshot.node_container_ = {};
+		}
+
+		HypertrieSnapshot &operator=(const HypertrieSnapshot &) = delete;
+		HypertrieSnapshot &operator=(HypertrieSnapshot &&) = delete;
+
+		~HypertrieSnapshot() {
+			if (not this->empty())
+				internal::compiled_switch<hypertrie_depth_limit, 1>::switch_void(
+						this->depth_,
+						[&](auto depth_arg) {
+							auto &typed_nodec = *reinterpret_cast<internal::raw::NodeContainer<depth_arg, tri> *>(&this->node_container_);
+							this->context_->rawContext().template decrRefCount<depth_arg>(typed_nodec);
+						});
+		}
+
+	private:
+		void pin() {
+			if (not this->empty())
+				internal::compiled_switch<hypertrie_depth_limit, 1>::switch_void(
+						this->depth_,
+						[&](auto depth_arg) {
+							auto &typed_nodec = *reinterpret_cast<internal::raw::NodeContainer<depth_arg, tri> *>(&this->node_container_);
+							this->context_->rawContext().template incRefCount<depth_arg>(typed_nodec);
+						});
+		}
 	};
 
 }
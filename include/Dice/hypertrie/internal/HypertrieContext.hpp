@@ -3,10 +3,20 @@
 
 
 #include "Dice/hypertrie/internal/ConfigHypertrieDepthLimit.hpp"
+#include "Dice/hypertrie/internal/Hypertrie_predeclare.hpp"
+#include "Dice/hypertrie/internal/SliceCache.hpp"
+#include "Dice/hypertrie/internal/raw/iterator/Iterator.hpp"
 #include "Dice/hypertrie/internal/raw/storage/NodeContext.hpp"
+#include "Dice/hypertrie/internal/raw/storage/NodeStorageSnapshot.hpp"
 #include "Dice/hypertrie/internal/util/SwitchTemplateFunctions.hpp"
 #include <fmt/format.h>
+#include <algorithm>
+#include <bitset>
+#include <filesystem>
+#include <fstream>
 #include <memory>
+#include <stdexcept>
+#include <vector>
 
 
 namespace hypertrie {
@@ -16,11 +26,16 @@ namespace hypertrie {
 	private:
 		static constexpr const size_t depth_ = hypertrie_depth_limit -1;
 	public:
-		using NodeContext = typename internal::raw::template NodeContext<depth_, typename internal::raw::template Hypertrie_internal_t<tr>>;
+		using tri = typename internal::raw::template Hypertrie_internal_t<tr>;
+		using NodeContext = typename internal::raw::template NodeContext<depth_, tri>;
+		using Snapshot = internal::raw::NodeStorageSnapshot<depth_, tri>;
 
 	public:
 		NodeContext raw_context{};
 
+	private:
+		SliceCache<tr> slice_cache_{};
+
 	public:
 
 		HypertrieContext(){}
@@ -31,6 +46,198 @@ namespace hypertrie {
 		NodeContext &rawContext() {
 			return raw_context;
 		}
+
+		/**
+		 * Reports the memory used by the nodes of this context per depth and compression.
+		 * The node storage keeps running sums per depth, so the cost does not depend on the number of nodes and it can be
+		 * sampled regularly.
+		 */
+		internal::raw::MemoryStats memoryStats() const {
+			return raw_context.storage.memoryStats();
+		}
+
+		/**
+		 * Like memoryStats, but every node is visited. The cost is linear in the number of nodes.
+		 */
+		internal::raw::MemoryStats exactMemoryStats() const {
+			return raw_context.storage.exactMemoryStats();
+		}
+
+		/**
+		 * Starts a read that may run concurrently with a single writer thread that modifies hypertries of this context.
+		 * Nodes that the writer deletes while the guard is alive are freed after the guard is destructed, so readers never
+		 * access freed memory. Nevertheless, the reader must only read hypertries that the writer does not modify or destruct
+		 * meanwhile: deleted nodes cannot be looked up anymore and nodes without other references are changed in place.
+		 * Copying or destructing Hypertrie objects and indexing positions (see setIndexedPositions) are modifications and must be
+		 * done by the writer. Reads never modify nodes.
+		 * @return guard that ends the read when it is destructed
+		 */
+		[[nodiscard]] internal::util::EpochManager::Guard readGuard() noexcept {
+			return raw_context.storage.pin();
+		}
+
+		/**
+		 * Sets which positions are indexed in uncompressed nodes of the given depth. The missing indexes of existing nodes at
+		 * these positions are built, so it is a modification and must be done by the writer.
+		 * Reads never build indexes: cardinalities, slices and diagonals of positions that are not indexed are resolved by a
+		 * scan through position 0. Such slices and diagonals are collected into temporary hypertries (see const_Hypertrie::temporary).
+		 * @param depth depth of the nodes. Must be at least 2.
+		 * @param positions positions to be indexed. Position 0 is always indexed.
+		 */
+		void setIndexedPositions(size_t depth, const std::vector<pos_type> &positions) {
+			internal::compiled_switch<depth_ + 1, 2>::switch_void(
+					depth,
+					[&](auto depth_arg) {
+						std::bitset<depth_arg> indexed_positions{};
+						for (const auto pos : positions) {
+							assert(pos < depth_arg);
+							indexed_positions.set(pos);
+						}
+						raw_context.template indexPositions<depth_arg>(indexed_positions);
+					},
+					[]() { throw std::logic_error{"indexed positions can only be set for depths from 2 to the depth limit."}; });
+		}
+
+		/**
+		 * Sets the number of threads that apply a modification. New uncompressed nodes of the same depth are populated
+		 * in parallel if there are enough of them, e.g. when many keys are bulk inserted. The calling thread takes part.
+		 * The other threads are started here and are reused by all modifications until the context is destructed.
+		 * @param threads number of threads. 1 (the default) applies modifications serially.
+		 */
+		void setModificationThreads(size_t threads) {
+			raw_context.storage.modificationThreads(threads);
+		}
+
+		/**
+		 * Nodes are identified by their 64 bit TensorHash only. With verification enabled, a modification that results in a
+		 * node that exists already checks its size and a few of its entries before the node is shared. A mismatch is a hash
+		 * collision and raises a std::runtime_error instead of silently merging two different sub-tensors. All nodes of a
+		 * modification are verified before the first node is changed, so the context is unchanged after a collision.
+		 * Bulk insertions into empty hypertries are then planned level by level instead of being built depth first.
+		 * @param verify true enables the verification. It is disabled by default.
+		 */
+		void setHashVerification(bool verify) {
+			raw_context.storage.verifyHashes(verify);
+		}
+
+		/**
+		 * Enables caching the results of slicing hypertries of this context (see SliceCache). Repeated slices of an
+		 * unchanged hypertrie are answered without traversing it again.
+		 * @param capacity maximal number of cached slice results. 0 (the default) disables the cache.
+		 */
+		void setSliceCacheCapacity(size_t capacity) {
+			slice_cache_.capacity(capacity);
+		}
+
+		/**
+		 * Hits, misses and size of the slice cache.
+		 */
+		typename SliceCache<tr>::Stats sliceCacheStats() const {
+			return slice_cache_.stats();
+		}
+
+		SliceCache<tr> &sliceCache() noexcept {
+			return slice_cache_;
+		}
+
+		/**
+		 * Writes the given hypertries to a snapshot file. Nodes that are shared by the hypertries are written once.
+		 * @param path file to be written
+		 * @param hypertries hypertries of this context
+		 */
+		void save(const std::filesystem::path &path, const std::vector<const_Hypertrie<tr>> &hypertries) {
+			std::vector<internal::raw::SnapshotRoot> roots;
+			roots.reserve(hypertries.size());
+			for (const auto &hypertrie : hypertries) {
+				if (hypertrie.context() != this)
+					throw std::logic_error{"Only hypertries of this context can be saved."};
+				roots.push_back({hypertrie.depth(), hypertrie.rawNodeContainer()->hash_sized});
+			}
+			std::ofstream out(path, std::ios::binary | std::ios::trunc);
+			if (not out)
+				throw std::runtime_error{fmt::format("Cannot open {} for writing.", path.string())};
+			Snapshot::save(raw_context.storage, roots, out);
+		}
+
+		/**
+		 * Loads the hypertries of a snapshot file into this context. Nodes that are already contained in this context are shared.
+		 * If the snapshot was written by a process with a different entry hash function, the entries of each hypertrie are
+		 * collected and inserted in bulk.
+		 * @param path snapshot file written by save()
+		 * @return the hypertries in the order they were saved
+		 * @throws std::runtime_error if the file is not a snapshot or was written with different traits
+		 */
+		std::vector<Hypertrie<tr>> load(const std::filesystem::path &path) {
+			std::ifstream in(path, std::ios::binary);
+			if (not in)
+				throw std::runtime_error{fmt::format("Cannot open {} for reading.", path.string())};
+			const auto header = Snapshot::readHeader(in);
+			std::vector<Hypertrie<tr>> hypertries;
+			if (header.hash_fingerprint == Snapshot::hashFingerprint()) {
+				const auto roots = Snapshot::load(raw_context.storage, header, in);
+				hypertries.reserve(roots.size());
+				for (const auto &root : roots)
+					hypertries.push_back(adoptRoot(root));
+			} else {
+				// the stored hashes are not valid in this process. They are only used to resolve the nodes in a temporary context.
+				HypertrieContext<tr> snapshot_context{};
+				const auto roots = Snapshot::load(snapshot_context.raw_context.storage, header, in);
+				std::vector<Hypertrie<tr>> snapshot_hypertries;
+				snapshot_hypertries.reserve(roots.size());
+				for (const auto &root : roots)
+					snapshot_hypertries.push_back(snapshot_context.adoptRoot(root));
+				hypertries.reserve(roots.size());
+				for (const auto &snapshot_hypertrie : snapshot_hypertries) {
+					auto &hypertrie = hypertries.emplace_back(snapshot_hypertrie.depth(), *this);
+					internal::compiled_switch<depth_ + 1, 1>::switch_void(
+							snapshot_hypertrie.depth(),
+							[&](auto depth_arg) {
+								auto nodec = *reinterpret_cast<const internal::raw::NodeContainer<depth_arg, tri> *>(snapshot_hypertrie.rawNodeContainer());
+								auto &typed_nodec = *reinterpret_cast<internal::raw::NodeContainer<depth_arg, tri> *>(&hypertrie.node_container_);
+								using RawKey = typename tri::template RawKey<depth_arg>;
+								const auto raw_key = [](const auto &key) {
+									RawKey raw{};
+									std::copy_n(key.begin(), raw.size(), raw.begin());
+									return raw;
+								};
+								if constexpr (tri::is_bool_valued) {
+									std::vector<RawKey> keys;
+									keys.reserve(snapshot_hypertrie.size());
+									for (auto iter = internal::raw::iterator<depth_arg, tri>(nodec, snapshot_context.raw_context); iter; ++iter)
+										keys.push_back(raw_key(*iter));
+									raw_context.template bulk_insert<depth_arg>(typed_nodec, std::move(keys));
+								} else {
+									std::vector<std::pair<RawKey, typename tri::value_type>> entries;
+									entries.reserve(snapshot_hypertrie.size());
+									for (auto iter = internal::raw::iterator<depth_arg, tri>(nodec, snapshot_context.raw_context); iter; ++iter)
+										entries.emplace_back(raw_key((*iter).first), (*iter).second);
+									raw_context.template bulk_set<depth_arg>(typed_nodec, std::move(entries));
+								}
+							},
+							[]() { assert(false); });
+				}
+			}
+			return hypertries;
+		}
+
+	private:
+		/**
+		 * Wraps a loaded root into a Hypertrie that takes over the reference counted for it by the snapshot.
+		 */
+		Hypertrie<tr> adoptRoot(const internal::raw::SnapshotRoot &root) {
+			if (root.hash.empty())
+				return Hypertrie<tr>(root.depth, *this);
+			void *node = internal::compiled_switch<depth_ + 1, 1>::switch_(
+					root.depth,
+					[&](auto depth_arg) -> void * {
+						if constexpr (depth_arg == 1 and tri::is_lsb_unused and tri::is_bool_valued)
+							if (root.hash.isCompressed())
+								return nullptr;// the key part is stored in the hash
+						return raw_context.storage.template getNode<depth_arg>(root.hash).node();
+					},
+					[]() -> void * { assert(false); return nullptr; });
+			return Hypertrie<tr>(root.depth, this, {root.hash, node});
+		}
 	};
 
 	template<HypertrieTrait tr>
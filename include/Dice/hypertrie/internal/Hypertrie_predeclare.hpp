@@ -11,6 +11,9 @@ namespace hypertrie {
 	template<HypertrieTrait tr = default_bool_Hypertrie_t>
 	class Hypertrie;
 
+	template<HypertrieTrait tr = default_bool_Hypertrie_t>
+	class HypertrieSnapshot;
+
 }
 
 
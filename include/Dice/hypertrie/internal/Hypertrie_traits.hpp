@@ -13,7 +13,8 @@ namespace hypertrie {
 			 typename value_type_t = bool,
 			 template<typename, typename> class map_type_t = hypertrie::internal::container::tsl_sparse_map,
 			 template<typename> class set_type_t = hypertrie::internal::container::tsl_sparse_set,
-			 bool lsb_unused_v = false>
+			 bool lsb_unused_v = false,
+			 bool swizzled_edges_v = false>
 	struct Hypertrie_t {
 		using key_part_type = key_part_type_t;
 		using value_type = value_type_t;
@@ -27,6 +28,11 @@ namespace hypertrie {
 
 		static constexpr const bool is_bool_valued = std::is_same_v<value_type, bool>;
 		static constexpr const bool lsb_unused = lsb_unused_v;
+		/**
+		 * If true, edges of uncompressed nodes cache the pointer to their child node next to its hash.
+		 * Resolving a cached child does not need a lookup in the node storage. Costs two additional words per edge.
+		 */
+		static constexpr const bool swizzled_edges = swizzled_edges_v;
 
 		using IteratorEntry = std::conditional_t<(is_bool_valued), Key, std::pair<Key, value_type>>;
 
@@ -37,7 +43,7 @@ namespace hypertrie {
 					return entry.first;
 			}
 
-			template<typename = std::enable_if_t<(is_bool_valued)>>
+			template<bool valued = not is_bool_valued, typename = std::enable_if_t<(valued)>>
 			static value_type &value(IteratorEntry &entry) noexcept { return entry.second; }
 		};
 
@@ -49,6 +55,7 @@ namespace hypertrie {
 									  typename,
 									  template<typename, typename> class,
 									  template<typename> class,
+									  bool,
 									  bool>
 							 typename U>
 		struct is_instance_impl : public std::false_type {
@@ -58,20 +65,23 @@ namespace hypertrie {
 						  typename,
 						  template<typename, typename> class,
 						  template<typename> class,
+						  bool,
 						  bool>
 				 typename U,
 				 typename key_part_type_t,
 				 typename value_type_t,
 				 template<typename, typename> class map_type_t,
 				 template<typename> class set_type_t,
-				bool lsb_unused_v>
-		struct is_instance_impl<U<key_part_type_t, value_type_t, map_type_t, set_type_t, lsb_unused_v>, U> : public std::true_type {
+				 bool lsb_unused_v,
+				 bool swizzled_edges_v>
+		struct is_instance_impl<U<key_part_type_t, value_type_t, map_type_t, set_type_t, lsb_unused_v, swizzled_edges_v>, U> : public std::true_type {
 		};
 
 		template<typename T, template<typename,
 									  typename,
 									  template<typename, typename> class,
 									  template<typename> class,
+									  bool,
 									  bool>
 							 typename U>
 		using is_instance = is_instance_impl<std::decay_t<T>, U>;
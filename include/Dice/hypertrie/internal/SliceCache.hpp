@@ -0,0 +1,247 @@
+#ifndef HYPERTRIE_SLICECACHE_HPP
+#define HYPERTRIE_SLICECACHE_HPP
+
+#include "Dice/hypertrie/internal/ConfigHypertrieDepthLimit.hpp"
+#include "Dice/hypertrie/internal/Hypertrie_traits.hpp"
+#include "Dice/hypertrie/internal/raw/node/TensorHash.hpp"
+
+#include <absl/hash/hash.h>
+#include <robin_hood.h>
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace hypertrie {
+
+	/**
+	 * Bounded cache of slice results. An entry is identified by the TensorHash of the sliced node and the slice key.
+	 * Nodes with the same hash hold the same entries, so a cached result stays valid as long as a node with that hash
+	 * is sliced. A modified hypertrie has a different hash and misses the cache, so entries are never invalidated
+	 * explicitly. Instead, the oldest entries are evicted when the capacity is exceeded.
+	 *
+	 * Results in the node storage are cached by their hash only and resolved again on a hit, because a node may be
+	 * deleted and rebuilt at another address with the same hash. If it is not in the node storage anymore, the entry is
+	 * stale and is dropped with evictStale. Compressed results that are not in the node storage are cached by their entry.
+	 *
+	 * The cache is split into shards with a lock each, so readers that slice concurrently rarely wait for each other
+	 * (see HypertrieContext::readGuard). Keys and results are stored inline, so lookups do not allocate.
+	 * @tparam tr_t hypertrie traits
+	 */
+	template<HypertrieTrait tr_t>
+	class SliceCache {
+	public:
+		using tr = tr_t;
+		using key_part_type = typename tr::key_part_type;
+		using value_type = typename tr::value_type;
+		using SliceKey = typename tr::SliceKey;
+		using TensorHash = internal::raw::TensorHash;
+
+		/**
+		 * A cached slice result. An empty hash stands for an empty result.
+		 */
+		struct Result {
+			TensorHash hash{};
+			/**
+			 * If the result is a node in the node storage. Otherwise, it is a compressed node that consists of key and value.
+			 */
+			bool managed = false;
+			/**
+			 * Key of a compressed result that is not in the node storage. Only the first result depth key parts are used.
+			 */
+			std::array<key_part_type, hypertrie_depth_limit> key{};
+			value_type value{};
+		};
+
+		struct Stats {
+			size_t hits = 0;
+			size_t misses = 0;
+			size_t size = 0;
+			size_t capacity = 0;
+
+			[[nodiscard]] double hitRate() const noexcept {
+				return (hits + misses == 0) ? 0.0 : double(hits) / double(hits + misses);
+			}
+		};
+
+	private:
+		static_assert(hypertrie_depth_limit <= 8, "The fixed positions of a slice key are stored in a byte.");
+
+		/**
+		 * Number of shards. Each shard holds about 1/SHARDS of the capacity.
+		 */
+		static constexpr const size_t SHARDS = 16;
+
+		struct CacheKey {
+			TensorHash hash{};
+			/**
+			 * Key parts of the slice key. Positions that are not fixed hold zero.
+			 */
+			std::array<key_part_type, hypertrie_depth_limit> key_parts{};
+			std::uint8_t depth = 0;
+			/**
+			 * Bit i is set if position i of the slice key is fixed.
+			 */
+			std::uint8_t fixed = 0;
+
+			CacheKey() = default;
+
+			CacheKey(size_t depth, const TensorHash &hash, const SliceKey &slice_key) noexcept
+				: hash(hash), depth(std::uint8_t(depth)) {
+				assert(slice_key.size() <= hypertrie_depth_limit);
+				for (size_t pos = 0; pos < slice_key.size(); ++pos)
+					if (slice_key[pos].has_value()) {
+						key_parts[pos] = *slice_key[pos];
+						fixed |= std::uint8_t(1U << pos);
+					}
+			}
+
+			bool operator==(const CacheKey &other) const noexcept {
+				return hash == other.hash and depth == other.depth and fixed == other.fixed and key_parts == other.key_parts;
+			}
+
+			template<typename H>
+			friend H AbslHashValue(H h, const CacheKey &key) {
+				return H::combine(std::move(h), key.hash, key.depth, key.fixed, key.key_parts);
+			}
+		};
+
+		struct Entry {
+			Result result;
+			/**
+			 * Slot of the key in the ring of the shard.
+			 */
+			size_t slot;
+		};
+
+		struct Shard {
+			std::mutex mutex;
+			robin_hood::unordered_flat_map<CacheKey, Entry, absl::Hash<CacheKey>> entries{};
+			/**
+			 * Keys in the order they were inserted. When the ring is full, the next slot holds the oldest key, which is
+			 * evicted. A slot whose key was evicted as stale is skipped.
+			 */
+			std::vector<CacheKey> ring{};
+			size_t next_slot = 0;
+			size_t capacity = 0;
+			size_t hits = 0;
+			size_t misses = 0;
+		};
+
+		mutable std::array<Shard, SHARDS> shards_{};
+		std::atomic<size_t> capacity_ = 0;
+
+		static Shard &shardOf(std::array<Shard, SHARDS> &shards, const CacheKey &key) noexcept {
+			return shards[absl::Hash<CacheKey>{}(key) % SHARDS];
+		}
+
+	public:
+		/**
+		 * The cache is disabled if its capacity is 0.
+		 */
+		[[nodiscard]] bool enabled() const noexcept { return capacity_.load(std::memory_order_relaxed) != 0; }
+
+		/**
+		 * Sets the maximal number of cached results and drops all entries. 0 disables the cache.
+		 */
+		void capacity(size_t capacity) {
+			capacity_.store(capacity, std::memory_order_relaxed);
+			for (size_t i = 0; i < SHARDS; ++i) {
+				Shard &shard = shards_[i];
+				std::lock_guard lock{shard.mutex};
+				shard.capacity = capacity / SHARDS + size_t(i < capacity % SHARDS);
+				shard.entries.clear();
+				shard.ring.clear();
+				shard.ring.shrink_to_fit();
+				shard.next_slot = 0;
+			}
+		}
+
+		/**
+		 * Looks up the result of slicing the node with the given hash.
+		 * @param depth depth of the sliced node
+		 * @param hash hash of the sliced node
+		 * @param slice_key the slice key
+		 * @return the cached result or std::nullopt if there is none
+		 */
+		std::optional<Result> find(size_t depth, const TensorHash &hash, const SliceKey &slice_key) {
+			const CacheKey key{depth, hash, slice_key};
+			Shard &shard = shardOf(shards_, key);
+			std::lock_guard lock{shard.mutex};
+			if (auto found = shard.entries.find(key); found != shard.entries.end()) {
+				++shard.hits;
+				return found->second.result;
+			} else {
+				++shard.misses;
+				return std::nullopt;
+			}
+		}
+
+		/**
+		 * Caches the result of slicing the node with the given hash. If the shard of the entry is full, its oldest entry is evicted.
+		 */
+		void insert(size_t depth, const TensorHash &hash, const SliceKey &slice_key, const Result &result) {
+			const CacheKey key{depth, hash, slice_key};
+			Shard &shard = shardOf(shards_, key);
+			std::lock_guard lock{shard.mutex};
+			if (shard.capacity == 0 or shard.entries.count(key) != 0)
+				return;
+			size_t slot = shard.next_slot;
+			if (shard.ring.size() < shard.capacity) {
+				slot = shard.ring.size();
+				shard.ring.push_back(key);
+			} else {
+				const CacheKey &oldest = shard.ring[slot];
+				if (auto found = shard.entries.find(oldest); found != shard.entries.end() and found->second.slot == slot)
+					shard.entries.erase(found);
+				shard.ring[slot] = key;
+				shard.next_slot = (slot + 1) % shard.capacity;
+			}
+			shard.entries.emplace(key, Entry{result, slot});
+		}
+
+		/**
+		 * Removes an entry that find returned but that refers to a node which is not in the node storage anymore.
+		 * The lookup is counted as a miss instead of a hit.
+		 */
+		void evictStale(size_t depth, const TensorHash &hash, const SliceKey &slice_key) {
+			const CacheKey key{depth, hash, slice_key};
+			Shard &shard = shardOf(shards_, key);
+			std::lock_guard lock{shard.mutex};
+			if (shard.entries.erase(key) != 0 and shard.hits != 0) {
+				--shard.hits;
+				++shard.misses;
+			}
+		}
+
+		/**
+		 * Removes all entries. The counters are kept.
+		 */
+		void clear() {
+			for (Shard &shard : shards_) {
+				std::lock_guard lock{shard.mutex};
+				shard.entries.clear();
+				shard.ring.clear();
+				shard.next_slot = 0;
+			}
+		}
+
+		[[nodiscard]] Stats stats() const {
+			Stats stats{};
+			stats.capacity = capacity_.load(std::memory_order_relaxed);
+			for (Shard &shard : shards_) {
+				std::lock_guard lock{shard.mutex};
+				stats.hits += shard.hits;
+				stats.misses += shard.misses;
+				stats.size += shard.entries.size();
+			}
+			return stats;
+		}
+	};
+}// namespace hypertrie
+
+#endif//HYPERTRIE_SLICECACHE_HPP
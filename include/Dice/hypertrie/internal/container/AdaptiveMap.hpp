@@ -0,0 +1,417 @@
+#ifndef HYPERTRIE_ADAPTIVEMAP_HPP
+#define HYPERTRIE_ADAPTIVEMAP_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "Dice/hypertrie/internal/container/ContainerMemory.hpp"
+#include "Dice/hypertrie/internal/container/KeyPositionIndex.hpp"
+#include "Dice/hypertrie/internal/container/SmallKeySearch.hpp"
+
+namespace hypertrie::internal::container {
+
+	/**
+	 * Default number of entries up to which adaptive_map and adaptive_set store their entries inline.
+	 */
+	static constexpr const std::size_t adaptive_container_threshold = 4;
+
+	/**
+	 * A map for few entries. Up to threshold entries are stored inline in an array. It is sorted unless the entries were moved
+	 * back by erase(iterator). The keys are searched with SIMD compares.
+	 * Above threshold, the entries are moved to heap-allocated vectors with an index of the key positions (see KeyPositionIndex).
+	 * Erasing moves them back once the size drops to threshold / 2.
+	 *
+	 * Keys and values are stored in separate arrays. Dereferencing an iterator returns a proxy with the members first and second.
+	 * Like std::vector, inserting or erasing invalidates iterators.
+	 * @tparam Key key type
+	 * @tparam T mapped type
+	 * @tparam threshold maximal number of inline entries
+	 */
+	template<typename Key, typename T, std::size_t threshold = adaptive_container_threshold>
+	class adaptive_map_t {
+		static_assert(threshold > 0);
+
+	public:
+		using key_type = Key;
+		using mapped_type = T;
+		using value_type = std::pair<Key, T>;
+		using size_type = std::size_t;
+
+	private:
+		static constexpr size_type inline_capacity = paddedCapacity<Key>(threshold);
+
+		struct Inline {
+			Key keys[inline_capacity]{};
+			T values[inline_capacity]{};
+		};
+
+		struct Large {
+			std::vector<Key> keys;
+			std::vector<T> values;
+			KeyPositionIndex<Key> index{keys};
+
+			Large() = default;
+
+			Large(std::vector<Key> keys, std::vector<T> values) : keys(std::move(keys)), values(std::move(values)) {}
+
+			Large(const Large &other) : keys(other.keys), values(other.values) {}
+		};
+
+		size_type size_ = 0;
+		/**
+		 * The entries are stored inline up to threshold entries and in a Large above.
+		 */
+		std::variant<Inline, std::unique_ptr<Large>> storage_{};
+
+		[[nodiscard]] Large *large() const noexcept {
+			const auto *large = std::get_if<std::unique_ptr<Large>>(&storage_);
+			return (large != nullptr) ? large->get() : nullptr;
+		}
+
+		[[nodiscard]] Inline &inlined() noexcept { return std::get<Inline>(storage_); }
+
+		[[nodiscard]] const Inline &inlined() const noexcept { return std::get<Inline>(storage_); }
+
+		[[nodiscard]] const Key *keyData() const noexcept {
+			if (Large *large = this->large())
+				return large->keys.data();
+			return inlined().keys;
+		}
+
+		[[nodiscard]] T *valueData() noexcept {
+			if (Large *large = this->large())
+				return large->values.data();
+			return inlined().values;
+		}
+
+		[[nodiscard]] const T *valueData() const noexcept {
+			if (Large *large = this->large())
+				return large->values.data();
+			return inlined().values;
+		}
+
+		[[nodiscard]] size_type findPos(const Key &key) const noexcept {
+			if (Large *large = this->large())
+				return large->index.find(key, size_);
+			return findSmallKey(inlined().keys, size_, key);
+		}
+
+		void toLarge() {
+			Inline &inlined = this->inlined();
+			auto large = std::make_unique<Large>(std::vector<Key>(std::make_move_iterator(inlined.keys), std::make_move_iterator(inlined.keys + size_)),
+												 std::vector<T>(std::make_move_iterator(inlined.values), std::make_move_iterator(inlined.values + size_)));
+			storage_ = std::move(large);
+		}
+
+		/**
+		 * Moves the entries back inline.
+		 * @param keep_order if the entries keep their positions. Otherwise, they are sorted.
+		 */
+		void toSmall(bool keep_order) {
+			std::unique_ptr<Large> large = std::move(std::get<std::unique_ptr<Large>>(storage_));
+			std::vector<size_type> order(size_);
+			for (size_type i = 0; i < size_; ++i)
+				order[i] = i;
+			if (not keep_order)
+				std::sort(order.begin(), order.end(), [&](size_type a, size_type b) { return large->keys[a] < large->keys[b]; });
+			Inline &inlined = storage_.template emplace<Inline>();
+			for (size_type i = 0; i < size_; ++i) {
+				inlined.keys[i] = std::move(large->keys[order[i]]);
+				inlined.values[i] = std::move(large->values[order[i]]);
+			}
+		}
+
+		void shrinkIfNeeded(bool keep_order) {
+			if (large() != nullptr and size_ <= threshold / 2)
+				toSmall(keep_order);
+		}
+
+		/**
+		 * Inserts a key that is not yet contained.
+		 * @return position of the new entry
+		 */
+		template<typename V>
+		size_type insertNew(const Key &key, V &&value) {
+			if (large() == nullptr and size_ == threshold)
+				toLarge();
+			if (Large *large = this->large()) {
+				large->keys.push_back(key);
+				large->values.push_back(std::forward<V>(value));
+				large->index.insert(size_);
+				return size_++;
+			}
+			// keep the inline entries sorted
+			Inline &inlined = this->inlined();
+			size_type pos = size_;
+			while (pos > 0 and key < inlined.keys[pos - 1]) {
+				inlined.keys[pos] = std::move(inlined.keys[pos - 1]);
+				inlined.values[pos] = std::move(inlined.values[pos - 1]);
+				--pos;
+			}
+			inlined.keys[pos] = key;
+			inlined.values[pos] = std::forward<V>(value);
+			++size_;
+			return pos;
+		}
+
+		void erasePos(size_type pos) {
+			if (Large *large = this->large()) {
+				const size_type last = size_ - 1;
+				large->index.erase(pos);
+				if (pos != last) {
+					large->index.erase(last);
+					large->keys[pos] = std::move(large->keys[last]);
+					large->values[pos] = std::move(large->values[last]);
+					large->index.insert(pos);
+				}
+				large->keys.pop_back();
+				large->values.pop_back();
+			} else {
+				Inline &inlined = this->inlined();
+				for (size_type i = pos + 1; i < size_; ++i) {
+					inlined.keys[i - 1] = std::move(inlined.keys[i]);
+					inlined.values[i - 1] = std::move(inlined.values[i]);
+				}
+				inlined.keys[size_ - 1] = Key{};
+				inlined.values[size_ - 1] = T{};
+			}
+			--size_;
+		}
+
+	public:
+		template<bool is_const>
+		class iterator_t {
+			friend class adaptive_map_t;
+			using map_ptr = std::conditional_t<is_const, const adaptive_map_t *, adaptive_map_t *>;
+			using second_type = std::conditional_t<is_const, const T, T>;
+
+			map_ptr map_ = nullptr;
+			size_type pos_ = 0;
+
+		public:
+			/**
+			 * Proxy for an entry.
+			 */
+			struct entry_reference {
+				const Key &first;
+				second_type &second;
+			};
+
+			struct arrow_proxy {
+				entry_reference ref;
+				const entry_reference *operator->() const noexcept { return &ref; }
+			};
+
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = std::pair<Key, T>;
+			using difference_type = std::ptrdiff_t;
+			using pointer = arrow_proxy;
+			using reference = entry_reference;
+
+			iterator_t() = default;
+
+			iterator_t(map_ptr map, size_type pos) noexcept : map_(map), pos_(pos) {}
+
+			operator iterator_t<true>() const noexcept { return {map_, pos_}; }
+
+			reference operator*() const noexcept { return {map_->keyData()[pos_], map_->valueData()[pos_]}; }
+
+			pointer operator->() const noexcept { return {**this}; }
+
+			iterator_t &operator++() noexcept {
+				++pos_;
+				return *this;
+			}
+
+			iterator_t operator++(int) noexcept {
+				auto copy = *this;
+				++pos_;
+				return copy;
+			}
+
+			bool operator==(const iterator_t &other) const noexcept { return pos_ == other.pos_ and map_ == other.map_; }
+
+			bool operator!=(const iterator_t &other) const noexcept { return not(*this == other); }
+		};
+
+		using iterator = iterator_t<false>;
+		using const_iterator = iterator_t<true>;
+
+		adaptive_map_t() = default;
+
+		adaptive_map_t(std::initializer_list<value_type> entries) {
+			for (const auto &entry : entries)
+				insert(entry);
+		}
+
+		adaptive_map_t(const adaptive_map_t &other) : size_(other.size_) {
+			if (Large *large = other.large())
+				storage_ = std::make_unique<Large>(*large);
+			else
+				storage_ = other.inlined();
+		}
+
+		adaptive_map_t(adaptive_map_t &&other) noexcept : size_(other.size_), storage_(std::move(other.storage_)) {
+			other.clear();
+		}
+
+		adaptive_map_t &operator=(const adaptive_map_t &other) {
+			if (this != &other)
+				*this = adaptive_map_t(other);
+			return *this;
+		}
+
+		adaptive_map_t &operator=(adaptive_map_t &&other) noexcept {
+			if (this != &other) {
+				size_ = other.size_;
+				storage_ = std::move(other.storage_);
+				other.clear();
+			}
+			return *this;
+		}
+
+		iterator begin() noexcept { return {this, 0}; }
+
+		iterator end() noexcept { return {this, size_}; }
+
+		const_iterator begin() const noexcept { return {this, 0}; }
+
+		const_iterator end() const noexcept { return {this, size_}; }
+
+		const_iterator cbegin() const noexcept { return begin(); }
+
+		const_iterator cend() const noexcept { return end(); }
+
+		[[nodiscard]] size_type size() const noexcept { return size_; }
+
+		[[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+		/**
+		 * Checks if the entries are stored inline.
+		 */
+		[[nodiscard]] bool isInline() const noexcept { return large() == nullptr; }
+
+		/**
+		 * Heap memory owned by the container in bytes. It is zero while the entries are stored inline.
+		 */
+		[[nodiscard]] size_type heapBytes() const noexcept {
+			const Large *large = this->large();
+			if (large == nullptr)
+				return 0;
+			return sizeof(Large) + large->keys.capacity() * sizeof(Key) + large->values.capacity() * sizeof(T) + large->index.heapBytes();
+		}
+
+		iterator find(const Key &key) noexcept { return {this, findPos(key)}; }
+
+		const_iterator find(const Key &key) const noexcept { return {this, findPos(key)}; }
+
+		[[nodiscard]] size_type count(const Key &key) const noexcept { return findPos(key) != size_; }
+
+		[[nodiscard]] bool contains(const Key &key) const noexcept { return count(key); }
+
+		T &at(const Key &key) {
+			const size_type pos = findPos(key);
+			if (pos == size_)
+				throw std::out_of_range{"adaptive_map::at: key not found"};
+			return valueData()[pos];
+		}
+
+		const T &at(const Key &key) const {
+			const size_type pos = findPos(key);
+			if (pos == size_)
+				throw std::out_of_range{"adaptive_map::at: key not found"};
+			return valueData()[pos];
+		}
+
+		T &operator[](const Key &key) {
+			size_type pos = findPos(key);
+			if (pos == size_)
+				pos = insertNew(key, T{});
+			return valueData()[pos];
+		}
+
+		std::pair<iterator, bool> insert(const value_type &entry) {
+			if (const size_type pos = findPos(entry.first); pos != size_)
+				return {{this, pos}, false};
+			return {{this, insertNew(entry.first, entry.second)}, true};
+		}
+
+		template<typename V>
+		std::pair<iterator, bool> emplace(const Key &key, V &&value) {
+			if (const size_type pos = findPos(key); pos != size_)
+				return {{this, pos}, false};
+			return {{this, insertNew(key, std::forward<V>(value))}, true};
+		}
+
+		/**
+		 * Erases the entry at it.
+		 * @return iterator to the entry that takes the place of the erased one. Iterating from there visits all remaining entries.
+		 * If the entries are moved back inline, they keep their positions for that reason.
+		 */
+		iterator erase(const_iterator it) {
+			erasePos(it.pos_);
+			shrinkIfNeeded(true);
+			return {this, it.pos_};
+		}
+
+		size_type erase(const Key &key) {
+			const size_type pos = findPos(key);
+			if (pos == size_)
+				return 0;
+			erasePos(pos);
+			shrinkIfNeeded(false);
+			return 1;
+		}
+
+		void clear() noexcept {
+			storage_.template emplace<Inline>();
+			size_ = 0;
+		}
+	};
+
+	template<typename Key, typename T>
+	using adaptive_map = adaptive_map_t<Key, T>;
+}// namespace hypertrie::internal::container
+
+template<typename Key, typename T, std::size_t threshold>
+std::ostream &operator<<(std::ostream &os, const hypertrie::internal::container::adaptive_map_t<Key, T, threshold> &map) {
+	return os << fmt::format("{}", map);
+}
+
+template<typename K, typename V, std::size_t threshold>
+struct fmt::formatter<hypertrie::internal::container::adaptive_map_t<K, V, threshold>> {
+private:
+	using map_type = hypertrie::internal::container::adaptive_map_t<K, V, threshold>;
+
+public:
+	auto parse(format_parse_context &ctx) {
+		return ctx.begin();
+	}
+
+	template<typename FormatContext>
+	auto format(const map_type &map, FormatContext &ctx) {
+
+		bool first = true;
+		fmt::format_to(ctx.out(), "{{ ");
+		for (const auto &entry : map) {
+			if (first) {
+				first = false;
+			} else {
+				fmt::format_to(ctx.out(), "\n  ");
+			}
+			fmt::format_to(ctx.out(), "{} -> {} ", entry.first, entry.second);
+		}
+		return fmt::format_to(ctx.out(), "}}");
+	}
+};
+
+#endif//HYPERTRIE_ADAPTIVEMAP_HPP
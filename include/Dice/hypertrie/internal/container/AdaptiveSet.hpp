@@ -0,0 +1,281 @@
+#ifndef HYPERTRIE_ADAPTIVESET_HPP
+#define HYPERTRIE_ADAPTIVESET_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "Dice/hypertrie/internal/container/AdaptiveMap.hpp"
+#include "Dice/hypertrie/internal/container/ContainerMemory.hpp"
+#include "Dice/hypertrie/internal/container/KeyPositionIndex.hpp"
+#include "Dice/hypertrie/internal/container/SmallKeySearch.hpp"
+
+namespace hypertrie::internal::container {
+
+	/**
+	 * A set for few keys. Up to threshold keys are stored inline in an array. It is sorted unless the keys were moved back by
+	 * erase(iterator). The keys are searched with SIMD compares.
+	 * Above threshold, the keys are moved to a heap-allocated vector with an index of the key positions (see KeyPositionIndex).
+	 * Erasing moves them back once the size drops to threshold / 2.
+	 *
+	 * The keys are always stored contiguously, so the iterators are plain pointers.
+	 * Like std::vector, inserting or erasing invalidates iterators.
+	 * @tparam Key key type
+	 * @tparam threshold maximal number of inline keys
+	 */
+	template<typename Key, std::size_t threshold = adaptive_container_threshold>
+	class adaptive_set_t {
+		static_assert(threshold > 0);
+
+	public:
+		using key_type = Key;
+		using value_type = Key;
+		using size_type = std::size_t;
+		using iterator = const Key *;
+		using const_iterator = const Key *;
+
+	private:
+		static constexpr size_type inline_capacity = paddedCapacity<Key>(threshold);
+
+		struct Inline {
+			Key keys[inline_capacity]{};
+		};
+
+		struct Large {
+			std::vector<Key> keys;
+			KeyPositionIndex<Key> index{keys};
+
+			Large() = default;
+
+			explicit Large(std::vector<Key> keys) : keys(std::move(keys)) {}
+
+			Large(const Large &other) : keys(other.keys) {}
+		};
+
+		size_type size_ = 0;
+		/**
+		 * The keys are stored inline up to threshold keys and in a Large above.
+		 */
+		std::variant<Inline, std::unique_ptr<Large>> storage_{};
+
+		[[nodiscard]] Large *large() const noexcept {
+			const auto *large = std::get_if<std::unique_ptr<Large>>(&storage_);
+			return (large != nullptr) ? large->get() : nullptr;
+		}
+
+		[[nodiscard]] Inline &inlined() noexcept { return std::get<Inline>(storage_); }
+
+		[[nodiscard]] const Inline &inlined() const noexcept { return std::get<Inline>(storage_); }
+
+		[[nodiscard]] const Key *keyData() const noexcept {
+			if (Large *large = this->large())
+				return large->keys.data();
+			return inlined().keys;
+		}
+
+		[[nodiscard]] size_type findPos(const Key &key) const noexcept {
+			if (Large *large = this->large())
+				return large->index.find(key, size_);
+			return findSmallKey(inlined().keys, size_, key);
+		}
+
+		void toLarge() {
+			const Inline &inlined = this->inlined();
+			storage_ = std::make_unique<Large>(std::vector<Key>(inlined.keys, inlined.keys + size_));
+		}
+
+		/**
+		 * Moves the keys back inline.
+		 * @param keep_order if the keys keep their positions. Otherwise, they are sorted.
+		 */
+		void toSmall(bool keep_order) {
+			std::unique_ptr<Large> large = std::move(std::get<std::unique_ptr<Large>>(storage_));
+			Inline &inlined = storage_.template emplace<Inline>();
+			std::copy(large->keys.begin(), large->keys.end(), inlined.keys);
+			if (not keep_order)
+				std::sort(inlined.keys, inlined.keys + size_);
+		}
+
+		void shrinkIfNeeded(bool keep_order) {
+			if (large() != nullptr and size_ <= threshold / 2)
+				toSmall(keep_order);
+		}
+
+		size_type insertNew(const Key &key) {
+			if (large() == nullptr and size_ == threshold)
+				toLarge();
+			if (Large *large = this->large()) {
+				large->keys.push_back(key);
+				large->index.insert(size_);
+				return size_++;
+			}
+			// keep the inline keys sorted
+			Inline &inlined = this->inlined();
+			size_type pos = size_;
+			while (pos > 0 and key < inlined.keys[pos - 1]) {
+				inlined.keys[pos] = inlined.keys[pos - 1];
+				--pos;
+			}
+			inlined.keys[pos] = key;
+			++size_;
+			return pos;
+		}
+
+		void erasePos(size_type pos) {
+			if (Large *large = this->large()) {
+				const size_type last = size_ - 1;
+				large->index.erase(pos);
+				if (pos != last) {
+					large->index.erase(last);
+					large->keys[pos] = large->keys[last];
+					large->index.insert(pos);
+				}
+				large->keys.pop_back();
+			} else {
+				Inline &inlined = this->inlined();
+				std::copy(inlined.keys + pos + 1, inlined.keys + size_, inlined.keys + pos);
+				inlined.keys[size_ - 1] = Key{};
+			}
+			--size_;
+		}
+
+	public:
+		adaptive_set_t() = default;
+
+		adaptive_set_t(std::initializer_list<Key> keys) {
+			for (const auto &key : keys)
+				insert(key);
+		}
+
+		adaptive_set_t(const adaptive_set_t &other) : size_(other.size_) {
+			if (Large *large = other.large())
+				storage_ = std::make_unique<Large>(*large);
+			else
+				storage_ = other.inlined();
+		}
+
+		adaptive_set_t(adaptive_set_t &&other) noexcept : size_(other.size_), storage_(std::move(other.storage_)) {
+			other.clear();
+		}
+
+		adaptive_set_t &operator=(const adaptive_set_t &other) {
+			if (this != &other)
+				*this = adaptive_set_t(other);
+			return *this;
+		}
+
+		adaptive_set_t &operator=(adaptive_set_t &&other) noexcept {
+			if (this != &other) {
+				size_ = other.size_;
+				storage_ = std::move(other.storage_);
+				other.clear();
+			}
+			return *this;
+		}
+
+		const_iterator begin() const noexcept { return keyData(); }
+
+		const_iterator end() const noexcept { return keyData() + size_; }
+
+		const_iterator cbegin() const noexcept { return begin(); }
+
+		const_iterator cend() const noexcept { return end(); }
+
+		[[nodiscard]] size_type size() const noexcept { return size_; }
+
+		[[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+		/**
+		 * Checks if the keys are stored inline.
+		 */
+		[[nodiscard]] bool isInline() const noexcept { return large() == nullptr; }
+
+		/**
+		 * Heap memory owned by the container in bytes. It is zero while the keys are stored inline.
+		 */
+		[[nodiscard]] size_type heapBytes() const noexcept {
+			const Large *large = this->large();
+			if (large == nullptr)
+				return 0;
+			return sizeof(Large) + large->keys.capacity() * sizeof(Key) + large->index.heapBytes();
+		}
+
+		const_iterator find(const Key &key) const noexcept { return keyData() + findPos(key); }
+
+		[[nodiscard]] size_type count(const Key &key) const noexcept { return findPos(key) != size_; }
+
+		[[nodiscard]] bool contains(const Key &key) const noexcept { return count(key); }
+
+		std::pair<const_iterator, bool> insert(const Key &key) {
+			if (const size_type pos = findPos(key); pos != size_)
+				return {keyData() + pos, false};
+			const size_type pos = insertNew(key);
+			return {keyData() + pos, true};
+		}
+
+		/**
+		 * Erases the key at it.
+		 * @return iterator to the key that takes the place of the erased one. Iterating from there visits all remaining keys.
+		 * If the keys are moved back inline, they keep their positions for that reason.
+		 */
+		const_iterator erase(const_iterator it) {
+			const auto pos = static_cast<size_type>(it - keyData());
+			erasePos(pos);
+			shrinkIfNeeded(true);
+			return keyData() + pos;
+		}
+
+		size_type erase(const Key &key) {
+			const size_type pos = findPos(key);
+			if (pos == size_)
+				return 0;
+			erasePos(pos);
+			shrinkIfNeeded(false);
+			return 1;
+		}
+
+		void clear() noexcept {
+			storage_.template emplace<Inline>();
+			size_ = 0;
+		}
+	};
+
+	template<typename Key>
+	using adaptive_set = adaptive_set_t<Key>;
+}// namespace hypertrie::internal::container
+
+template<typename Key, std::size_t threshold>
+std::ostream &operator<<(std::ostream &os, const hypertrie::internal::container::adaptive_set_t<Key, threshold> &set) {
+	return os << fmt::format("{}", set);
+}
+
+template<typename K, std::size_t threshold>
+struct fmt::formatter<hypertrie::internal::container::adaptive_set_t<K, threshold>> {
+private:
+	using set_type = hypertrie::internal::container::adaptive_set_t<K, threshold>;
+
+public:
+	auto parse(format_parse_context &ctx) {
+		return ctx.begin();
+	}
+
+	template<typename FormatContext>
+	auto format(const set_type &set, FormatContext &ctx) {
+
+		if (set.size() == 0)
+			return fmt::format_to(ctx.out(), "{{ }}");
+		else {
+			fmt::format_to(ctx.out(), "{{ ");
+			fmt::format_to(ctx.out(), "{}", fmt::join(std::vector<K>{set.begin(), set.end()}, ", "));
+			return fmt::format_to(ctx.out(), " }}");
+		}
+	}
+};
+
+#endif//HYPERTRIE_ADAPTIVESET_HPP
@@ -1,8 +1,11 @@
 #ifndef HYPERTRIE_DEFAULT_HPP
 #define HYPERTRIE_DEFAULT_HPP
 
+#include "Dice/hypertrie/internal/container/AdaptiveMap.hpp"
+#include "Dice/hypertrie/internal/container/AdaptiveSet.hpp"
 #include "Dice/hypertrie/internal/container/BoostFlatMap.hpp"
 #include "Dice/hypertrie/internal/container/BoostFlatSet.hpp"
+#include "Dice/hypertrie/internal/container/ContainerMemory.hpp"
 #include "Dice/hypertrie/internal/container/StdMap.hpp"
 #include "Dice/hypertrie/internal/container/StdSet.hpp"
 #include "Dice/hypertrie/internal/container/StdUnorderedMap.hpp"
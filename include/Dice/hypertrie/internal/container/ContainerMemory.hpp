@@ -0,0 +1,91 @@
+#ifndef HYPERTRIE_CONTAINERMEMORY_HPP
+#define HYPERTRIE_CONTAINERMEMORY_HPP
+
+#include <cstddef>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <boost/container/flat_map.hpp>
+#include <boost/container/flat_set.hpp>
+#include <tsl/sparse_map.h>
+#include <tsl/sparse_set.h>
+
+namespace hypertrie::internal::container {
+
+	/**
+	 * Per-node overhead of node based std containers (color, parent, left and right pointer of a red-black tree node).
+	 */
+	static constexpr const std::size_t std_tree_node_overhead = 4 * sizeof(void *);
+
+	/**
+	 * Per-node overhead of std unordered containers (next pointer and cached hash).
+	 */
+	static constexpr const std::size_t std_hash_node_overhead = 2 * sizeof(void *);
+
+	/**
+	 * Overhead of a tsl sparse bucket group. A group covers 64 buckets and holds a values pointer, two bitmaps and two counters.
+	 */
+	static constexpr const std::size_t tsl_sparse_group_overhead = 4 * sizeof(void *);
+
+	/**
+	 * Estimates the heap memory that a container owns, i.e. without sizeof(container) itself.
+	 * The estimate is derived from size(), bucket_count() or capacity() in constant time. The elements are not visited.
+	 * Containers that provide a member heapBytes() are asked directly.
+	 * @tparam Container container type
+	 * @param container the container
+	 * @return number of bytes
+	 */
+	template<typename Container>
+	std::size_t heapBytes(const Container &container) noexcept {
+		if constexpr (requires { container.heapBytes(); })
+			return container.heapBytes();
+		else
+			return container.size() * sizeof(typename Container::value_type);
+	}
+
+	template<typename K, typename T, typename C, typename A>
+	std::size_t heapBytes(const std::map<K, T, C, A> &map) noexcept {
+		return map.size() * (sizeof(typename std::map<K, T, C, A>::value_type) + std_tree_node_overhead);
+	}
+
+	template<typename K, typename C, typename A>
+	std::size_t heapBytes(const std::set<K, C, A> &set) noexcept {
+		return set.size() * (sizeof(K) + std_tree_node_overhead);
+	}
+
+	template<typename K, typename T, typename H, typename E, typename A>
+	std::size_t heapBytes(const std::unordered_map<K, T, H, E, A> &map) noexcept {
+		return map.bucket_count() * sizeof(void *) +
+			   map.size() * (sizeof(typename std::unordered_map<K, T, H, E, A>::value_type) + std_hash_node_overhead);
+	}
+
+	template<typename K, typename H, typename E, typename A>
+	std::size_t heapBytes(const std::unordered_set<K, H, E, A> &set) noexcept {
+		return set.bucket_count() * sizeof(void *) + set.size() * (sizeof(K) + std_hash_node_overhead);
+	}
+
+	template<typename K, typename T, typename C, typename A>
+	std::size_t heapBytes(const boost::container::flat_map<K, T, C, A> &map) noexcept {
+		return map.capacity() * sizeof(typename boost::container::flat_map<K, T, C, A>::value_type);
+	}
+
+	template<typename K, typename C, typename A>
+	std::size_t heapBytes(const boost::container::flat_set<K, C, A> &set) noexcept {
+		return set.capacity() * sizeof(K);
+	}
+
+	template<typename K, typename T, typename H, typename E, typename A, typename G, tsl::sh::exception_safety S, tsl::sh::sparsity P>
+	std::size_t heapBytes(const tsl::sparse_map<K, T, H, E, A, G, S, P> &map) noexcept {
+		return (map.bucket_count() + 63) / 64 * tsl_sparse_group_overhead +
+			   map.size() * sizeof(typename tsl::sparse_map<K, T, H, E, A, G, S, P>::value_type);
+	}
+
+	template<typename K, typename H, typename E, typename A, typename G, tsl::sh::exception_safety S, tsl::sh::sparsity P>
+	std::size_t heapBytes(const tsl::sparse_set<K, H, E, A, G, S, P> &set) noexcept {
+		return (set.bucket_count() + 63) / 64 * tsl_sparse_group_overhead + set.size() * sizeof(K);
+	}
+}// namespace hypertrie::internal::container
+
+#endif//HYPERTRIE_CONTAINERMEMORY_HPP
@@ -0,0 +1,99 @@
+#ifndef HYPERTRIE_KEYPOSITIONINDEX_HPP
+#define HYPERTRIE_KEYPOSITIONINDEX_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <absl/hash/hash.h>
+#include <tsl/sparse_set.h>
+
+#include "Dice/hypertrie/internal/container/ContainerMemory.hpp"
+
+namespace hypertrie::internal::container {
+
+	/**
+	 * Hash index over the keys in a vector. It stores only the positions of the keys, so each key is stored once, in the vector.
+	 *
+	 * The index refers to the vector it was created for. It can neither be copied nor moved; create a new index for a copied vector.
+	 * The key at a position must not change while the position is in the index.
+	 * @tparam Key key type
+	 */
+	template<typename Key>
+	class KeyPositionIndex {
+	public:
+		using size_type = std::size_t;
+
+	private:
+		/**
+		 * A key that is looked up. It is a distinct type, so it is not confused with a position if Key is size_type.
+		 */
+		struct Lookup {
+			const Key &key;
+		};
+
+		struct Hash {
+			using is_transparent = void;
+			const std::vector<Key> *keys;
+
+			std::size_t operator()(size_type pos) const noexcept { return absl::Hash<Key>{}((*keys)[pos]); }
+
+			std::size_t operator()(const Lookup &lookup) const noexcept { return absl::Hash<Key>{}(lookup.key); }
+		};
+
+		struct Equal {
+			using is_transparent = void;
+			const std::vector<Key> *keys;
+
+			bool operator()(size_type a, size_type b) const noexcept { return (*keys)[a] == (*keys)[b]; }
+
+			bool operator()(const Lookup &lookup, size_type pos) const noexcept { return lookup.key == (*keys)[pos]; }
+
+			bool operator()(size_type pos, const Lookup &lookup) const noexcept { return lookup.key == (*keys)[pos]; }
+		};
+
+		tsl::sparse_set<size_type,
+						Hash,
+						Equal,
+						std::allocator<size_type>,
+						tsl::sh::power_of_two_growth_policy<2>,
+						tsl::sh::exception_safety::basic,
+						tsl::sh::sparsity::high>
+				positions_;
+
+	public:
+		/**
+		 * Indexes all keys in keys.
+		 */
+		explicit KeyPositionIndex(const std::vector<Key> &keys) : positions_(keys.size() * 2, Hash{&keys}, Equal{&keys}) {
+			for (size_type pos = 0; pos < keys.size(); ++pos)
+				positions_.insert(pos);
+		}
+
+		KeyPositionIndex(const KeyPositionIndex &) = delete;
+
+		KeyPositionIndex &operator=(const KeyPositionIndex &) = delete;
+
+		/**
+		 * @return position of key or not_found if it is not contained
+		 */
+		[[nodiscard]] size_type find(const Key &key, size_type not_found) const noexcept {
+			auto found = positions_.find(Lookup{key});
+			return (found != positions_.end()) ? *found : not_found;
+		}
+
+		/**
+		 * Adds the key at pos. It must not be contained yet.
+		 */
+		void insert(size_type pos) { positions_.insert(pos); }
+
+		/**
+		 * Removes the key at pos. It must be called before the key at pos is changed.
+		 */
+		void erase(size_type pos) { positions_.erase(pos); }
+
+		[[nodiscard]] std::size_t heapBytes() const noexcept { return container::heapBytes(positions_); }
+	};
+}// namespace hypertrie::internal::container
+
+#endif//HYPERTRIE_KEYPOSITIONINDEX_HPP
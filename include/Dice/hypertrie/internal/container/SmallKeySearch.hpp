@@ -0,0 +1,100 @@
+#ifndef HYPERTRIE_SMALLKEYSEARCH_HPP
+#define HYPERTRIE_SMALLKEYSEARCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+namespace hypertrie::internal::container {
+
+	/**
+	 * Number of keys that are compared at once. Inline key arrays are padded to a multiple of it,
+	 * so the search may always read whole vectors.
+	 */
+	template<typename Key>
+	static constexpr std::size_t small_key_search_lane_count = (sizeof(Key) >= 8) ? 4 : 8;
+
+	/**
+	 * Rounds capacity up to a multiple of small_key_search_lane_count.
+	 */
+	template<typename Key>
+	static constexpr std::size_t paddedCapacity(std::size_t capacity) {
+		constexpr std::size_t lanes = small_key_search_lane_count<Key>;
+		return ((capacity + lanes - 1) / lanes) * lanes;
+	}
+
+	/**
+	 * Searches key in the first size entries of keys.
+	 * For 4 and 8 byte integral keys, the keys are compared with SIMD instructions if AVX2 or SSE4.1 is enabled at compile time.
+	 * Otherwise a linear scan is used.
+	 * @tparam Key key type
+	 * @param keys key array. Its length must be padded with paddedCapacity(). Entries beyond size may hold any value.
+	 * @param size number of valid keys
+	 * @param key key to be searched
+	 * @return position of key or size if it is not contained
+	 */
+	template<typename Key>
+	inline std::size_t findSmallKey(const Key *keys, std::size_t size, const Key &key) noexcept {
+		[[maybe_unused]] constexpr std::size_t lanes = small_key_search_lane_count<Key>;
+		if constexpr (std::is_integral_v<Key> and sizeof(Key) == 8) {
+#if defined(__AVX2__)
+			const __m256i needle = _mm256_set1_epi64x(static_cast<long long>(key));
+			for (std::size_t i = 0; i < size; i += lanes) {
+				const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i));
+				const auto mask = static_cast<std::uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(block, needle))));
+				if (mask != 0) {
+					const std::size_t found = i + __builtin_ctz(mask);
+					return (found < size) ? found : size;
+				}
+			}
+			return size;
+#elif defined(__SSE4_1__)
+			const __m128i needle = _mm_set1_epi64x(static_cast<long long>(key));
+			for (std::size_t i = 0; i < size; i += 2) {
+				const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i));
+				const auto mask = static_cast<std::uint32_t>(_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(block, needle))));
+				if (mask != 0) {
+					const std::size_t found = i + __builtin_ctz(mask);
+					return (found < size) ? found : size;
+				}
+			}
+			return size;
+#endif
+		} else if constexpr (std::is_integral_v<Key> and sizeof(Key) == 4) {
+#if defined(__AVX2__)
+			const __m256i needle = _mm256_set1_epi32(static_cast<int>(key));
+			for (std::size_t i = 0; i < size; i += lanes) {
+				const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i));
+				const auto mask = static_cast<std::uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(block, needle))));
+				if (mask != 0) {
+					const std::size_t found = i + __builtin_ctz(mask);
+					return (found < size) ? found : size;
+				}
+			}
+			return size;
+#elif defined(__SSE4_1__)
+			const __m128i needle = _mm_set1_epi32(static_cast<int>(key));
+			for (std::size_t i = 0; i < size; i += 4) {
+				const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i));
+				const auto mask = static_cast<std::uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(block, needle))));
+				if (mask != 0) {
+					const std::size_t found = i + __builtin_ctz(mask);
+					return (found < size) ? found : size;
+				}
+			}
+			return size;
+#endif
+		}
+		for (std::size_t i = 0; i < size; ++i)
+			if (keys[i] == key)
+				return i;
+		return size;
+	}
+}// namespace hypertrie::internal::container
+
+#endif//HYPERTRIE_SMALLKEYSEARCH_HPP
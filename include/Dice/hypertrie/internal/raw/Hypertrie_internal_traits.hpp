@@ -70,6 +70,7 @@ namespace hypertrie::internal::raw {
 
 		constexpr static bool is_bool_valued = tr::is_bool_valued;
 		constexpr static const bool is_lsb_unused = tr::lsb_unused;
+		constexpr static const bool is_swizzled_edges = tr::swizzled_edges;
 		constexpr static bool is_tsl_map = std::is_same_v<map_type<int, int>, container::tsl_sparse_map<int, int>>;
 
 		/**
@@ -61,17 +61,38 @@ namespace hypertrie::internal::raw {
 			static_assert(any_depth >= depth);
 		}
 
+	private:
+		/**
+		 * The diagonal position with the fewest children. Only indexed positions are considered.
+		 * The diagonal must only need indexed positions (see NodeContext::diagonalIndexed). Otherwise, the entries on the
+		 * diagonal are scanned through position 0 and the diagonal is iterated on them (see hypertrie::HashDiagonal).
+		 */
+		size_t minCardPos() const {
+			if constexpr (depth > 1) {
+				const auto *node = nodec_->uncompressed_node();
+				const auto indexed_diag_poss = diag_poss_ & node->indexedPositions();
+				assert(indexed_diag_poss.any());
+				if constexpr (diag_depth > 1)
+					return node->minCardPos(indexed_diag_poss);
+				else // diag_depth == 1
+					for (const size_t pos : iter::range(diag_poss_.size()))
+						if (diag_poss_[pos])
+							return pos;
+			}
+			assert(false);
+			return 0UL;
+		}
+
+	public:
 		HashDiagonal &begin() {
+			if (empty()) {
+				static const typename UncompressedNode<depth, tri>::ChildrenType no_edges{};
+				iter_ = no_edges.begin();
+				end_ = no_edges.end();
+				return *this;
+			}
 			if constexpr (depth > 1) {
-				const size_t min_card_pos = [&]() {
-					if constexpr (diag_depth > 1)
-						return nodec_->uncompressed_node()->minCardPos(diag_poss_);
-					else // diag_depth == 1
-						for (const size_t pos : iter::range(diag_poss_.size()))
-							if (diag_poss_[pos])
-								return pos;
-					assert(false); return 0UL;
-				}();
+				const size_t min_card_pos = minCardPos();
 				// generate the sub_diag_poss_ diagonal positions mask to apply the diagonal to the values of iter_
 				if constexpr (diag_depth > 1) {
 					bool skipped = false;
@@ -128,7 +149,9 @@ namespace hypertrie::internal::raw {
 		}
 
 		auto operator[](key_part_type key_part){
-			if constexpr (result_depth > 0)
+			if (empty())
+				value_ = {};
+			else if constexpr (result_depth > 0)
 				value_ = node_context_->template diagonal_slice<depth, diag_depth>(*nodec_, diag_poss_, key_part, &internal_compressed_node);
 			else
 				value_ = node_context_->template diagonal_slice<depth, diag_depth>(*nodec_, diag_poss_, key_part);
@@ -140,6 +163,9 @@ namespace hypertrie::internal::raw {
 			static_assert(diag_depth > 1);
 			const key_part_type key_part = iter_->first;
 			if constexpr (not (tri::is_lsb_unused and depth - 1 == 1)){
+				// overlap the lookup of the next child with processing the current one
+				if (auto next = std::next(iter_); next != end_)
+					node_context_->storage.template prefetchNode<depth - 1>(next->second);
 				NodeContainer<depth - 1, tri> child_node = node_context_->storage.template getNode<depth - 1>(iter_->second);
 				if constexpr (result_depth > 0)
 					value_ = node_context_->template diagonal_slice<depth - 1, diag_depth - 1>(child_node, sub_diag_poss_, key_part, &internal_compressed_node);
@@ -233,12 +259,12 @@ namespace hypertrie::internal::raw {
 			return nodec_->empty();
 		}
 
-		size_t size() const noexcept {
+		size_t size() const {
 
 			if (not empty()) {
 				if constexpr (depth > 1) {
 
-					const auto min_card_pos = nodec_->uncompressed_node()->minCardPos(diag_poss_);
+					const auto min_card_pos = minCardPos();
 					return nodec_->uncompressed_node()->edges(min_card_pos).size();
 
 				} else {
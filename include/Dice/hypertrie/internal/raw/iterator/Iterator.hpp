@@ -157,8 +157,7 @@ namespace hypertrie::internal::raw {
 						return this->nodec()->compressed_node();
 					} else {
 						auto &iter = this->template getIter<node_depth>();
-						auto hash = iter->second;
-						return this->node_context()->storage.template getCompressedNode<node_depth>(hash).compressed_node();
+						return this->node_context()->storage.template getCompressedNode<node_depth>(iter->second).compressed_node();
 					}
 				}();
 				const auto &compr_key = node->key();
@@ -213,13 +212,10 @@ namespace hypertrie::internal::raw {
 					return *this->nodec();
 				} else {
 					auto &parent_iter = this->template getIter<current_depth>();
-					TensorHash hash;
 					if constexpr (current_depth == 1 and tri::is_lsb_unused)
-						hash = parent_iter->second.hash();
+						return this->node_context()->storage.template getUncompressedNode<current_depth>(parent_iter->second.hash());
 					else
-						hash = parent_iter->second;
-
-					return this->node_context()->storage.template getUncompressedNode<current_depth>(hash);
+						return this->node_context()->storage.template getUncompressedNode<current_depth>(parent_iter->second);
 				}
 			}();
 
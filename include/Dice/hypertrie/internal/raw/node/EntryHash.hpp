@@ -0,0 +1,123 @@
+#ifndef HYPERTRIE_ENTRYHASH_HPP
+#define HYPERTRIE_ENTRYHASH_HPP
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+
+#include <absl/hash/hash.h>
+
+#include "Dice/hypertrie/internal/util/RawKey.hpp"
+
+/**
+ * Seed of DeterministicEntryHash. Hashes, e.g. in snapshot files, are only comparable between builds with the same seed.
+ */
+#ifndef HYPERTRIE_ENTRY_HASH_SEED
+#define HYPERTRIE_ENTRY_HASH_SEED 0x2d358dccaa6c78a5ULL
+#endif
+
+/**
+ * The entry hash used by TensorHash. It must provide `static std::uint64_t hash(const RawKey<depth, key_part_type> &, const value_type &)`.
+ */
+#ifndef HYPERTRIE_ENTRY_HASH
+#define HYPERTRIE_ENTRY_HASH ::hypertrie::internal::raw::DeterministicEntryHash
+#endif
+
+namespace hypertrie::internal::raw {
+
+	/**
+	 * Entry hash that is equal in all processes. Integral, floating point and bool key parts and values are hashed with
+	 * a multiply-fold kernel on their bits. Other types fall back to absl::Hash, which is seeded per process.
+	 */
+	struct DeterministicEntryHash {
+		static constexpr const std::uint64_t seed = HYPERTRIE_ENTRY_HASH_SEED;
+
+	private:
+		static constexpr const std::array<std::uint64_t, 4> secrets{0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL,
+																	0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL};
+
+		/**
+		 * Multiplies a and b to 128 bits and folds the halves with xor.
+		 */
+		static inline std::uint64_t mix(std::uint64_t a, std::uint64_t b) noexcept {
+			const __uint128_t product = __uint128_t(a) * b;
+			return std::uint64_t(product) ^ std::uint64_t(product >> 64);
+		}
+
+		template<typename T>
+		static inline std::uint64_t bits(const T &x) noexcept {
+			if constexpr (std::is_integral_v<T>)
+				return std::uint64_t(x);
+			else if constexpr (std::is_floating_point_v<T> and sizeof(T) == sizeof(std::uint64_t))
+				return std::bit_cast<std::uint64_t>(x);
+			else if constexpr (std::is_floating_point_v<T> and sizeof(T) == sizeof(std::uint32_t))
+				return std::bit_cast<std::uint32_t>(x);
+			else
+				return absl::Hash<T>()(x);
+		}
+
+	public:
+		/**
+		 * Two words, i.e. key parts or the value, are consumed per multiplication. Each step depends on the previous one:
+		 * if the parts were hashed independently and combined with xor, the xor of the entries of a tensor could cancel out.
+		 */
+		template<size_t depth, typename key_part_type, typename value_type>
+		static inline std::uint64_t hash(const RawKey<depth, key_part_type> &key, const value_type &value) noexcept {
+			// all entries of bool-valued tensors have the value true, so it is not hashed
+			static constexpr const bool hash_value = not std::is_same_v<value_type, bool>;
+			static constexpr const size_t words = depth + (hash_value ? 1 : 0);
+			auto word = [&](size_t i) -> std::uint64_t {
+				if (i < depth)
+					return bits(key[i]);
+				else if constexpr (hash_value)
+					return bits(value);
+				else
+					return 0;
+			};
+
+			std::uint64_t h = seed ^ (depth * secrets[0]);
+			size_t i = 0;
+			for (; i + 1 < words; i += 2)
+				h = mix(word(i) ^ secrets[i % 4] ^ h, word(i + 1) ^ secrets[(i + 1) % 4]);
+			if (i < words)
+				h = mix(word(i) ^ secrets[i % 4] ^ h, secrets[(i + 1) % 4]);
+			return mix(h ^ secrets[2], words ^ secrets[3]);
+		}
+	};
+
+	/**
+	 * Entry hash based on absl::Hash. It is seeded randomly per process, so hashes differ between program executions.
+	 */
+	struct AbslEntryHash {
+		template<size_t depth, typename key_part_type, typename value_type>
+		static inline std::uint64_t hash(const RawKey<depth, key_part_type> &key, const value_type &value) noexcept {
+			return absl::Hash<std::tuple<RawKey<depth, key_part_type>, value_type>>()({key, value});
+		}
+	};
+
+	/**
+	 * Computes the xor of the hashes of many entries. Four entries are hashed in independent lanes, so the multiplications
+	 * of different entries overlap in the CPU pipeline instead of waiting for each other.
+	 * @tparam EntryHasher entry hash, e.g. DeterministicEntryHash
+	 * @param begin random access iterator to the first entry
+	 * @param end end of the entries
+	 * @param key_of returns the RawKey of an entry
+	 * @param value_of returns the value of an entry
+	 * @return xor of the entry hashes
+	 */
+	template<typename EntryHasher, typename It, typename KeyOf, typename ValueOf>
+	inline std::uint64_t hashEntries(It begin, const It end, KeyOf &&key_of, ValueOf &&value_of) noexcept {
+		static constexpr const size_t lanes = 4;
+		std::array<std::uint64_t, lanes> combined{};
+		for (; end - begin >= std::ptrdiff_t(lanes); begin += lanes)
+			for (size_t lane = 0; lane < lanes; ++lane)
+				combined[lane] ^= EntryHasher::hash(key_of(begin[lane]), value_of(begin[lane]));
+		for (; begin != end; ++begin)
+			combined[0] ^= EntryHasher::hash(key_of(*begin), value_of(*begin));
+		return combined[0] ^ combined[1] ^ combined[2] ^ combined[3];
+	}
+}// namespace hypertrie::internal::raw
+
+#endif//HYPERTRIE_ENTRYHASH_HPP
@@ -4,8 +4,10 @@
 #include "Dice/hypertrie/internal/raw/Hypertrie_internal_traits.hpp"
 #include "Dice/hypertrie/internal/util/PosType.hpp"
 #include "Dice/hypertrie/internal/raw/node/NodeCompression.hpp"
+#include "Dice/hypertrie/internal/raw/node/SwizzledTensorHash.hpp"
 #include "Dice/hypertrie/internal/raw/node/TaggedTensorHash.hpp"
 #include "Dice/hypertrie/internal/raw/node/TensorHash.hpp"
+#include <bitset>
 #include <range.hpp>
 
 namespace hypertrie::internal::raw {
@@ -132,7 +134,9 @@ namespace hypertrie::internal::raw {
 		using ChildType = std::conditional_t<(depth > 1),
 											 std::conditional_t<(depth == 2 and tri::is_lsb_unused),
 																TaggedTensorHash<tri>,
-																TensorHash>,
+																std::conditional_t<(tri::is_swizzled_edges),
+																				   SwizzledTensorHash,
+																				   TensorHash>>,
 											 value_type>;
 
 		using ChildrenType = std::conditional_t<((depth == 1) and tri::is_bool_valued),
@@ -275,6 +279,8 @@ namespace hypertrie::internal::raw {
 		using value_type = typename tri::value_type;
 
 	public:
+		Node() = default;
+
 		Node(const RawKey &key, value_type value, size_t ref_count = 0)
 			: ReferenceCounted(ref_count), Compressed<depth, tri_t>(key), Valued<tri_t>(value) {}
 
@@ -296,22 +302,57 @@ namespace hypertrie::internal::raw {
 		using value_type = typename tri::value_type;
 		using ChildrenType = typename WithEdges<depth, tri_t>::ChildrenType;
 		using EdgesType = typename WithEdges<depth, tri_t>::EdgesType;
+		using IndexedPositions = std::bitset<depth>;
 
 	private:
 		static constexpr const auto subkey = &tri::template subkey<depth>;
 		static constexpr const auto deref = &tri::template deref<typename ChildrenType::key_type, typename ChildrenType::mapped_type>;
+		/**
+		 * Positions for which the edges are populated. The edges of other positions are empty. Position 0 is always indexed.
+		 * Skipping a position saves its edge entries and the child nodes that are only reachable through it. The empty
+		 * edge map of a skipped position is still part of the node (sizeof(ChildrenType) bytes) but allocates no heap memory.
+		 */
+		IndexedPositions indexed_positions_;
 	public:
 
 		size_t size_ = 0;
-		Node(size_t ref_count = 0) : ReferenceCounted(ref_count) {}
+		Node(size_t ref_count = 0, IndexedPositions indexed_positions = IndexedPositions{}.set())
+			: ReferenceCounted(ref_count), indexed_positions_(indexed_positions.set(0)) {}
+
+		[[nodiscard]] bool isIndexed(size_t pos) const noexcept { return indexed_positions_[pos]; }
+
+		[[nodiscard]] const IndexedPositions &indexedPositions() const noexcept { return indexed_positions_; }
+
+		/**
+		 * Marks the edges at pos as populated. The caller is responsible for populating them.
+		 */
+		void setIndexed(size_t pos) noexcept { indexed_positions_.set(pos); }
 
+		/**
+		 * The indexed position with the fewest edges. A point lookup that descends through it probes the smallest edge map.
+		 */
+		[[nodiscard]] size_t minCardIndexedPos() const noexcept {
+			size_t min_pos = 0;
+			size_t min_card = this->edges(0).size();
+			for (const size_t pos : iter::range(1UL, depth)) {
+				if (not isIndexed(pos))
+					continue;
+				if (const size_t card = this->edges(pos).size(); card < min_card) {
+					min_card = card;
+					min_pos = pos;
+				}
+			}
+			return min_pos;
+		}
 
 		void change_value(const RawKey &key, value_type old_value, value_type new_value) noexcept {
 			if constexpr (not tri::is_bool_valued)
 				for (const size_t pos : iter::range(depth)) {
+					if (not isIndexed(pos))
+						continue;
 					auto sub_key = subkey(key, pos);
-					TensorHash &hash = this->edges(pos)[key[pos]];
-					hash.changeValue(sub_key, old_value, new_value);
+					auto &hash = this->edges(pos)[key[pos]];
+					hash = TensorHash(hash).changeValue(sub_key, old_value, new_value);
 				}
 		}
 
@@ -321,7 +362,10 @@ namespace hypertrie::internal::raw {
 			fmt::memory_buffer out;
 			fmt::format_to(out, "<Node depth = {}, uncompressed> {{", depth);
 			for (size_t pos : iter::range(depth)) {
-				fmt::format_to(out, "\n\tedges[{}] = {}", pos, this->edges(pos));
+				if (isIndexed(pos))
+					fmt::format_to(out, "\n\tedges[{}] = {}", pos, this->edges(pos));
+				else
+					fmt::format_to(out, "\n\tedges[{}] = <not indexed>", pos);
 			}
 			fmt::format_to(out, ",\n\tref_count = {}", this->ref_count());
 			fmt::format_to(out, " }}");
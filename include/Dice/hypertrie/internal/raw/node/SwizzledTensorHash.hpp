@@ -0,0 +1,158 @@
+#ifndef HYPERTRIE_SWIZZLEDTENSORHASH_HPP
+#define HYPERTRIE_SWIZZLEDTENSORHASH_HPP
+
+#include <atomic>
+#include <limits>
+
+#include <fmt/ostream.h>
+
+#include "Dice/hypertrie/internal/raw/node/TensorHash.hpp"
+
+namespace hypertrie::internal::raw {
+
+	/**
+	 * An edge to a child node. It stores the TensorHash of the child and caches the pointer to the child.
+	 *
+	 * The cached pointer is only valid for the revision of the node table it was resolved from. The revision changes whenever a node
+	 * is deleted from that table, so deleted nodes are never returned from the cache. A node that is moved in place to a new
+	 * hash keeps the revision: its old hash is no longer referenced by any live edge.
+	 * Assigning a new hash drops the cached pointer. The hash cannot be modified in place.
+	 *
+	 * Concurrent readers of a shared node fill the cache, so pointer and revision are published like a seqlock: a writer
+	 * marks the stamp busy, stores the pointer and releases the new stamp. A reader only takes a pointer if it read the
+	 * same stamp before and after the pointer. Only newer revisions replace a cached pointer, so a stamp never returns
+	 * to an older value and a pointer of an outdated revision is never paired with the current one.
+	 *
+	 * Every deletion from a node table changes its revision, which invalidates the cached pointers of all edges into that
+	 * level at once. A modification deletes its nodes in one pass, so afterwards each edge is resolved by a table lookup
+	 * once more. Many small modifications interleaved with reads make the cache degrade to plain lookups.
+	 */
+	class SwizzledTensorHash {
+		static constexpr const size_t EMPTY = 0;
+		static constexpr const size_t BUSY = std::numeric_limits<size_t>::max();
+
+		TensorHash hash_{};
+		/**
+		 * Cached pointer to the child node. Only valid if stamp_ is neither EMPTY nor BUSY.
+		 */
+		mutable void *node_ = nullptr;
+		/**
+		 * Revision of the node table when node_ was cached plus one. EMPTY if nothing is cached, BUSY while node_ is written.
+		 */
+		mutable size_t stamp_ = EMPTY;
+
+	public:
+		SwizzledTensorHash() noexcept = default;
+
+		SwizzledTensorHash(const TensorHash &hash) noexcept : hash_(hash) {}
+
+		SwizzledTensorHash(const SwizzledTensorHash &other) noexcept : hash_(other.hash_) {
+			copyCache(other);
+		}
+
+		SwizzledTensorHash &operator=(const SwizzledTensorHash &other) noexcept {
+			hash_ = other.hash_;
+			copyCache(other);
+			return *this;
+		}
+
+		SwizzledTensorHash &operator=(const TensorHash &hash) noexcept {
+			hash_ = hash;
+			std::atomic_ref<size_t>(stamp_).store(EMPTY, std::memory_order_relaxed);
+			std::atomic_ref<void *>(node_).store(nullptr, std::memory_order_relaxed);
+			return *this;
+		}
+
+		[[nodiscard]] const TensorHash &tensorHash() const noexcept { return hash_; }
+
+		operator const TensorHash &() const noexcept { return hash_; }
+
+		[[nodiscard]] const RawTensorHash &hash() const noexcept { return hash_.hash(); }
+
+		[[nodiscard]] bool isCompressed() const noexcept { return hash_.isCompressed(); }
+
+		[[nodiscard]] bool isUncompressed() const noexcept { return hash_.isUncompressed(); }
+
+		[[nodiscard]] bool empty() const noexcept { return hash_.empty(); }
+
+		explicit operator bool() const noexcept { return bool(hash_); }
+
+		/**
+		 * The cached node pointer.
+		 * @param revision current revision of the node table that contains the child
+		 * @return the cached pointer or nullptr if nothing or an outdated pointer is cached
+		 */
+		[[nodiscard]] void *cachedNode(size_t revision) const noexcept {
+			const size_t stamp = revision + 1;
+			if (std::atomic_ref<size_t>(stamp_).load(std::memory_order_acquire) != stamp)
+				return nullptr;
+			return loadNode(stamp);
+		}
+
+		/**
+		 * Caches a node pointer. Nothing is cached if a pointer of the same or a newer revision is cached already or if
+		 * another thread is caching a pointer right now.
+		 * @param node pointer to the child node
+		 * @param revision current revision of the node table that contains the child
+		 */
+		void cacheNode(void *node, size_t revision) const noexcept {
+			const size_t stamp = revision + 1;
+			std::atomic_ref<size_t> stamp_ref(stamp_);
+			size_t current = stamp_ref.load(std::memory_order_relaxed);
+			if (current >= stamp or not stamp_ref.compare_exchange_strong(current, BUSY, std::memory_order_relaxed))
+				return;
+			std::atomic_thread_fence(std::memory_order_release);
+			std::atomic_ref<void *>(node_).store(node, std::memory_order_relaxed);
+			stamp_ref.store(stamp, std::memory_order_release);
+		}
+
+	private:
+		/**
+		 * Loads node_ after stamp_ was read as stamp with acquire.
+		 * @return node_ or nullptr if a writer changed stamp_ meanwhile
+		 */
+		void *loadNode(const size_t stamp) const noexcept {
+			void *node = std::atomic_ref<void *>(node_).load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (std::atomic_ref<size_t>(stamp_).load(std::memory_order_relaxed) != stamp)
+				return nullptr;
+			return node;
+		}
+
+		void copyCache(const SwizzledTensorHash &other) noexcept {
+			const size_t stamp = std::atomic_ref<size_t>(other.stamp_).load(std::memory_order_acquire);
+			void *node = (stamp == EMPTY or stamp == BUSY) ? nullptr : other.loadNode(stamp);
+			node_ = node;
+			stamp_ = (node == nullptr) ? EMPTY : stamp;
+		}
+
+	public:
+
+		bool operator<(const SwizzledTensorHash &other) const noexcept { return hash_ < other.hash_; }
+
+		bool operator==(const SwizzledTensorHash &other) const noexcept { return hash_ == other.hash_; }
+
+		bool operator==(const TensorHash &other) const noexcept { return hash_ == other; }
+
+		explicit operator std::string() const noexcept { return (std::string) hash_; }
+
+		friend std::ostream &operator<<(std::ostream &os, const SwizzledTensorHash &hash) {
+			os << (std::string) hash;
+			return os;
+		}
+	};
+}// namespace hypertrie::internal::raw
+
+template<>
+struct fmt::formatter<hypertrie::internal::raw::SwizzledTensorHash> {
+	auto parse(format_parse_context &ctx) {
+		return ctx.begin();
+	}
+
+	template<typename FormatContext>
+	auto format(const hypertrie::internal::raw::SwizzledTensorHash &hash, FormatContext &ctx) {
+		return fmt::format_to(ctx.out(), "{}", (std::string) hash);
+	}
+};
+
+#endif//HYPERTRIE_SWIZZLEDTENSORHASH_HPP
@@ -4,9 +4,9 @@
 #include <bitset>
 #include <compare>
 
-#include <absl/hash/hash.h>
 #include <fmt/ostream.h>
 
+#include "Dice/hypertrie/internal/raw/node/EntryHash.hpp"
 #include "Dice/hypertrie/internal/util/PosType.hpp"
 #include "Dice/hypertrie/internal/util/RawKey.hpp"
 
@@ -24,15 +24,21 @@ namespace hypertrie::internal::raw {
 	 *
 	 * Note: (a xor b xor b) = a (see also https://en.wikipedia.org/wiki/XOR_cipher )
 	 *
-	 * Note 2: This implementation relies on absl::Hash which initializes the hash seed randomly and thus does not provide stable hashes between program executions. To fix the seed, set a fixed seed here https://github.com/abseil/abseil-cpp/blob/4a851046a0102cd986a5714a1af8deef28a544c4/absl/hash/internal/hash.cc#L51 before compiling absl .
+	 * Note 2: The entries are hashed with HYPERTRIE_ENTRY_HASH (see EntryHash.hpp). The default DeterministicEntryHash provides
+	 * stable hashes between program executions for integral and floating point keys and values. AbslEntryHash does not.
 	 */
 	class TensorHash {
-
+	public:
 		/**
 		 * Hasher for an entry.
 		 */
-		template<size_t depth, typename key_part_type, typename V>
-		using EntryHash = absl::Hash<std::tuple<RawKey<depth, key_part_type>, V>>;
+		using EntryHasher = HYPERTRIE_ENTRY_HASH;
+
+	private:
+		template<size_t depth, typename key_part_type, typename value_type>
+		static inline RawTensorHash entryHash(const RawKey<depth, key_part_type> &key, const value_type &value) noexcept {
+			return RawTensorHash(EntryHasher::template hash<depth, key_part_type, value_type>(key, value));
+		}
 
 		/**
 		 * Bit representation of the hash.
@@ -142,7 +148,7 @@ namespace hypertrie::internal::raw {
 		inline auto
 		changeValue(const RawKey<depth, key_part_type> &key, const value_type &old_value, const value_type &new_value)  noexcept {
 			const bool tag = bitset()[compression_tag_pos];
-			hash_ = hash_ xor EntryHash<depth, key_part_type, value_type>()({key, old_value}) xor EntryHash<depth, key_part_type, value_type>()({key, new_value});
+			hash_ = hash_ xor entryHash(key, old_value) xor entryHash(key, new_value);
 			bitset()[compression_tag_pos] = tag;
 			return *this;
 		}
@@ -159,7 +165,7 @@ namespace hypertrie::internal::raw {
 		 */
 		template<size_t depth, typename key_part_type, typename value_type>
 		inline auto addFirstEntry(const RawKey<depth, key_part_type> &key, const value_type &value)  noexcept {
-			hash_ = hash_ xor EntryHash<depth, key_part_type, value_type>()({key, value});
+			hash_ = hash_ xor entryHash(key, value);
 			bitset()[compression_tag_pos] = compressed_tag;
 			return *this;
 		}
@@ -175,7 +181,22 @@ namespace hypertrie::internal::raw {
 		 */
 		template<size_t depth, typename key_part_type, typename value_type>
 		inline auto addEntry(const RawKey<depth, key_part_type> &key, const value_type &value) noexcept {
-			hash_ = hash_ xor EntryHash<depth, key_part_type, value_type>()({key, value});
+			hash_ = hash_ xor entryHash(key, value);
+			bitset()[compression_tag_pos] = uncompressed_tag;
+			return *this;
+		}
+
+		/**
+		 * Adds many entries. The entry hashes are computed in a batch (see hashEntries).
+		 * @param begin random access iterator to the first entry
+		 * @param end end of the entries
+		 * @param key_of returns the key of an entry
+		 * @param value_of returns the value of an entry
+		 * @return reference to self
+		 */
+		template<typename It, typename KeyOf, typename ValueOf>
+		inline auto addEntries(It begin, It end, KeyOf &&key_of, ValueOf &&value_of) noexcept {
+			hash_ = hash_ xor RawTensorHash(hashEntries<EntryHasher>(begin, end, key_of, value_of));
 			bitset()[compression_tag_pos] = uncompressed_tag;
 			return *this;
 		}
@@ -194,7 +215,24 @@ namespace hypertrie::internal::raw {
 		inline auto
 		removeEntry(const RawKey<depth, key_part_type> &key, const value_type &value, bool make_compressed) noexcept {
 			assert(isUncompressed());
-			hash_ = hash_ xor EntryHash<depth, key_part_type, value_type>()({key, value});
+			hash_ = hash_ xor entryHash(key, value);
+			bitset()[compression_tag_pos] = make_compressed;
+			return *this;
+		}
+
+		/**
+		 * Removes many entries. The entry hashes are computed in a batch (see hashEntries).
+		 * @param begin random access iterator to the first entry
+		 * @param end end of the entries
+		 * @param key_of returns the key of an entry
+		 * @param value_of returns the value of an entry
+		 * @param make_compressed if the node should be compressed afterwards
+		 * @return reference to self
+		 */
+		template<typename It, typename KeyOf, typename ValueOf>
+		inline auto removeEntries(It begin, It end, KeyOf &&key_of, ValueOf &&value_of, bool make_compressed) noexcept {
+			assert(isUncompressed());
+			hash_ = hash_ xor RawTensorHash(hashEntries<EntryHasher>(begin, end, key_of, value_of));
 			bitset()[compression_tag_pos] = make_compressed;
 			return *this;
 		}
@@ -0,0 +1,167 @@
+#ifndef HYPERTRIE_BULKBUILDER_HPP
+#define HYPERTRIE_BULKBUILDER_HPP
+
+#include "Dice/hypertrie/internal/raw/node/NodeContainer.hpp"
+#include "Dice/hypertrie/internal/raw/node/TensorHash.hpp"
+#include "Dice/hypertrie/internal/raw/storage/Entry.hpp"
+#include "Dice/hypertrie/internal/raw/storage/NodeStorage.hpp"
+#include "Dice/hypertrie/internal/util/IntegralTemplatedTuple.hpp"
+#include "Dice/hypertrie/internal/util/RadixSort.hpp"
+
+#include <cassert>
+#include <vector>
+
+namespace hypertrie::internal::raw {
+
+	/**
+	 * Builds a node from scratch out of a set of entries. It is used instead of RekNodeModification when entries are
+	 * inserted into an empty node.
+	 *
+	 * The entries of a node are sorted by the key part at each indexed position. Every run of equal key parts is one child.
+	 * The children are built depth first from their runs, so no node is planned or grouped into per-child containers.
+	 * Only one scratch buffer per depth is used: while a node of depth d is built, no other node of depth d is in progress.
+	 * Nodes that already exist in the storage are shared and not descended into. Nodes are created while the entries are
+	 * still descended into, so a hash collision could not be rejected without leaving a partial build behind. If
+	 * NodeStorage::verifyHashes() is set, RekNodeModification plans the insertion instead (see RekNodeModification::verifyPlan).
+	 */
+	template<size_t node_storage_depth, HypertrieInternalTrait tri_t>
+	class BulkBuilder {
+	public:
+		using tri = tri_t;
+		using key_part_type = typename tri::key_part_type;
+		using value_type = typename tri::value_type;
+		template<size_t depth>
+		using RawKey = typename tri::template RawKey<depth>;
+
+	private:
+		template<size_t depth>
+		using re = RawEntry_t<depth, tri>;
+
+		template<size_t depth>
+		using Entry = typename re<depth>::RawEntry;
+
+		template<size_t depth>
+		using EntryBuffer = std::vector<Entry<depth>>;
+
+		using EntryBuffers = util::IntegralTemplatedTuple<EntryBuffer, 1, node_storage_depth>;
+
+		NodeStorage<node_storage_depth, tri> &node_storage;
+
+		/**
+		 * Entries of the children of the node at depth + 1 that is in progress, grouped by key part.
+		 */
+		EntryBuffers sub_entries{};
+
+		/**
+		 * Scratch space for sorting the entries of the node at depth that is in progress.
+		 */
+		EntryBuffers sort_buffers{};
+
+	public:
+		explicit BulkBuilder(NodeStorage<node_storage_depth, tri> &node_storage) : node_storage(node_storage) {}
+
+		/**
+		 * Builds the node that holds exactly the given entries. Its reference count is incremented by one.
+		 * @tparam depth depth of the node
+		 * @param entries entries with pairwise distinct keys and values other than zero. For bool-valued tries with unused
+		 * lsb at depth 1, there must be at least two entries.
+		 * @return container of the node
+		 */
+		template<size_t depth>
+		NodeContainer<depth, tri> build(std::vector<Entry<depth>> entries) {
+			assert(not entries.empty());
+			const TensorHash hash = buildNode<depth>(entries.data(), entries.data() + entries.size());
+			return node_storage.template getNode<depth>(hash);
+		}
+
+	private:
+		/**
+		 * Makes sure the node that holds [begin, end) exists and counts one more reference to it.
+		 * The entries are reordered.
+		 * @return hash of the node
+		 */
+		template<size_t depth>
+		TensorHash buildNode(Entry<depth> *const begin, Entry<depth> *const end) {
+			using red = re<depth>;
+			const size_t size = end - begin;
+			assert(size > 0);
+
+			if (size == 1) {
+				if constexpr (not(depth == 1 and tri::is_lsb_unused and tri::is_bool_valued)) {
+					const TensorHash hash = TensorHash::getCompressedNodeHash(red::key(*begin), red::value(*begin));
+					if (auto nodec = node_storage.template getNode<depth, NodeCompression::compressed>(hash); not nodec.null())
+						node_storage.template changeRefCount<depth, NodeCompression::compressed>(nodec.compressed_node(), 1);
+					else
+						node_storage.template newCompressedNode<depth>(red::key(*begin), red::value(*begin), 1, hash);
+					return hash;
+				} else {
+					assert(false);// the parent stores the key part in the edge
+					return {};
+				}
+			}
+
+			TensorHash hash = TensorHash::getCompressedNodeHash(red::key(*begin), red::value(*begin));
+			hash.addEntries(
+					begin + 1, end,
+					[](const Entry<depth> &entry) -> const RawKey<depth> & { return red::key(entry); },
+					[](const Entry<depth> &entry) -> value_type { return red::value(entry); });
+			if (auto nodec = node_storage.template getNode<depth, NodeCompression::uncompressed>(hash); not nodec.null()) {
+				node_storage.template changeRefCount<depth, NodeCompression::uncompressed>(nodec.uncompressed_node(), 1);
+				return hash;
+			}
+
+			UncompressedNode<depth, tri> *const node = [&]() {
+				if constexpr (depth > 1)
+					return node_storage.template constructNode<depth, NodeCompression::uncompressed>(size_t(1), node_storage.template indexedPositions<depth>());
+				else
+					return node_storage.template constructNode<depth, NodeCompression::uncompressed>(size_t(1));
+			}();
+
+			if constexpr (depth == 1) {
+				for (const Entry<depth> *entry = begin; entry != end; ++entry) {
+					if constexpr (tri::is_bool_valued)
+						node->edges().insert(red::key(*entry)[0]);
+					else
+						node->edges().emplace(red::key(*entry)[0], red::value(*entry));
+				}
+			} else {
+				static constexpr const auto subkey = &tri::template subkey<depth>;
+				node->size_ = size;
+				EntryBuffer<depth - 1> &children_entries = sub_entries.template get<depth - 1>();
+				for (const size_t pos : iter::range(depth)) {
+					if (not node->isIndexed(pos))
+						continue;
+					util::radixSort(begin, end, sort_buffers.template get<depth>(),
+									[pos](const Entry<depth> &entry) { return red::key(entry)[pos]; });
+					children_entries.clear();
+					children_entries.reserve(size);
+					for (const Entry<depth> *entry = begin; entry != end; ++entry)
+						children_entries.push_back(re<depth - 1>::make_Entry(subkey(red::key(*entry), pos), red::value(*entry)));
+
+					auto &edges = node->edges(pos);
+					size_t run_begin = 0;
+					while (run_begin < size) {
+						const key_part_type key_part = red::key(begin[run_begin])[pos];
+						size_t run_end = run_begin + 1;
+						while (run_end < size and red::key(begin[run_end])[pos] == key_part)
+							++run_end;
+						if constexpr (depth == 2 and tri::is_lsb_unused and tri::is_bool_valued) {
+							if (run_end - run_begin == 1) {
+								edges[key_part] = TaggedTensorHash<tri>{children_entries[run_begin][0]};
+								run_begin = run_end;
+								continue;
+							}
+						}
+						edges[key_part] = buildNode<depth - 1>(children_entries.data() + run_begin, children_entries.data() + run_end);
+						run_begin = run_end;
+					}
+				}
+			}
+			// the node is complete before readers can find it
+			node_storage.template getNodeStorage<depth, NodeCompression::uncompressed>().insert({hash, node});
+			return hash;
+		}
+	};
+}// namespace hypertrie::internal::raw
+
+#endif//HYPERTRIE_BULKBUILDER_HPP
@@ -0,0 +1,51 @@
+#ifndef HYPERTRIE_DUPLICATEPOLICY_HPP
+#define HYPERTRIE_DUPLICATEPOLICY_HPP
+
+#include <algorithm>
+#include <type_traits>
+
+namespace hypertrie::internal::raw {
+
+	/**
+	 * How a bulk insertion combines the value of a key that is already contained, or that occurs multiple times in the
+	 * same batch, with the new value. A resulting value of zero removes the entry.
+	 */
+	enum class DuplicatePolicy {
+		/**
+		 * The value inserted last wins.
+		 */
+		overwrite,
+		/**
+		 * The values are summed up.
+		 */
+		sum,
+		/**
+		 * The maximal value wins.
+		 */
+		max
+	};
+
+	/**
+	 * Combines the value of a key that is already present with a new value.
+	 * @param policy the duplicate policy
+	 * @param present value that is already present
+	 * @param added new value
+	 * @return the combined value
+	 */
+	template<typename value_type>
+	value_type combineDuplicate(DuplicatePolicy policy, value_type present, value_type added) {
+		switch (policy) {
+			case DuplicatePolicy::sum:
+				if constexpr (std::is_same_v<value_type, bool>)
+					return present or added;
+				else
+					return present + added;
+			case DuplicatePolicy::max:
+				return std::max(present, added);
+			default:
+				return added;
+		}
+	}
+}// namespace hypertrie::internal::raw
+
+#endif//HYPERTRIE_DUPLICATEPOLICY_HPP
@@ -0,0 +1,148 @@
+#ifndef HYPERTRIE_MEMORYSTATS_HPP
+#define HYPERTRIE_MEMORYSTATS_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+namespace hypertrie::internal::raw {
+
+	/**
+	 * Memory used by the nodes of one depth and compression.
+	 */
+	struct NodeMemoryStats {
+		/**
+		 * Number of unique nodes.
+		 */
+		std::size_t node_count = 0;
+		/**
+		 * Sum of the reference counts of the nodes.
+		 */
+		std::size_t ref_count_sum = 0;
+		/**
+		 * Bytes of the nodes themselves (sizeof(Node) * node_count). They include the inline part of the edge containers.
+		 */
+		std::size_t node_bytes = 0;
+		/**
+		 * Estimated heap bytes owned by the edge containers of uncompressed nodes. See container::heapBytes.
+		 */
+		std::size_t edge_bytes = 0;
+		/**
+		 * Bytes of key parts. Compressed nodes store a full key, uncompressed nodes one key part per edge.
+		 * They are part of node_bytes or edge_bytes.
+		 */
+		std::size_t key_bytes = 0;
+		/**
+		 * Bytes of the slots of the NodeTable that indexes the nodes.
+		 */
+		std::size_t table_bytes = 0;
+		/**
+		 * Bytes requested by the slab allocator of the nodes. They include node_bytes and slots that are free.
+		 */
+		std::size_t allocator_bytes = 0;
+
+		/**
+		 * Bytes that are attributed to this kind of nodes: allocator, table and edge containers.
+		 */
+		[[nodiscard]] std::size_t totalBytes() const noexcept {
+			return allocator_bytes + table_bytes + edge_bytes;
+		}
+
+		/**
+		 * Number of references per unique node. A ratio of 1 means that no node is shared.
+		 */
+		[[nodiscard]] double dedupRatio() const noexcept {
+			return (node_count == 0) ? 0.0 : double(ref_count_sum) / double(node_count);
+		}
+
+		NodeMemoryStats &operator+=(const NodeMemoryStats &other) noexcept {
+			node_count += other.node_count;
+			ref_count_sum += other.ref_count_sum;
+			node_bytes += other.node_bytes;
+			edge_bytes += other.edge_bytes;
+			key_bytes += other.key_bytes;
+			table_bytes += other.table_bytes;
+			allocator_bytes += other.allocator_bytes;
+			return *this;
+		}
+
+		NodeMemoryStats &operator-=(const NodeMemoryStats &other) noexcept {
+			node_count -= other.node_count;
+			ref_count_sum -= other.ref_count_sum;
+			node_bytes -= other.node_bytes;
+			edge_bytes -= other.edge_bytes;
+			key_bytes -= other.key_bytes;
+			table_bytes -= other.table_bytes;
+			allocator_bytes -= other.allocator_bytes;
+			return *this;
+		}
+
+		bool operator==(const NodeMemoryStats &other) const noexcept {
+			return node_count == other.node_count and ref_count_sum == other.ref_count_sum and
+				   node_bytes == other.node_bytes and edge_bytes == other.edge_bytes and key_bytes == other.key_bytes and
+				   table_bytes == other.table_bytes and allocator_bytes == other.allocator_bytes;
+		}
+	};
+
+	/**
+	 * Memory used by the nodes of one depth.
+	 */
+	struct LevelMemoryStats {
+		std::size_t depth = 0;
+		NodeMemoryStats compressed{};
+		NodeMemoryStats uncompressed{};
+
+		[[nodiscard]] NodeMemoryStats total() const noexcept {
+			NodeMemoryStats sum = compressed;
+			sum += uncompressed;
+			return sum;
+		}
+	};
+
+	/**
+	 * Memory report of a node storage. It has an entry per depth, ordered from depth 1 upwards.
+	 */
+	struct MemoryStats {
+		std::vector<LevelMemoryStats> levels{};
+
+		[[nodiscard]] NodeMemoryStats total() const noexcept {
+			NodeMemoryStats sum{};
+			for (const auto &level : levels)
+				sum += level.total();
+			return sum;
+		}
+
+		explicit operator std::string() const {
+			fmt::memory_buffer out;
+			fmt::format_to(out, "{:>5} {:>12} {:>10} {:>10} {:>12} {:>12} {:>12} {:>12} {:>12} {:>12}\n",
+						   "depth", "compression", "nodes", "refs/node", "node bytes", "edge bytes", "key bytes", "table bytes", "alloc bytes", "total bytes");
+			auto format_row = [&](const std::string &depth, const std::string &compression, const NodeMemoryStats &stats) {
+				fmt::format_to(out, "{:>5} {:>12} {:>10} {:>10.3f} {:>12} {:>12} {:>12} {:>12} {:>12} {:>12}\n",
+							   depth, compression, stats.node_count, stats.dedupRatio(), stats.node_bytes, stats.edge_bytes,
+							   stats.key_bytes, stats.table_bytes, stats.allocator_bytes, stats.totalBytes());
+			};
+			for (const auto &level : levels) {
+				format_row(std::to_string(level.depth), "compressed", level.compressed);
+				format_row(std::to_string(level.depth), "uncompressed", level.uncompressed);
+			}
+			format_row("all", "", total());
+			return fmt::to_string(out);
+		}
+	};
+}// namespace hypertrie::internal::raw
+
+template<>
+struct fmt::formatter<hypertrie::internal::raw::MemoryStats> {
+	auto parse(format_parse_context &ctx) {
+		return ctx.begin();
+	}
+
+	template<typename FormatContext>
+	auto format(const hypertrie::internal::raw::MemoryStats &stats, FormatContext &ctx) {
+		return fmt::format_to(ctx.out(), "{}", (std::string) stats);
+	}
+};
+
+#endif//HYPERTRIE_MEMORYSTATS_HPP
@@ -1,11 +1,16 @@
 #ifndef HYPERTRIE_NODECONTEXT_HPP
 #define HYPERTRIE_NODECONTEXT_HPP
 
+#include <algorithm>
+#include <array>
+#include <bitset>
 #include <compare>
+#include <stdexcept>
 
 #include "Dice/hypertrie/internal/Hypertrie_traits.hpp"
 #include "Dice/hypertrie/internal/raw/node/NodeContainer.hpp"
 #include "Dice/hypertrie/internal/raw/node/TensorHash.hpp"
+#include "Dice/hypertrie/internal/raw/storage/DuplicatePolicy.hpp"
 #include "Dice/hypertrie/internal/raw/storage/NodeStorage.hpp"
 #include "Dice/hypertrie/internal/raw/storage/RekNodeModification.hpp"
 #include "Dice/hypertrie/internal/util/CONSTANTS.hpp"
@@ -55,7 +60,7 @@ namespace hypertrie::internal::raw {
 				return;// there is no real node to be counted
 			else {
 				assert(nodec.ref_count() > 0);
-				nodec.ref_count()++;
+				storage.template changeRefCount<depth>(nodec, 1);
 			}
 		}
 		template<size_t depth>
@@ -98,7 +103,370 @@ namespace hypertrie::internal::raw {
 		}
 
 		/**
-		 * Resolves a keypart by a given position
+		 * Removes keys. Keys that are not contained are ignored.
+		 * Nodes that are not referenced anymore are removed from the storage.
+		 * The present values are looked up in one walk over the node (see filter_contained) and all keys are removed in
+		 * a single modification, so nodes that are affected by multiple keys are rewritten once.
+		 * @tparam depth
+		 * @param nodec
+		 * @param keys
+		 */
+		template<size_t depth>
+		void bulk_remove(NodeContainer<depth, tri> &nodec, std::vector<RawKey<depth>> keys) {
+			using red = RawEntry_t<depth, tri>;
+			if (nodec.empty() or keys.empty())
+				return;
+			std::sort(keys.begin(), keys.end());
+			keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+			std::vector<value_type> present(keys.size(), value_type{});
+			lookupSorted<depth, depth>(nodec, keys, 0, keys.size(), present);
+			std::vector<typename red::RawEntry> entries;
+			entries.reserve(keys.size());
+			for (size_t i = 0; i < keys.size(); ++i)
+				if (present[i] != value_type{})
+					entries.push_back(red::make_Entry(keys[i], present[i]));
+			keys.clear();
+			keys.shrink_to_fit();
+			RekNodeModification<max_depth, depth, tri> update{this->storage, nodec};
+			update.apply_remove(std::move(entries));
+		}
+
+		/**
+		 * Removes the keys that are contained in the node from keys. The remaining keys are sorted and pairwise distinct.
+		 * Instead of looking up every key on its own, the node structure is walked once: the sorted keys are grouped by their
+		 * key part at position 0 and the child of each group is resolved once.
+		 * @tparam depth depth of the node container
+		 * @param nodec the node container
+		 * @param keys the keys to be filtered
+		 */
+		template<size_t depth>
+		void filter_contained(const NodeContainer<depth, tri> &nodec, std::vector<RawKey<depth>> &keys) {
+			std::sort(keys.begin(), keys.end());
+			keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+			if (nodec.empty() or keys.empty())
+				return;
+			std::vector<value_type> values(keys.size(), value_type{});
+			lookupSorted<depth, depth>(nodec, keys, 0, keys.size(), values);
+			size_t kept = 0;
+			for (size_t i = 0; i < keys.size(); ++i)
+				if (values[i] == value_type{})
+					keys[kept++] = keys[i];
+			keys.resize(kept);
+		}
+
+		/**
+		 * Sets the values of many keys at once. Values of keys that occur multiple times in entries are combined in the order
+		 * of entries, the result is combined with the value that is already present in the node. Both use policy.
+		 * Keys that end up with value zero are removed.
+		 * The present values are looked up in one walk over the node (see filter_contained). New, removed and changed entries
+		 * are applied in a single modification, so every node is rewritten at most once. Entries that keep their key change
+		 * their value in place.
+		 * @tparam depth depth of the node container
+		 * @param nodec the node container
+		 * @param entries pairs of key and value
+		 * @param policy how values of the same key are combined
+		 */
+		template<size_t depth>
+		void bulk_set(NodeContainer<depth, tri> &nodec, std::vector<std::pair<RawKey<depth>, value_type>> entries,
+					  DuplicatePolicy policy = DuplicatePolicy::overwrite) {
+			using red = RawEntry_t<depth, tri>;
+			std::stable_sort(entries.begin(), entries.end(),
+							 [](const auto &left, const auto &right) { return left.first < right.first; });
+			std::vector<RawKey<depth>> keys;
+			std::vector<value_type> added;
+			keys.reserve(entries.size());
+			added.reserve(entries.size());
+			for (const auto &[key, value] : entries) {
+				if (not keys.empty() and keys.back() == key)
+					added.back() = combineDuplicate<value_type>(policy, added.back(), value);
+				else {
+					keys.push_back(key);
+					added.push_back(value);
+				}
+			}
+			entries.clear();
+			entries.shrink_to_fit();
+
+			std::vector<value_type> present(keys.size(), value_type{});
+			if (not nodec.empty())
+				lookupSorted<depth, depth>(nodec, keys, 0, keys.size(), present);
+
+			std::vector<typename red::RawEntry> removed;
+			std::vector<typename red::RawEntry> inserted;
+			for (size_t i = 0; i < keys.size(); ++i) {
+				const value_type result = (present[i] == value_type{}) ? added[i] : combineDuplicate<value_type>(policy, present[i], added[i]);
+				if (result == present[i])
+					continue;
+				if (present[i] != value_type{})
+					removed.push_back(red::make_Entry(keys[i], present[i]));
+				if (result != value_type{})
+					inserted.push_back(red::make_Entry(keys[i], result));
+			}
+			// a changed entry is removed with its present value and inserted with its result
+			RekNodeModification<max_depth, depth, tri> update{this->storage, nodec};
+			update.apply_changes(std::move(removed), std::move(inserted));
+		}
+
+	private:
+		/**
+		 * Writes the values of the keys in [begin, end) to values. Keys that are not contained are left untouched. The keys
+		 * must be sorted and must share the key parts before offset = key_depth - depth. Those key parts lead to the node.
+		 */
+		template<size_t depth, size_t key_depth>
+		void lookupSorted(const NodeContainer<depth, tri> &nodec, const std::vector<RawKey<key_depth>> &keys,
+						  size_t begin, size_t end, std::vector<value_type> &values) {
+			static constexpr size_t offset = key_depth - depth;
+			if (nodec.empty())
+				return;
+			if (nodec.isCompressed()) {
+				if constexpr (not(depth == 1 and tri::is_lsb_unused and tri::is_bool_valued)) {
+					const auto *node = nodec.compressed_node();
+					const auto &node_key = node->key();
+					for (size_t i = begin; i < end; ++i)
+						if (std::equal(node_key.begin(), node_key.end(), keys[i].begin() + offset)) {
+							if constexpr (tri::is_bool_valued)
+								values[i] = true;
+							else
+								values[i] = node->value();
+						}
+				}
+				return;
+			}
+			UncompressedNodeContainer<depth, tri> nc = nodec.uncompressed();
+			if constexpr (depth == 1) {
+				for (size_t i = begin; i < end; ++i)
+					values[i] = this->template getChild<1>(nc, 0UL, keys[i][offset]);
+			} else {
+				size_t group_begin = begin;
+				while (group_begin < end) {
+					const key_part_type key_part = keys[group_begin][offset];
+					size_t group_end = group_begin + 1;
+					while (group_end < end and keys[group_end][offset] == key_part)
+						++group_end;
+					NodeContainer<depth - 1, tri> child = this->template getChild<depth>(nc, 0, key_part);
+					if constexpr (depth == 2 and tri::is_lsb_unused and tri::is_bool_valued) {
+						if (not child.empty() and child.isCompressed()) {// here, we have an KeyPart stored instead of a hash
+							for (size_t i = group_begin; i < group_end; ++i)
+								values[i] = keys[i][offset + 1] == child.hash().getKeyPart();
+							group_begin = group_end;
+							continue;
+						}
+					}
+					lookupSorted<depth - 1, key_depth>(child, keys, group_begin, group_end, values);
+					group_begin = group_end;
+				}
+			}
+		}
+
+	public:
+		/**
+		 * Builds the edges at pos of an uncompressed node if they were not built yet (see NodeStorage::indexedPositions).
+		 * The children reachable via pos are added to the storage. The node itself is not changed otherwise.
+		 * It modifies the node, so it must only be called by the writer (see NodeStorage::pin). Reads never build indexes.
+		 * @tparam depth the depth of the node container
+		 * @param nodec the node container, must be a uncompressed node
+		 * @param pos the position to be indexed
+		 */
+		template<size_t depth>
+		void indexPosition(UncompressedNodeContainer<depth, tri> &nodec, size_t pos) {
+			assert(pos < depth);
+			if constexpr (depth > 1) {
+				if (not nodec.uncompressed_node()->isIndexed(pos)) {
+					RekNodeModification<max_depth, depth, tri> update{this->storage, nodec};
+					update.apply_index_position(pos);
+				}
+			}
+		}
+
+		/**
+		 * Sets the positions that are indexed in new uncompressed nodes of the given depth and builds the missing indexes
+		 * at these positions in the existing nodes of that depth. It must only be called by the writer.
+		 * @tparam depth depth of the nodes
+		 * @param positions bitset of positions to be indexed. Position 0 is always indexed.
+		 */
+		template<size_t depth>
+		void indexPositions(std::bitset<depth> positions) {
+			storage.template indexedPositions<depth>(positions);
+			if constexpr (depth > 1) {
+				// new children are only added to the storages of lower depths, so the nodes of this depth can be iterated meanwhile
+				for (auto &[hash, node] : storage.template getNodeStorage<depth, NodeCompression::uncompressed>()) {
+					UncompressedNodeContainer<depth, tri> nodec{hash, node};
+					for (const size_t pos : iter::range(1UL, depth))
+						if (positions[pos])
+							indexPosition<depth>(nodec, pos);
+				}
+			}
+		}
+
+		/**
+		 * Get the number of distinct key parts at the given positions of an uncompressed node.
+		 * Positions that are not indexed are counted by a scan through position 0.
+		 * @tparam depth the depth of the node container
+		 * @param nodec the node container, must be a uncompressed node
+		 * @param positions the positions
+		 * @return the number of distinct key parts for each position
+		 */
+		template<size_t depth>
+		std::vector<size_t> getCards(const UncompressedNodeContainer<depth, tri> &nodec, const std::vector<pos_type> &positions) {
+			const auto *node = nodec.uncompressed_node();
+			std::vector<size_t> cards(positions.size());
+			std::vector<key_part_type> key_parts;
+			for (const auto [i, pos] : iter::enumerate(positions)) {
+				assert(pos < depth);
+				if (node->isIndexed(pos)) {
+					cards[i] = node->edges(pos).size();
+				} else {
+					key_parts.clear();
+					collectKeyParts<depth>(nodec, pos, key_parts);
+					std::sort(key_parts.begin(), key_parts.end());
+					cards[i] = size_t(std::unique(key_parts.begin(), key_parts.end()) - key_parts.begin());
+				}
+			}
+			return cards;
+		}
+
+	private:
+		/**
+		 * Appends the key parts at pos of all entries of a node. Duplicates are not removed.
+		 * If pos is not indexed, the children at position 0 are scanned.
+		 */
+		template<size_t depth>
+		void collectKeyParts(const NodeContainer<depth, tri> &nodec, size_t pos, std::vector<key_part_type> &key_parts) {
+			if (nodec.isCompressed()) {
+				// compressed children of depth 1 with an unused lsb are resolved by the caller
+				if constexpr (not(depth == 1 and tri::is_bool_valued and tri::is_lsb_unused))
+					key_parts.push_back(nodec.compressed_node()->key()[pos]);
+			} else if constexpr (depth == 1) {
+				for (const auto &edge : nodec.uncompressed_node()->edges(0)) {
+					if constexpr (tri::is_bool_valued)
+						key_parts.push_back(edge);
+					else
+						key_parts.push_back(edge.first);
+				}
+			} else {
+				const auto *node = nodec.uncompressed_node();
+				if (node->isIndexed(pos)) {
+					for (const auto &[key_part, child] : node->edges(pos))
+						key_parts.push_back(key_part);
+					return;
+				}
+				for (const auto &[key_part, child] : node->edges(0)) {
+					if constexpr (depth == 2 and tri::is_bool_valued and tri::is_lsb_unused) {
+						if (child.isCompressed())
+							key_parts.push_back(child.getKeyPart());
+						else
+							collectKeyParts<depth - 1>(storage.template getUncompressedNode<depth - 1>(child.getTaggedNodeHash()), pos - 1, key_parts);
+					} else {
+						collectKeyParts<depth - 1>(storage.template getNode<depth - 1>(child), pos - 1, key_parts);
+					}
+				}
+			}
+		}
+
+		/**
+		 * Calls consume(key, value) for all entries of a node. Only the children at position 0 are visited.
+		 */
+		template<size_t depth, typename Consume>
+		void scanEntries(const NodeContainer<depth, tri> &nodec, Consume &consume) {
+			if (nodec.empty())
+				return;
+			if (nodec.isCompressed()) {
+				if constexpr (depth == 1 and tri::is_bool_valued and tri::is_lsb_unused)
+					consume(RawKey<1>{nodec.hash().getKeyPart()}, true);
+				else
+					consume(nodec.compressed_node()->key(), nodec.compressed_node()->value());
+			} else if constexpr (depth == 1) {
+				for (const auto &edge : nodec.uncompressed_node()->edges(0)) {
+					if constexpr (tri::is_bool_valued)
+						consume(RawKey<1>{edge}, true);
+					else
+						consume(RawKey<1>{edge.first}, edge.second);
+				}
+			} else {
+				for (const auto &[key_part, child] : nodec.uncompressed_node()->edges(0)) {
+					auto consume_child = [&](const RawKey<depth - 1> &sub_key, value_type value) {
+						RawKey<depth> key;
+						key[0] = key_part;
+						std::copy(sub_key.begin(), sub_key.end(), key.begin() + 1);
+						consume(key, value);
+					};
+					if constexpr (depth == 2 and tri::is_bool_valued and tri::is_lsb_unused) {
+						if (child.isCompressed())
+							consume_child(RawKey<1>{child.getKeyPart()}, true);
+						else
+							scanEntries<depth - 1>(storage.template getUncompressedNode<depth - 1>(child.getTaggedNodeHash()), consume_child);
+					} else {
+						scanEntries<depth - 1>(storage.template getNode<depth - 1>(child), consume_child);
+					}
+				}
+			}
+		}
+
+		/**
+		 * Slicing by a position that is not indexed needs children that do not exist. They are only created by the writer.
+		 */
+		template<size_t depth>
+		static void requireIndexed(const UncompressedNode<depth, tri> *node, size_t pos) {
+			if constexpr (depth > 1)
+				if (not node->isIndexed(pos))
+					throw std::logic_error{"The position is not indexed. Its children are only created by the writer (see HypertrieContext::setIndexedPositions)."};
+		}
+
+		template<size_t depth>
+		bool allPositionsIndexed(size_t min_depth) const {
+			if constexpr (depth < 2)
+				return true;
+			else
+				return depth < min_depth or (storage.template indexedPositions<depth>().all() and allPositionsIndexed<depth - 1>(min_depth));
+		}
+
+	public:
+		/**
+		 * Entries of a sub-tensor that is not in the node storage (see slice).
+		 */
+		template<size_t depth>
+		using SliceEntries = std::vector<typename RawEntry_t<depth, tri>::RawEntry>;
+
+		/**
+		 * Calls consume(key, value) for all entries of a node. It descends only through position 0, so it works for any
+		 * indexed positions. Nothing is written to the node storage.
+		 * @tparam depth the depth of the node container
+		 * @param nodec the node container
+		 * @param consume called with a RawKey<depth> and a value_type for each entry
+		 */
+		template<size_t depth, typename Consume>
+		void forEachEntry(const NodeContainer<depth, tri> &nodec, Consume &&consume) {
+			scanEntries<depth>(nodec, consume);
+		}
+
+		/**
+		 * Checks if a diagonal of a node can be resolved by indexed positions (see HashDiagonal). The first diagonal
+		 * position must be indexed in the node itself and all positions must be indexed at the lower depths the diagonal
+		 * descends to. An uncompressed node indexes at least the positions that are set for its depth
+		 * (see NodeStorage::indexedPositions), so the lower depths are checked by their settings.
+		 * @tparam depth the depth of the node container
+		 * @param nodec the node container
+		 * @param diagonal_positions the diagonal positions
+		 * @return if the diagonal only needs indexed positions
+		 */
+		template<size_t depth>
+		bool diagonalIndexed(const NodeContainer<depth, tri> &nodec, const DiagonalPositions<depth> &diagonal_positions) const {
+			if constexpr (depth == 1) {
+				return true;
+			} else {
+				if (nodec.empty() or nodec.isCompressed())
+					return true;
+				size_t first_pos = 0;
+				while (not diagonal_positions[first_pos])
+					++first_pos;
+				return nodec.uncompressed_node()->isIndexed(first_pos) and
+					   allPositionsIndexed<depth - 1>(depth - diagonal_positions.count() + 1);
+			}
+		}
+
+		/**
+		 * Resolves a keypart by a given position. The position must be indexed; otherwise, a std::logic_error is thrown.
+		 * Slices resolve positions that are not indexed by a scan instead (see slice).
 		 * @tparam depth the depth of the node container
 		 * @param nodec the node container, must be a uncompressed node
 		 * @param pos the position at which the key_part should be resolved
@@ -107,12 +475,19 @@ namespace hypertrie::internal::raw {
 		 * If depth is 1, a value_type is return
 		 */
 		template<size_t depth>
-		inline auto getChild(UncompressedNodeContainer<depth, tri> &nodec, size_t pos, key_part_type key_part)
+		inline auto getChild(const UncompressedNodeContainer<depth, tri> &nodec, size_t pos, key_part_type key_part)
 		-> std::conditional_t<(depth > 1), NodeContainer<depth - 1, tri>, value_type> {
 			assert(pos < depth);
 			if (nodec.empty())
 				return {};
-			else {
+			requireIndexed<depth>(nodec.uncompressed_node(), pos);
+			if constexpr (depth > 1 and tri::is_swizzled_edges and not(depth == 2 and tri::is_lsb_unused)) {
+				// resolve the edge stored in the node (not a copy) so the child pointer is cached there
+				if (auto [found, iter] = nodec.uncompressed_node()->find(pos, key_part); found)
+					return storage.template getNode<depth - 1>(iter->second);
+				else
+					return {};
+			} else {
 				auto child = nodec.getChildHashOrValue(pos, key_part);
 				if constexpr (depth == 2 and tri::is_lsb_unused and tri::is_bool_valued) {
 					if (child.isCompressed()) {
@@ -154,13 +529,13 @@ namespace hypertrie::internal::raw {
 			} else {
 				UncompressedNodeContainer<depth, tri> nc = nodec.uncompressed();
 				if constexpr (depth > 1) {
-					// TODO: implement minCardPos();
-					auto pos = 0;//minCardPos();
+					// descend through the smallest edge map. positions that are not indexed yet are not considered.
+					const size_t pos = nc.uncompressed_node()->minCardIndexedPos();
 					NodeContainer<depth - 1, tri> child = this->template getChild<depth>(nc, pos, key[pos]);
 					if (not child.empty()) {
 						if constexpr (depth == 2 and tri::is_lsb_unused and tri::is_bool_valued) {
 							if (child.isCompressed()) // here, we have an KeyPart stored instead of a hash
-								return key[1] == child.hash().getKeyPart();
+								return key[1 - pos] == child.hash().getKeyPart();
 						}
 						return get<depth - 1>(child, subkey(key, pos));
 					} else {
@@ -174,25 +549,133 @@ namespace hypertrie::internal::raw {
 		}
 
 
+		/**
+		 * Retrieves the values of many keys. It returns the same values as get, but the keys are resolved in batches of
+		 * GET_MANY_BATCH_SIZE, level by level: first the edges of all keys of a batch are probed and the node table slots
+		 * of their children are prefetched, then the children are resolved. So the cache misses of the keys of a batch
+		 * overlap instead of being paid one after another.
+		 * @tparam depth the depth of the node container
+		 * @param nodec the node container
+		 * @param keys the keys
+		 * @param set_value called with the index of a key in keys and its value. Every index is passed exactly once.
+		 */
+		template<size_t depth, typename SetValue>
+		void get_many(const NodeContainer<depth, tri> &nodec, const std::vector<RawKey<depth>> &keys, SetValue &&set_value) {
+			Batch<depth> batch;
+			for (size_t batch_start = 0; batch_start < keys.size(); batch_start += GET_MANY_BATCH_SIZE) {
+				batch.count = std::min(GET_MANY_BATCH_SIZE, keys.size() - batch_start);
+				for (size_t i = 0; i < batch.count; ++i) {
+					batch.nodecs[i] = nodec;
+					batch.keys[i] = keys[batch_start + i];
+					batch.indices[i] = batch_start + i;
+				}
+				getBatch<depth>(batch, set_value);
+			}
+		}
+
+	private:
+		static constexpr size_t GET_MANY_BATCH_SIZE = 16;
+
+		/**
+		 * Keys of a batch of get_many that are not resolved yet. Each of them is looked up in the node container of its lane.
+		 */
+		template<size_t depth>
+		struct Batch {
+			std::array<NodeContainer<depth, tri>, GET_MANY_BATCH_SIZE> nodecs;
+			std::array<RawKey<depth>, GET_MANY_BATCH_SIZE> keys;
+			/**
+			 * Indices of the keys in the keys passed to get_many.
+			 */
+			std::array<size_t, GET_MANY_BATCH_SIZE> indices;
+			size_t count = 0;
+		};
+
+		/**
+		 * Resolves one level of a batch and continues with the keys that are not resolved at this level.
+		 */
+		template<size_t depth, typename SetValue>
+		void getBatch(const Batch<depth> &batch, SetValue &set_value) {
+			if constexpr (depth == 1) {
+				for (size_t i = 0; i < batch.count; ++i)
+					set_value(batch.indices[i], get<1>(batch.nodecs[i], batch.keys[i]));
+			} else {
+				static constexpr const auto subkey = &tri::template subkey<depth>;
+				using Edge = typename UncompressedNode<depth, tri>::ChildType;
+
+				Batch<depth - 1> next;
+				std::array<const Edge *, GET_MANY_BATCH_SIZE> edges;
+				// probe the edges and prefetch the table slots of the children
+				for (size_t i = 0; i < batch.count; ++i) {
+					const NodeContainer<depth, tri> &nodec = batch.nodecs[i];
+					if (nodec.empty() or nodec.isCompressed()) {
+						set_value(batch.indices[i], get<depth>(nodec, batch.keys[i]));
+						continue;
+					}
+					const auto *node = nodec.uncompressed_node();
+					const size_t pos = node->minCardIndexedPos();
+					const auto [found, iter] = node->find(pos, batch.keys[i][pos]);
+					if (not found) {
+						set_value(batch.indices[i], value_type{});
+						continue;
+					}
+					const Edge &edge = iter->second;
+					if constexpr (depth == 2 and tri::is_lsb_unused and tri::is_bool_valued) {
+						if (edge.isCompressed()) {// here, we have an KeyPart stored instead of a hash
+							set_value(batch.indices[i], batch.keys[i][1 - pos] == edge.getKeyPart());
+							continue;
+						}
+						storage.template prefetchNode<depth - 1>(edge.getTaggedNodeHash());
+					} else if constexpr (tri::is_swizzled_edges) {
+						storage.template prefetchNode<depth - 1>(edge.tensorHash());
+					} else {
+						storage.template prefetchNode<depth - 1>(edge);
+					}
+					edges[next.count] = &edge;
+					next.keys[next.count] = subkey(batch.keys[i], pos);
+					next.indices[next.count] = batch.indices[i];
+					++next.count;
+				}
+				// resolve the children and prefetch them for the next level
+				for (size_t i = 0; i < next.count; ++i) {
+					if constexpr (depth == 2 and tri::is_lsb_unused and tri::is_bool_valued)
+						next.nodecs[i] = storage.template getUncompressedNode<depth - 1>(edges[i]->getTaggedNodeHash());
+					else
+						next.nodecs[i] = storage.template getNode<depth - 1>(*edges[i]);
+					__builtin_prefetch(next.nodecs[i].node());
+				}
+				getBatch<depth - 1>(next, set_value);
+			}
+		}
+
+	public:
+
 		/**
 		 * Returns a pair of a node container and a boolean which states if the pointed node is managed (true) or if it is unmanaged (false) and MUST be deleted by the user manually.
 		 * Only compressed nodes can be managed.
 		 * if fixed_depth == depth, just a scalar is returned
+		 *
+		 * The fixed positions are resolved in ascending order. If a node is reached that does not index the next one, the
+		 * rest of the slice is resolved by a scan of that node through position 0 (see forEachEntry): the matching
+		 * entries are written to scanned_entries and an empty node container is returned. Nothing is written to the node storage.
 		 * @tparam depth depth of the node container
 		 * @tparam fixed_keyparts number of fixed key_parts in the slice key
 		 * @param nodec a container with a node.
 		 * @param raw_slice_key the slice key
+		 * @param contextless_compressed_result if provided, an unmanaged compressed result is written to this node instead of a newly allocated one
+		 * @param scanned_entries receives the entries of a slice that is resolved by a scan. It must be provided if not all positions are indexed.
 		 * @return see above
 		 */
-		template<size_t depth, size_t fixed_keyparts>
-		auto slice(const NodeContainer<depth, tri> &nodec, RawSliceKey<fixed_keyparts> raw_slice_key)
+		template<size_t depth, size_t fixed_keyparts, typename ccn = std::nullptr_t>
+		auto slice(const NodeContainer<depth, tri> &nodec, RawSliceKey<fixed_keyparts> raw_slice_key, ccn contextless_compressed_result = nullptr,
+				   SliceEntries<depth - fixed_keyparts> *scanned_entries = nullptr)
 		-> std::conditional_t<(depth > fixed_keyparts), std::pair<NodeContainer<depth - fixed_keyparts, tri>,bool>, value_type> {
-			return slice_rek(nodec, raw_slice_key);
+			return slice_rek(nodec, raw_slice_key, contextless_compressed_result, scanned_entries);
 		}
 
 	private:
-		template<size_t current_depth, size_t fixed_keyparts, size_t slice_offset = 0>
-		auto slice_rek(const NodeContainer<current_depth, tri> &nodec, const RawSliceKey<fixed_keyparts> &raw_slice_key)
+		template<size_t current_depth, size_t fixed_keyparts, size_t slice_offset = 0, typename ccn = std::nullptr_t>
+		auto slice_rek(const NodeContainer<current_depth, tri> &nodec, const RawSliceKey<fixed_keyparts> &raw_slice_key, ccn contextless_compressed_result = nullptr,
+					   SliceEntries<current_depth - fixed_keyparts + slice_offset> *scanned_entries = nullptr)
 				-> std::conditional_t<(current_depth - fixed_keyparts + slice_offset > 0),
 				        std::pair<NodeContainer<current_depth - fixed_keyparts + slice_offset, tri>, bool>,
 				                value_type> {
@@ -203,11 +686,15 @@ namespace hypertrie::internal::raw {
 			else { // recursion
 				if (nodec.isUncompressed()){
 					auto uncompressed_nodec = nodec.uncompressed();
-					auto child = this->template getChild(uncompressed_nodec, raw_slice_key[slice_offset].pos - slice_offset, raw_slice_key[slice_offset].key_part);
+					const size_t pos = raw_slice_key[slice_offset].pos - slice_offset;
+					if constexpr (current_depth > 1)
+						if (not uncompressed_nodec.uncompressed_node()->isIndexed(pos))
+							return scanSlice<current_depth, fixed_keyparts, slice_offset>(nodec, raw_slice_key, scanned_entries);
+					auto child = this->template getChild(uncompressed_nodec, pos, raw_slice_key[slice_offset].key_part);
 					if (child.empty())
 						return {};
 					else
-						return slice_rek<current_depth - 1, fixed_keyparts, slice_offset +1> (child, raw_slice_key);
+						return slice_rek<current_depth - 1, fixed_keyparts, slice_offset +1> (child, raw_slice_key, contextless_compressed_result, scanned_entries);
 
 				} else { // nodec.isCompressed()
 					// check if key-parts match the slice key
@@ -232,7 +719,10 @@ namespace hypertrie::internal::raw {
 							return {};
 
 						} else {
-							nc.node() = new CompressedNode<result_depth, tri>();
+							if (contextless_compressed_result == nullptr)
+								nc.node() = new CompressedNode<result_depth, tri>();
+							else
+								nc.node() = contextless_compressed_result;
 							size_t slice_pos = 0;
 							size_t result_pos = 0;
 							for (auto nodec_pos : iter::range(current_depth)){
@@ -258,6 +748,192 @@ namespace hypertrie::internal::raw {
 			}
 		}
 
+		/**
+		 * Resolves the fixed key parts of raw_slice_key from slice_offset on by a scan of nodec (see slice).
+		 * A scalar result is looked up directly.
+		 */
+		template<size_t current_depth, size_t fixed_keyparts, size_t slice_offset>
+		auto scanSlice(const NodeContainer<current_depth, tri> &nodec, const RawSliceKey<fixed_keyparts> &raw_slice_key,
+					   SliceEntries<current_depth - fixed_keyparts + slice_offset> *scanned_entries)
+				-> std::conditional_t<(current_depth - fixed_keyparts + slice_offset > 0),
+									  std::pair<NodeContainer<current_depth - fixed_keyparts + slice_offset, tri>, bool>,
+									  value_type> {
+			constexpr static const size_t result_depth = current_depth - fixed_keyparts + slice_offset;
+			std::bitset<current_depth> fixed;
+			RawKey<current_depth> fixed_key{};
+			for (auto slice_key_i : iter::range(slice_offset, fixed_keyparts)) {
+				const size_t pos = raw_slice_key[slice_key_i].pos - slice_offset;
+				fixed[pos] = true;
+				fixed_key[pos] = raw_slice_key[slice_key_i].key_part;
+			}
+			if constexpr (result_depth == 0) {
+				return get<current_depth>(nodec, fixed_key);
+			} else {
+				using red = RawEntry_t<result_depth, tri>;
+				assert(scanned_entries != nullptr);
+				forEachEntry<current_depth>(nodec, [&](const RawKey<current_depth> &key, value_type value) {
+					RawKey<result_depth> result_key;
+					size_t result_pos = 0;
+					for (const size_t pos : iter::range(current_depth)) {
+						if (not fixed[pos])
+							result_key[result_pos++] = key[pos];
+						else if (key[pos] != fixed_key[pos])
+							return;
+					}
+					scanned_entries->push_back(red::make_Entry(result_key, value));
+				});
+				return {};
+			}
+		}
+
+		/**
+		 * Passes the entries of a scanned sub-tensor to the consumer of slice_many, grouped by their key part at sub_pos.
+		 */
+		template<size_t sub_depth, typename Consume>
+		static void consumeScanned(SliceEntries<sub_depth> &entries, size_t sub_pos, const std::vector<key_part_type> &key_parts, Consume &consume) {
+			using red = RawEntry_t<sub_depth, tri>;
+			constexpr static const size_t result_depth = sub_depth - 1;
+			const auto key_part_of = [&](const auto &entry) { return red::key(entry)[sub_pos]; };
+			std::erase_if(entries, [&](const auto &entry) { return not std::binary_search(key_parts.begin(), key_parts.end(), key_part_of(entry)); });
+			std::sort(entries.begin(), entries.end(), [&](const auto &left, const auto &right) { return key_part_of(left) < key_part_of(right); });
+			for (auto group_begin = entries.begin(); group_begin != entries.end();) {
+				const key_part_type key_part = key_part_of(*group_begin);
+				const auto group_end = std::find_if(group_begin, entries.end(), [&](const auto &entry) { return key_part_of(entry) != key_part; });
+				if constexpr (result_depth == 0) {
+					consume(key_part, red::value(*group_begin));
+				} else {
+					SliceEntries<result_depth> result;
+					result.reserve(size_t(group_end - group_begin));
+					for (auto iter = group_begin; iter != group_end; ++iter)
+						result.push_back(RawEntry_t<result_depth, tri>::make_Entry(tri::template subkey<sub_depth>(red::key(*iter), sub_pos), red::value(*iter)));
+					consume(key_part, std::move(result));
+				}
+				group_begin = group_end;
+			}
+		}
+
+	public:
+		/**
+		 * Slices a node once for each of many key parts at pos (IN-list). The fixed key parts of the slice key are
+		 * resolved once. Then the edges at pos of the reached node are probed for the key parts in batches, and the
+		 * children of a batch are prefetched before they are resolved.
+		 * @tparam depth depth of the node container
+		 * @tparam fixed_keyparts number of fixed key_parts in the slice key
+		 * @param nodec a container with a node.
+		 * @param raw_slice_key the slice key. It must not fix pos.
+		 * @param pos the position that is sliced with each of the key parts
+		 * @param key_parts the key parts. They must be sorted and distinct.
+		 * @param consume called in the order of key_parts for each key part with a non-empty result. The result is
+		 * passed in the form that slice returns it. An unmanaged compressed node is only valid during the call.
+		 * If the slice needs a position that is not indexed, the sub-tensor is scanned once instead (see slice) and the
+		 * result is passed as SliceEntries<depth - fixed_keyparts - 1>, or as a scalar if that depth is 0.
+		 */
+		template<size_t depth, size_t fixed_keyparts, typename Consume>
+		void slice_many(const NodeContainer<depth, tri> &nodec, const RawSliceKey<fixed_keyparts> &raw_slice_key, size_t pos,
+						const std::vector<key_part_type> &key_parts, Consume &&consume) {
+			static_assert(depth > fixed_keyparts);
+			constexpr static const size_t sub_depth = depth - fixed_keyparts;
+			constexpr static const size_t result_depth = sub_depth - 1;
+			assert(std::is_sorted(key_parts.begin(), key_parts.end()));
+			if (nodec.empty() or key_parts.empty())
+				return;
+			size_t sub_pos = pos;
+			for (auto i : iter::range(fixed_keyparts)) {
+				assert(raw_slice_key[i].pos != pos);
+				if (raw_slice_key[i].pos < pos)
+					--sub_pos;
+			}
+
+			CompressedNode<sub_depth, tri> compressed_sub_node;
+			SliceEntries<sub_depth> scanned_entries;
+			const NodeContainer<sub_depth, tri> sub_nodec = slice_rek<depth, fixed_keyparts>(nodec, raw_slice_key, &compressed_sub_node, &scanned_entries).first;
+			if (not scanned_entries.empty()) {
+				consumeScanned<sub_depth>(scanned_entries, sub_pos, key_parts, consume);
+				return;
+			}
+			if (sub_nodec.empty())
+				return;
+
+			if constexpr (result_depth == 0) {
+				if constexpr (tri::is_bool_valued and tri::is_lsb_unused) {
+					if (sub_nodec.isCompressed()) {// here, we have an KeyPart stored instead of a hash
+						if (const key_part_type key_part = sub_nodec.hash().getKeyPart(); std::binary_search(key_parts.begin(), key_parts.end(), key_part))
+							consume(key_part, true);
+						return;
+					}
+				}
+				for (const key_part_type key_part : key_parts)
+					if (value_type value = get<1>(sub_nodec, RawKey<1>{key_part}); value != value_type{})
+						consume(key_part, value);
+			} else if (sub_nodec.isCompressed()) {
+				// only the key part of the single entry can match
+				const auto *sub_node = sub_nodec.compressed_node();
+				const key_part_type key_part = sub_node->key()[sub_pos];
+				if (not std::binary_search(key_parts.begin(), key_parts.end(), key_part))
+					return;
+				CompressedNodeContainer<result_depth, tri> nc;
+				if constexpr (tri::is_bool_valued and tri::is_lsb_unused and (result_depth == 1)) {
+					nc.hash() = TaggedTensorHash<tri>(sub_node->key()[1 - sub_pos]);
+					consume(key_part, std::pair<NodeContainer<result_depth, tri>, bool>{nc, false});
+				} else {
+					CompressedNode<result_depth, tri> result_node;
+					result_node.key() = tri::template subkey<sub_depth>(sub_node->key(), sub_pos);
+					if constexpr (not tri::is_bool_valued)
+						result_node.value() = sub_node->value();
+					nc.node() = &result_node;
+					nc.hash() = TensorHash().addFirstEntry(result_node.key(), result_node.value());
+					consume(key_part, std::pair<NodeContainer<result_depth, tri>, bool>{nc, false});
+				}
+			} else {
+				using Edge = typename UncompressedNode<sub_depth, tri>::ChildType;
+				auto uncompressed_nodec = sub_nodec.uncompressed();
+				const auto *sub_node = uncompressed_nodec.uncompressed_node();
+				if (not sub_node->isIndexed(sub_pos)) {
+					forEachEntry<sub_depth>(sub_nodec, [&](const RawKey<sub_depth> &key, value_type value) {
+						scanned_entries.push_back(RawEntry_t<sub_depth, tri>::make_Entry(key, value));
+					});
+					consumeScanned<sub_depth>(scanned_entries, sub_pos, key_parts, consume);
+					return;
+				}
+
+				std::array<std::pair<key_part_type, const Edge *>, GET_MANY_BATCH_SIZE> edges;
+				for (size_t batch_start = 0; batch_start < key_parts.size(); batch_start += GET_MANY_BATCH_SIZE) {
+					const size_t batch_end = std::min(batch_start + GET_MANY_BATCH_SIZE, key_parts.size());
+					size_t found_count = 0;
+					// probe the edges and prefetch the table slots of the children
+					for (size_t i = batch_start; i < batch_end; ++i) {
+						const auto [found, iter] = sub_node->find(sub_pos, key_parts[i]);
+						if (not found)
+							continue;
+						const Edge &edge = iter->second;
+						if constexpr (result_depth == 1 and tri::is_lsb_unused and tri::is_bool_valued) {
+							if (edge.isUncompressed())
+								storage.template prefetchNode<result_depth>(edge.getTaggedNodeHash());
+						} else if constexpr (tri::is_swizzled_edges) {
+							storage.template prefetchNode<result_depth>(edge.tensorHash());
+						} else {
+							storage.template prefetchNode<result_depth>(edge);
+						}
+						edges[found_count++] = {key_parts[i], &edge};
+					}
+					// resolve the children
+					for (size_t i = 0; i < found_count; ++i) {
+						const auto &[key_part, edge] = edges[i];
+						NodeContainer<result_depth, tri> child;
+						if constexpr (result_depth == 1 and tri::is_lsb_unused and tri::is_bool_valued) {
+							if (edge->isCompressed())// here, we have an KeyPart stored instead of a hash
+								child = CompressedNodeContainer<result_depth, tri>{*edge, {}};
+							else
+								child = storage.template getUncompressedNode<result_depth>(edge->getTaggedNodeHash());
+						} else {
+							child = storage.template getNode<result_depth>(*edge);
+						}
+						consume(key_part, std::pair<NodeContainer<result_depth, tri>, bool>{child, true});
+					}
+				}
+			}
+		}
+
 	public:
 		template<size_t depth, size_t fixed_keyparts, size_t result_depth = depth - fixed_keyparts, typename ccn = std::nullptr_t >
 		auto diagonal_slice(const NodeContainer<depth, tri> &nodec,
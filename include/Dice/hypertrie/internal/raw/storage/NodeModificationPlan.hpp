@@ -4,6 +4,12 @@
 #include "Dice/hypertrie/internal/raw/Hypertrie_internal_traits.hpp"
 #include "Dice/hypertrie/internal/raw/node/TensorHash.hpp"
 #include "Dice/hypertrie/internal/raw/storage/Entry.hpp"
+#include "Dice/hypertrie/internal/util/PosType.hpp"
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <vector>
 
 
 namespace hypertrie::internal::raw {
@@ -17,11 +23,22 @@ namespace hypertrie::internal::raw {
 		INSERT_INTO_COMPRESSED_NODE,
 		INSERT_INTO_UNCOMPRESSED_NODE,
 		REMOVE_FROM_UC,
+		UPDATE_UC,
 	};
 
-	template<size_t depth, HypertrieInternalTrait tri_t>
+	/**
+	 * Plan of a modification of a node at depth.
+	 *
+	 * The entries of a plan are not copied. They are indices into a buffer of entries of the root of the modification,
+	 * which is at root_depth. The key of an entry at this depth consists of the key parts of the root key at keyPositions().
+	 * Keys are only materialized when they are hashed or stored in a node.
+	 * @tparam depth depth of the node
+	 * @tparam root_depth depth of the root of the modification
+	 */
+	template<size_t depth, HypertrieInternalTrait tri_t, size_t root_depth = depth>
 	class NodeModificationPlan {
 		static_assert(depth >= 1);
+		static_assert(depth <= root_depth);
 	public:
 		using tri = tri_t;
 		/// public definitions
@@ -29,18 +46,67 @@ namespace hypertrie::internal::raw {
 		using value_type = typename tri::value_type;
 		using RawKey = typename tri::template RawKey<depth>;
 
-		using red = RawEntry_t<depth, tri>;
+		using root_re = RawEntry_t<root_depth, tri>;
+
+		using RootEntry = typename root_re::RawEntry;
 
-		using Entry = typename red::RawEntry;
+		using entry_index_type = std::uint32_t;
+
+		using KeyPositions = std::array<pos_type, depth>;
 
 	private:
 
 		ModificationOperations mod_op_{};
 		TensorHash hash_before_{};
 		mutable TensorHash hash_after_{};
-		mutable std::vector<Entry> entries_{};
+		const std::vector<RootEntry> *root_entries_ = nullptr;
+		std::vector<entry_index_type> entries_{};
+		/**
+		 * Entries that are removed by UPDATE_UC. An entry that changes its value is removed with its old value and
+		 * inserted with its new value.
+		 */
+		std::vector<entry_index_type> removed_entries_{};
+		KeyPositions key_positions_{};
+		/**
+		 * Value of the entry before CHANGE_VALUE.
+		 */
+		value_type old_value_{};
+		/**
+		 * Number of entries of the node after REMOVE_FROM_UC or UPDATE_UC. If it is 1, the node becomes compressed.
+		 */
+		size_t size_after_ = 0;
+
+		NodeModificationPlan(const std::vector<RootEntry> *root_entries, const KeyPositions &key_positions) noexcept
+			: root_entries_(root_entries), key_positions_(key_positions) {}
+
+		template<size_t, HypertrieInternalTrait, size_t>
+		friend class NodeModificationPlan;
 
 	public:
+		NodeModificationPlan() = default;
+
+		/**
+		 * Creates a plan for the root of a modification.
+		 * @param root_entries buffer of the entries. It must outlive the plan and all plans derived from it.
+		 */
+		explicit NodeModificationPlan(const std::vector<RootEntry> *root_entries) noexcept : root_entries_(root_entries) {
+			static_assert(depth == root_depth);
+			for (size_t pos = 0; pos < depth; ++pos)
+				key_positions_[pos] = pos_type(pos);
+		}
+
+		/**
+		 * Creates an empty plan for a child of this node. Its keys do not contain the key part at pos.
+		 * @param pos the position of the key part that is removed
+		 */
+		auto childPlan(const size_t pos) const noexcept -> NodeModificationPlan<depth - 1, tri, root_depth> {
+			static_assert(depth > 1);
+			typename NodeModificationPlan<depth - 1, tri, root_depth>::KeyPositions child_key_positions;
+			for (size_t i = 0, j = 0; i < depth; ++i)
+				if (i != pos) child_key_positions[j++] = key_positions_[i];
+			return {root_entries_, child_key_positions};
+		}
+
 		ModificationOperations &modOp()  noexcept { return this->mod_op_;}
 
 		const ModificationOperations &modOp() const noexcept { return this->mod_op_;}
@@ -59,57 +125,94 @@ namespace hypertrie::internal::raw {
 
 		const TensorHash &hashAfter() const noexcept { return this->hash_after_;}
 
-		std::vector<Entry> &entries() noexcept { return this->entries_;}
+		/**
+		 * Indices of the entries in the buffer of root entries.
+		 */
+		std::vector<entry_index_type> &entries() noexcept { return this->entries_;}
+
+		const std::vector<entry_index_type> &entries() const noexcept { return this->entries_;}
+
+		/**
+		 * The positions of the root key that make up the keys at this depth.
+		 */
+		const KeyPositions &keyPositions() const noexcept { return this->key_positions_; }
+
+		const std::vector<RootEntry> *rootEntries() const noexcept { return this->root_entries_; }
+
+		size_t size() const noexcept { return this->entries_.size(); }
+
+		/**
+		 * Indices of the removed entries in the buffer of root entries. They are only used while planning and by UPDATE_UC.
+		 */
+		std::vector<entry_index_type> &removedEntries() noexcept { return this->removed_entries_;}
+
+		const std::vector<entry_index_type> &removedEntries() const noexcept { return this->removed_entries_;}
 
-		const std::vector<Entry> &entries() const noexcept { return this->entries_;}
+		size_t removedSize() const noexcept { return this->removed_entries_.size(); }
 
+		size_t &sizeAfter() noexcept { return this->size_after_; }
 
+		size_t sizeAfter() const noexcept { return this->size_after_; }
 
-		void addEntry(Entry entry) noexcept {
-			entries_.push_back(entry);
+		void addEntry(entry_index_type entry_index) noexcept {
+			entries_.push_back(entry_index);
 		}
 
-		void addEntry(RawKey key, const value_type  value) noexcept {
-			entries_.push_back(red::make_Entry(key, value));
+		void addRemovedEntry(entry_index_type entry_index) noexcept {
+			removed_entries_.push_back(entry_index);
 		}
 
-		void addKey(RawKey key) noexcept {
-			entries_.push_back({key});
+		key_part_type keyPart(const size_t i, const size_t pos) const noexcept {
+			return root_re::key((*root_entries_)[entries_[i]])[key_positions_[pos]];
 		}
 
+		RawKey key(const size_t i) const noexcept { return keyOf(entries_[i]); }
+
+		value_type value(const size_t i) const noexcept { return valueOf(entries_[i]); }
+
+		key_part_type removedKeyPart(const size_t i, const size_t pos) const noexcept {
+			return root_re::key((*root_entries_)[removed_entries_[i]])[key_positions_[pos]];
+		}
+
+		RawKey removedKey(const size_t i) const noexcept { return keyOf(removed_entries_[i]); }
+
+		value_type removedValue(const size_t i) const noexcept { return valueOf(removed_entries_[i]); }
+
 		value_type &oldValue() noexcept {
-			if constexpr (not tri::is_bool_valued){
-				assert(mod_op_ == ModificationOperations::CHANGE_VALUE);
-				entries_.resize(2);
-				return red::value(entries_[1]);
-			} else
-				assert(false);
+			assert(mod_op_ == ModificationOperations::CHANGE_VALUE);
+			return old_value_;
 		}
 
 		const value_type &oldValue() const noexcept {
-			if constexpr (not tri::is_bool_valued){
-				assert(mod_op_ == ModificationOperations::CHANGE_VALUE);
-				entries_.resize(2);
-				return red::value(entries_[1]);
-			} else
-				assert(false);
+			assert(mod_op_ == ModificationOperations::CHANGE_VALUE);
+			return old_value_;
 		}
 
-		RawKey &firstKey() noexcept { return red::key(entries_[0]); }
+		RawKey firstKey() const noexcept { return key(0); }
 
-		const RawKey &firstKey() const noexcept { return red::key(entries_[0]); }
+		value_type firstValue() const noexcept  { return value(0); }
 
-		value_type &firstValue() noexcept  { return red::value(entries_[0]); }
+	private:
+		RawKey keyOf(const entry_index_type entry_index) const noexcept {
+			const auto &root_key = root_re::key((*root_entries_)[entry_index]);
+			RawKey key;
+			for (size_t pos = 0; pos < depth; ++pos)
+				key[pos] = root_key[key_positions_[pos]];
+			return key;
+		}
 
-		value_type firstValue() const noexcept  { return red::value(entries_[0]); }
+		value_type valueOf(const entry_index_type entry_index) const noexcept {
+			return root_re::value((*root_entries_)[entry_index]);
+		}
 
-	private:
 		void calcHashAfter() const noexcept {
+			const auto key_of = [this](entry_index_type entry_index) { return keyOf(entry_index); };
+			const auto value_of = [this](entry_index_type entry_index) { return valueOf(entry_index); };
 			hash_after_ = hash_before_;
 			switch (mod_op_) {
 				case ModificationOperations::CHANGE_VALUE:
 					assert(not hash_before_.empty());
-					assert(entries_.size() == 2);
+					assert(entries_.size() == 1);
 					this->hash_after_.changeValue(firstKey(), oldValue(), firstValue());
 					break;
 				case ModificationOperations::NEW_COMPRESSED_NODE:{
@@ -121,16 +224,25 @@ namespace hypertrie::internal::raw {
 					[[fallthrough]];
 				case ModificationOperations::INSERT_INTO_UNCOMPRESSED_NODE:
 					assert(not hash_before_.empty());
-					for (const auto &entry : entries_)
-						hash_after_.addEntry(red::key(entry), red::value(entry));
+					hash_after_.addEntries(entries_.begin(), entries_.end(), key_of, value_of);
 					break;
 				case ModificationOperations::NEW_UNCOMPRESSED_NODE:
 					assert(hash_before_.empty());
 					assert(entries_.size() > 1);
 
 					hash_after_ = TensorHash::getCompressedNodeHash(firstKey(), firstValue());
-					for (auto entry_it = std::next(entries_.begin()); entry_it != entries_.end(); ++entry_it)
-						hash_after_.addEntry(red::key(*entry_it), red::value(*entry_it));
+					hash_after_.addEntries(std::next(entries_.begin()), entries_.end(), key_of, value_of);
+					break;
+				case ModificationOperations::REMOVE_FROM_UC:
+					assert(hash_before_.isUncompressed());
+					assert(size_after_ > 0);
+					hash_after_.removeEntries(entries_.begin(), entries_.end(), key_of, value_of, size_after_ == 1);
+					break;
+				case ModificationOperations::UPDATE_UC:
+					assert(hash_before_.isUncompressed());
+					assert(size_after_ > 1);
+					hash_after_.removeEntries(removed_entries_.begin(), removed_entries_.end(), key_of, value_of, false);
+					hash_after_.addEntries(entries_.begin(), entries_.end(), key_of, value_of);
 					break;
 				default:
 					assert(false);
@@ -1,46 +1,168 @@
 #ifndef HYPERTRIE_LEVELNODESTORAGE_HPP
 #define HYPERTRIE_LEVELNODESTORAGE_HPP
 
+#include "Dice/hypertrie/internal/container/ContainerMemory.hpp"
 #include "Dice/hypertrie/internal/raw/Hypertrie_internal_traits.hpp"
 #include "Dice/hypertrie/internal/raw/node/Node.hpp"
 #include "Dice/hypertrie/internal/raw/node/TensorHash.hpp"
+#include "Dice/hypertrie/internal/raw/storage/MemoryStats.hpp"
+#include "Dice/hypertrie/internal/raw/storage/NodeTable.hpp"
 #include "Dice/hypertrie/internal/util/CONSTANTS.hpp"
+#include "Dice/hypertrie/internal/util/EpochManager.hpp"
 #include "Dice/hypertrie/internal/util/IntegralTemplatedTuple.hpp"
+#include "Dice/hypertrie/internal/util/SlabAllocator.hpp"
+#include "Dice/hypertrie/internal/util/ThreadPool.hpp"
+
+#include <algorithm>
+#include <bitset>
+#include <memory>
+#include <type_traits>
 
 namespace hypertrie::internal::raw {
 
+	/**
+	 * Footprint of a single node: node count 1, its reference count and its node, edge and key bytes. Its edges are not
+	 * iterated. NodeTable sums it up for the nodes it contains.
+	 */
+	template<size_t depth, NodeCompression compression, HypertrieInternalTrait tri, typename enabled>
+	NodeMemoryStats nodeFootprint(const Node<depth, compression, tri, enabled> *node) {
+		using key_part_type = typename tri::key_part_type;
+		NodeMemoryStats stats{};
+		stats.node_count = 1;
+		stats.node_bytes = sizeof(Node<depth, compression, tri, enabled>);
+		stats.ref_count_sum = node->ref_count();
+		if constexpr (compression == NodeCompression::compressed) {
+			stats.key_bytes = depth * sizeof(key_part_type);
+		} else {
+			for (const size_t pos : iter::range(depth)) {
+				const auto &edges = node->edges(pos);
+				stats.edge_bytes += container::heapBytes(edges);
+				stats.key_bytes += edges.size() * sizeof(key_part_type);
+			}
+		}
+		return stats;
+	}
+
+	/**
+	 * Memory statistics of the nodes in a node table.
+	 * @param nodes node table
+	 * @param allocator slab allocator of the nodes
+	 * @param exact if the footprints of the nodes are summed up again instead of taking the running sums of the table
+	 * @return memory statistics of the nodes
+	 */
+	template<size_t depth, NodeCompression compression, HypertrieInternalTrait tri>
+	NodeMemoryStats nodeMemoryStats(const NodeTable<Node<depth, compression, tri>> &nodes,
+									const util::SlabAllocator<Node<depth, compression, tri>> &allocator,
+									const bool exact = false) {
+		NodeMemoryStats stats{};
+		if (exact)
+			for (const auto &[hash, node] : nodes)
+				stats += nodeFootprint(static_cast<const Node<depth, compression, tri> *>(node));
+		else
+			stats = nodes.footprint();
+		stats.table_bytes = nodes.capacity() * sizeof(typename NodeTable<Node<depth, compression, tri>>::value_type);
+		stats.allocator_bytes = allocator.allocatedBytes();
+		return stats;
+	}
+
 	template<size_t depth,
 			 HypertrieInternalTrait tri_t = Hypertrie_internal_t<>,
 			 typename = void>
 	struct LevelNodeStorage {
 		using tri = tri_t;
-		template<typename K, typename V>
-		using map_type = typename tri::template map_type<K, V*>;
-		using CompressedNodeMap = map_type<TensorHash, CompressedNode<depth, tri>>;
-		using UncompressedNodeMap = map_type<TensorHash, UncompressedNode<depth, tri>>;
-		// TODO: add "revision" for compressed_nodes_ and uncompressed_nodes_
-		// TODO: A node container must be updated if the revision does not fit the associated node storage
+		using CompressedNodeMap = NodeTable<CompressedNode<depth, tri>>;
+		using UncompressedNodeMap = NodeTable<UncompressedNode<depth, tri>>;
 	protected:
 		CompressedNodeMap compressed_nodes_;
 		UncompressedNodeMap uncompressed_nodes_;
 
+		util::SlabAllocator<CompressedNode<depth, tri>> compressed_allocator_;
+		util::SlabAllocator<UncompressedNode<depth, tri>> uncompressed_allocator_;
+
+		/**
+		 * Positions that are indexed in new uncompressed nodes of this level.
+		 */
+		std::bitset<depth> indexed_positions_ = std::bitset<depth>{}.set();
+
+		template<NodeCompression compression>
+		auto &allocator() {
+			if constexpr (compression == NodeCompression::compressed)
+				return compressed_allocator_;
+			else
+				return uncompressed_allocator_;
+		}
+
 	public:
 		~LevelNodeStorage() {
-			for(auto &[hash, node] : compressed_nodes_)
-				delete node;
-			for(auto &[hash, node] : uncompressed_nodes_)
-				delete node;
+			clear();
+		}
+
+		/**
+		 * Allocates a node of this level. The node is not added to the node maps.
+		 * @tparam compression compression of the node
+		 * @param args arguments forwarded to the node constructor
+		 * @return pointer to the new node
+		 */
+		template<NodeCompression compression, typename... Args>
+		Node<depth, compression, tri> *constructNode(Args &&...args) {
+			return allocator<compression>().construct(std::forward<Args>(args)...);
+		}
+
+		/**
+		 * Destructs a node of this level and frees its memory for reuse. The node must have been removed from the node maps before.
+		 * @tparam compression compression of the node
+		 * @param node pointer to the node
+		 */
+		template<NodeCompression compression>
+		void destroyNode(Node<depth, compression, tri> *node) {
+			allocator<compression>().destroy(node);
+		}
+
+		/**
+		 * Destructs all nodes of this level and releases the memory in bulk.
+		 */
+		void clear() {
+			if constexpr (not std::is_trivially_destructible_v<CompressedNode<depth, tri>>)
+				for (auto &[hash, node] : compressed_nodes_)
+					std::destroy_at(node);
+			for (auto &[hash, node] : uncompressed_nodes_)
+				std::destroy_at(node);
+			compressed_nodes_.clear();
+			uncompressed_nodes_.clear();
+			compressed_allocator_.release();
+			uncompressed_allocator_.release();
+		}
+
+		/**
+		 * Sets the epoch manager that the node tables retire replaced slot arrays to.
+		 */
+		void epochManager(util::EpochManager *epochs) noexcept {
+			compressed_nodes_.epochManager(epochs);
+			uncompressed_nodes_.epochManager(epochs);
 		}
 
 		const CompressedNodeMap &compressedNodes() const { return this->compressed_nodes_; }
 		CompressedNodeMap &compressedNodes() { return this->compressed_nodes_; }
 
+		/**
+		 * Memory used by the nodes of this level.
+		 * @param exact if the nodes are visited instead of taking the running sums of the node tables
+		 */
+		LevelMemoryStats memoryStats(const bool exact = false) const {
+			return {depth,
+					nodeMemoryStats<depth, NodeCompression::compressed, tri>(compressed_nodes_, compressed_allocator_, exact),
+					nodeMemoryStats<depth, NodeCompression::uncompressed, tri>(uncompressed_nodes_, uncompressed_allocator_, exact)};
+		}
+
+		const std::bitset<depth> &indexedPositions() const { return this->indexed_positions_; }
+		void indexedPositions(const std::bitset<depth> &positions) { this->indexed_positions_ = positions; }
+
 		const UncompressedNodeMap &uncompressedNodes() const { return this->uncompressed_nodes_; }
 		UncompressedNodeMap &uncompressedNodes() { return this->uncompressed_nodes_; }
 
 		template<NodeCompression compression>
-		static Node<depth, compression, tri> &deref(typename map_type<TensorHash, Node<depth, compression, tri>>::iterator &map_it) {
-			return *tri::template deref<TensorHash, Node<depth, compression, tri>*>(map_it);
+		static Node<depth, compression, tri> &deref(typename NodeTable<Node<depth, compression, tri>>::iterator &map_it) {
+			return *map_it->second;
 		}
 
 		explicit operator std::string() const {
@@ -54,25 +176,55 @@ namespace hypertrie::internal::raw {
 	template<HypertrieInternalTrait tri_t>
 	struct LevelNodeStorage<1, tri_t, std::enable_if_t<(tri_t::is_lsb_unused and tri_t::is_bool_valued)>> {
 		using tri = tri_t;
-		template<typename K, typename V>
-		using map_type = typename tri::template map_type<K, V*>;
-		using UncompressedNodeMap = map_type<TensorHash, UncompressedNode<1, tri>>;
+		using UncompressedNodeMap = NodeTable<UncompressedNode<1, tri>>;
 	protected:
 		UncompressedNodeMap uncompressed_nodes_;
 
+		util::SlabAllocator<UncompressedNode<1, tri>> uncompressed_allocator_;
+
 	public:
 		~LevelNodeStorage() {
-			for(auto &[hash, node] : uncompressed_nodes_)
-				delete node;
+			clear();
+		}
+
+		template<NodeCompression compression = NodeCompression::uncompressed, typename... Args>
+		UncompressedNode<1, tri> *constructNode(Args &&...args) {
+			static_assert(compression == NodeCompression::uncompressed);
+			return uncompressed_allocator_.construct(std::forward<Args>(args)...);
+		}
+
+		template<NodeCompression compression = NodeCompression::uncompressed>
+		void destroyNode(UncompressedNode<1, tri> *node) {
+			static_assert(compression == NodeCompression::uncompressed);
+			uncompressed_allocator_.destroy(node);
+		}
+
+		void clear() {
+			for (auto &[hash, node] : uncompressed_nodes_)
+				std::destroy_at(node);
+			uncompressed_nodes_.clear();
+			uncompressed_allocator_.release();
+		}
+
+		void epochManager(util::EpochManager *epochs) noexcept {
+			uncompressed_nodes_.epochManager(epochs);
 		}
 
 		const UncompressedNodeMap &uncompressedNodes() const { return this->uncompressed_nodes_; }
 		UncompressedNodeMap &uncompressedNodes() { return this->uncompressed_nodes_; }
 
+		/**
+		 * Memory used by the nodes of this level. There are no compressed nodes.
+		 * @param exact if the nodes are visited instead of taking the running sums of the node table
+		 */
+		LevelMemoryStats memoryStats(const bool exact = false) const {
+			return {1, {}, nodeMemoryStats<1, NodeCompression::uncompressed, tri>(uncompressed_nodes_, uncompressed_allocator_, exact)};
+		}
+
 		template <NodeCompression compression = NodeCompression::uncompressed>
-		static UncompressedNode<1, tri> &deref(typename map_type<TensorHash, UncompressedNode<1, tri>>::iterator &map_it) {
+		static UncompressedNode<1, tri> &deref(typename UncompressedNodeMap::iterator &map_it) {
 			assert(compression == NodeCompression::uncompressed);
-			return *tri::template deref<TensorHash, UncompressedNode<1, tri>*>(map_it);
+			return *map_it->second;
 		}
 
 		explicit operator std::string() const {
@@ -82,6 +234,14 @@ namespace hypertrie::internal::raw {
 		}
 	};
 
+	/**
+	 * The nodes of all depths.
+	 *
+	 * A single writer may modify the storage while other threads read it. Readers pin an epoch with pin() for the duration of a
+	 * read. Deleted nodes and replaced table slots are retired instead of being freed and are reclaimed at the end of each
+	 * modification, once no reader that could still reach them is pinned. Readers must only traverse nodes that the writer does not
+	 * modify while the read lasts: nodes that lose their last reference during a modification are reused in place.
+	 */
 	template<size_t max_depth,
 			 HypertrieInternalTrait tri_t = Hypertrie_internal_t<>,
 			 typename = typename std::enable_if_t<(max_depth >= 1)>>
@@ -110,8 +270,23 @@ namespace hypertrie::internal::raw {
 	private:
 		using storage_t = util::IntegralTemplatedTuple<NodeStorage_t, 1, max_depth>;
 
+		/**
+		 * Declared before storage_, so the slot arrays retired while storage_ is destructed are still freed.
+		 */
+		util::EpochManager epochs_;
+
 		storage_t storage_;
 
+		/**
+		 * Threads that apply the modifications of one depth. They are kept between modifications.
+		 */
+		util::ThreadPool modification_pool_{};
+
+		/**
+		 * If nodes that already exist for the hash after a planned modification are checked for hash collisions.
+		 */
+		bool verify_hashes_ = false;
+
 
 		// TODO: remove
 		template<size_t depth>
@@ -124,7 +299,50 @@ namespace hypertrie::internal::raw {
 			return this->storage_.template get<depth>();
 		}
 
+		template<size_t depth>
+		void connectEpochManager_rek() {
+			getStorage<depth>().epochManager(&epochs_);
+			if constexpr (depth > 1)
+				connectEpochManager_rek<depth - 1>();
+		}
+
 	public:
+		NodeStorage() {
+			connectEpochManager_rek<max_depth>();
+		}
+
+		NodeStorage(const NodeStorage &) = delete;
+
+		NodeStorage &operator=(const NodeStorage &) = delete;
+
+		~NodeStorage() {
+			// retired nodes are destroyed while their allocators still exist
+			epochs_.drain();
+		}
+
+		/**
+		 * Pins the current epoch for a reader. Nodes that are deleted while the guard is alive are not freed.
+		 * Lookups and traversals are safe while a single writer modifies the storage.
+		 * @return guard that ends the read when it is destructed
+		 */
+		[[nodiscard]] util::EpochManager::Guard pin() noexcept {
+			return epochs_.pin();
+		}
+
+		/**
+		 * Frees the deleted nodes that no pinned reader can reach anymore. Called by the writer after each modification.
+		 */
+		void reclaim() noexcept {
+			epochs_.reclaim();
+		}
+
+		/**
+		 * Number of deleted nodes and replaced slot arrays that are not freed yet.
+		 */
+		[[nodiscard]] size_t retiredCount() const noexcept {
+			return epochs_.retiredCount();
+		}
+
 		// TODO: private?
 		template<size_t depth, NodeCompression compression, typename = std::enable_if_t<(not (depth == 1 and tri_t::is_lsb_unused and tri_t::is_bool_valued and compression == NodeCompression::compressed))>>
 		auto &getNodeStorage() {
@@ -136,13 +354,8 @@ namespace hypertrie::internal::raw {
 
 		template<size_t depth, NodeCompression compression, typename = std::enable_if_t<(not (depth == 1 and tri_t::is_lsb_unused and tri_t::is_bool_valued and compression == NodeCompression::compressed))>>
 		SpecificNodeContainer<depth, compression, tri> getNode(const TensorHash &node_hash) {
-			auto &nodes = getNodeStorage<depth, compression>();
-			auto found = nodes.find(node_hash);
-			if (found != nodes.end())
-				if constexpr((depth == 1 and tri_t::is_lsb_unused and tri_t::is_bool_valued))
-					return {node_hash, &LevelNodeStorage<depth, tri>::deref(found)};
-				else
-					return {node_hash, &LevelNodeStorage<depth, tri>::template deref<compression>(found)};
+			if (auto *node = getNodeStorage<depth, compression>().lookup(node_hash); node != nullptr)
+				return {node_hash, node};
 			else
 				return {};
 		}
@@ -168,13 +381,206 @@ namespace hypertrie::internal::raw {
 			}
 		}
 
+		/**
+		 * Resolves the child node an edge points to. The pointer cached in the edge is used if it is still valid.
+		 * Otherwise, the node is looked up and the pointer is cached in the edge.
+		 * @tparam depth depth of the child node
+		 * @tparam compression compression of the child node
+		 * @param edge edge stored in the parent node
+		 * @return the child node
+		 */
+		template<size_t depth, NodeCompression compression, typename = std::enable_if_t<(not (depth == 1 and tri_t::is_lsb_unused and tri_t::is_bool_valued and compression == NodeCompression::compressed))>>
+		SpecificNodeContainer<depth, compression, tri> getNode(const SwizzledTensorHash &edge) {
+			const auto revision = getNodeStorage<depth, compression>().revision();
+			if (void *cached = edge.cachedNode(revision); cached != nullptr)
+				return {edge.tensorHash(), static_cast<Node<depth, compression, tri> *>(cached)};
+			auto nodec = getNode<depth, compression>(edge.tensorHash());
+			if (not nodec.null())
+				edge.cacheNode(nodec.node(), revision);
+			return nodec;
+		}
+
+		template<size_t depth, typename = std::enable_if_t<(not (depth == 1 and tri_t::is_lsb_unused and tri_t::is_bool_valued))>>
+		CompressedNodeContainer<depth, tri> getCompressedNode(const SwizzledTensorHash &edge) {
+			return getNode<depth, NodeCompression::compressed>(edge);
+		}
+
+		template<size_t depth>
+		UncompressedNodeContainer<depth, tri> getUncompressedNode(const SwizzledTensorHash &edge) {
+			return getNode<depth, NodeCompression::uncompressed>(edge);
+		}
+
+		template<size_t depth>
+		NodeContainer<depth, tri> getNode(const SwizzledTensorHash &edge) {
+			if (edge.isCompressed()) {
+				assert(not (depth == 1 and tri_t::is_lsb_unused and tri_t::is_bool_valued));
+				if constexpr(not (depth == 1 and tri_t::is_lsb_unused and tri_t::is_bool_valued))
+					return getCompressedNode<depth>(edge);
+			} else {
+				return getUncompressedNode<depth>(edge);
+			}
+		}
+
+		/**
+		 * Hints the CPU to load the table slot of node_hash into the cache.
+		 * Call it for the next node to be looked up while the current one is processed.
+		 * @tparam depth depth of the node
+		 * @param node_hash hash of the node
+		 */
+		template<size_t depth>
+		void prefetchNode(const TensorHash &node_hash) const noexcept {
+			if (node_hash.isCompressed()) {
+				if constexpr (not(depth == 1 and tri_t::is_lsb_unused and tri_t::is_bool_valued))
+					getStorage<depth>().compressedNodes().prefetch(node_hash);
+			} else {
+				getStorage<depth>().uncompressedNodes().prefetch(node_hash);
+			}
+		}
+
+		/**
+		 * Looks up multiple nodes of the same depth and compression at once. The lookups of a batch are prefetched and overlap.
+		 * @tparam depth depth of the nodes
+		 * @tparam compression compression of the nodes
+		 * @param node_hashes hashes of the nodes
+		 * @param count number of hashes
+		 * @param nodes output. nodes[i] is the node of node_hashes[i] or nullptr if it does not exist.
+		 */
+		template<size_t depth, NodeCompression compression, typename = std::enable_if_t<(not (depth == 1 and tri_t::is_lsb_unused and tri_t::is_bool_valued and compression == NodeCompression::compressed))>>
+		void getNodes(const TensorHash *node_hashes, size_t count, Node<depth, compression, tri> **nodes) {
+			getNodeStorage<depth, compression>().findMany(node_hashes, count, nodes);
+		}
+
 	public:
+		/**
+		 * Allocates a node from the slab allocator of its depth and compression. The node is not added to the node storage.
+		 * @tparam depth depth of the node
+		 * @tparam compression compression of the node
+		 * @param args arguments forwarded to the node constructor
+		 * @return pointer to the new node
+		 */
+		template<size_t depth, NodeCompression compression, typename... Args>
+		Node<depth, compression, tri> *constructNode(Args &&...args) {
+			return getStorage<depth>().template constructNode<compression>(std::forward<Args>(args)...);
+		}
+
+		/**
+		 * Destructs a node that was allocated with constructNode and frees its memory for reuse.
+		 * The node must not be contained in the node storage anymore.
+		 * @tparam depth depth of the node
+		 * @tparam compression compression of the node
+		 * @param node pointer to the node
+		 */
+		template<size_t depth, NodeCompression compression>
+		void destroyNode(Node<depth, compression, tri> *node) {
+			getStorage<depth>().template destroyNode<compression>(node);
+		}
+
+		/**
+		 * Removes and destructs all nodes of all depths. The memory is released in bulk.
+		 * All NodeContainers pointing into this storage are invalid afterwards. No reader must be pinned.
+		 */
+		void clear() {
+			epochs_.drain();
+			clear_rek<max_depth>();
+			epochs_.drain();
+		}
+
+		/**
+		 * Reports the memory used by the nodes per depth and compression. The node tables keep running sums of their
+		 * nodes, so the cost is linear in max_depth only.
+		 * @return memory statistics ordered from depth 1 to max_depth
+		 */
+		MemoryStats memoryStats() const {
+			MemoryStats stats{};
+			stats.levels.reserve(max_depth);
+			memoryStats_rek<1>(stats, false);
+			return stats;
+		}
+
+		/**
+		 * Like memoryStats, but every node is visited. The cost is linear in the number of nodes. The edges of the nodes
+		 * are not iterated. The result equals memoryStats; it is meant for checking the running sums.
+		 * @return memory statistics ordered from depth 1 to max_depth
+		 */
+		MemoryStats exactMemoryStats() const {
+			MemoryStats stats{};
+			stats.levels.reserve(max_depth);
+			memoryStats_rek<1>(stats, true);
+			return stats;
+		}
+
+	private:
+		template<size_t depth>
+		void memoryStats_rek(MemoryStats &stats, const bool exact) const {
+			stats.levels.push_back(getStorage<depth>().memoryStats(exact));
+			if constexpr (depth < max_depth)
+				memoryStats_rek<depth + 1>(stats, exact);
+		}
+
+		template<size_t depth>
+		void clear_rek() {
+			getStorage<depth>().clear();
+			if constexpr (depth > 1)
+				clear_rek<depth - 1>();
+		}
+
+	public:
+		/**
+		 * Positions whose edges are populated in uncompressed nodes of the given depth that are created from now on.
+		 * Existing nodes keep their indexes. By default, all positions are indexed.
+		 * @tparam depth depth of the nodes
+		 */
+		template<size_t depth>
+		std::bitset<depth> indexedPositions() const {
+			if constexpr (depth == 1)
+				return std::bitset<depth>{}.set();
+			else
+				return getStorage<depth>().indexedPositions();
+		}
+
+		/**
+		 * Sets the positions whose edges are populated in uncompressed nodes of the given depth that are created from now on.
+		 * Edges of other positions are only built by NodeContext::indexPosition. Position 0 is always indexed.
+		 * @tparam depth depth of the nodes
+		 * @param positions bitset of positions to be indexed
+		 */
+		template<size_t depth>
+		void indexedPositions(std::bitset<depth> positions) {
+			if constexpr (depth > 1)
+				getStorage<depth>().indexedPositions(positions.set(0));
+		}
+
+		/**
+		 * Maximal number of threads that populate new uncompressed nodes of one depth in parallel. 1 means serial.
+		 */
+		size_t modificationThreads() const noexcept { return modification_pool_.threads(); }
+
+		/**
+		 * Sets the maximal number of threads that populate new uncompressed nodes of one depth in parallel.
+		 * The helper threads are started here and wait for modifications until the storage is destructed or resized.
+		 * @param threads number of threads including the modifying thread. 0 is treated as 1.
+		 */
+		void modificationThreads(size_t threads) { modification_pool_.resize(threads); }
+
+		/**
+		 * Threads that populate new uncompressed nodes of one depth in parallel. Only the writer runs jobs on them.
+		 */
+		util::ThreadPool &modificationPool() noexcept { return modification_pool_; }
+
+		/**
+		 * If a modification that results in a node that already exists checks that the existing node has the structure of
+		 * the result before it is shared. All nodes are verified before the storage is changed (see RekNodeModification::verifyPlan).
+		 */
+		bool verifyHashes() const noexcept { return verify_hashes_; }
+
+		void verifyHashes(bool verify) noexcept { verify_hashes_ = verify; }
+
 		template<size_t depth, typename = std::enable_if_t<(not (depth == 1 and tri_t::is_lsb_unused and tri_t::is_bool_valued))>>
 		CompressedNodeContainer<depth, tri> newCompressedNode(const RawKey<depth> &key, value_type value, size_t ref_count, TensorHash hash) {
 			auto &node_storage = getNodeStorage<depth, NodeCompression::compressed>();
 			auto [it, success] = [&]() {
-			  if constexpr(tri::is_bool_valued) return node_storage.insert({hash, new CompressedNode<depth, tri>{key, ref_count}});
-			  else return node_storage.insert({hash, new CompressedNode<depth, tri>{key, value, ref_count}}); 
+			  if constexpr(tri::is_bool_valued) return node_storage.insert({hash, constructNode<depth, NodeCompression::compressed>(key, ref_count)});
+			  else return node_storage.insert({hash, constructNode<depth, NodeCompression::compressed>(key, value, ref_count)});
 			}();
 			assert(success);
 			return CompressedNodeContainer<depth, tri>{hash, &LevelNodeStorage<depth, tri>::template deref<NodeCompression::compressed>(it)};
@@ -190,28 +596,29 @@ namespace hypertrie::internal::raw {
 			auto &nodes = getNodeStorage<depth, compression>();
 			assert(nc.hash() != new_hash);
 
-			auto [it, success] = [&]() {
-				if constexpr (keep_old) return nodes.insert({new_hash, new Node<depth, compression, tri>{*nc.template specific_node<compression>()}});
+			Node<depth, compression, tri> *node = [&]() {
+				if constexpr (keep_old) return constructNode<depth, compression>(*nc.template specific_node<compression>());
 				else
-					return nodes.insert({new_hash, nc.template specific_node<compression>()});// if the old is not kept it is moved
+					return nc.template specific_node<compression>();// if the old is not kept it is moved
 			}();
-			assert(success);
 			if constexpr (not keep_old) {
-				const auto removed = nodes.erase(nc.hash());
-				assert(removed);
-				it = nodes.find(new_hash);// iterator was invalidates by modifying nodes. get a new one
+				auto old_it = nodes.find(nc.hash());
+				assert(old_it != nodes.end());
+				nodes.eraseMoved(old_it);
 			}
-			auto &node = LevelNodeStorage<depth, tri>::template deref<compression>(it);
 			if constexpr (not tri::is_bool_valued) {
-				if constexpr (compression == NodeCompression::compressed) node.value() = new_value;
+				if constexpr (compression == NodeCompression::compressed) node->value() = new_value;
 				else
-					node.change_value(key, old_value, new_value);
+					node->change_value(key, old_value, new_value);
 			}
 			if constexpr (keep_old)
-				node.ref_count() = 0;
-			assert(node.ref_count() == 0);
-			node.ref_count() += count_diff;
-			return {new_hash, &node};
+				node->ref_count() = 0;
+			assert(node->ref_count() == 0);
+			node->ref_count() += count_diff;
+			// the node is inserted once it is changed, so its footprint is counted as it is
+			[[maybe_unused]] const bool success = nodes.insert({new_hash, node}).second;
+			assert(success);
+			return {new_hash, node};
 		}
 
 		template<size_t depth, NodeCompression compression, typename = std::enable_if_t<(not (depth == 1 and tri_t::is_lsb_unused and tri_t::is_bool_valued and compression == NodeCompression::compressed))>>
@@ -220,8 +627,40 @@ namespace hypertrie::internal::raw {
 			auto it = nodes.find(node_hash);
 			assert(it != nodes.end());
 			auto *node = &LevelNodeStorage<depth, tri>::template deref<compression>(it);
-			delete node;
 			nodes.erase(it);
+			retireNode<depth, compression>(node);
+		}
+
+		/**
+		 * Destroys a node that was removed from the node storage once no pinned reader can reach it anymore.
+		 * @tparam depth depth of the node
+		 * @tparam compression compression of the node
+		 * @param node pointer to the node
+		 */
+		template<size_t depth, NodeCompression compression>
+		void retireNode(Node<depth, compression, tri> *node) {
+			epochs_.retire(&getStorage<depth>(), node, [](void *level_storage, void *retired) {
+				static_cast<NodeStorage_t<depth> *>(level_storage)->template destroyNode<compression>(static_cast<Node<depth, compression, tri> *>(retired));
+			});
+		}
+
+		/**
+		 * Changes the reference count of a node in the storage. The reference count sum of its node table is kept up to date.
+		 * @return the new reference count
+		 */
+		template<size_t depth, NodeCompression compression, typename = std::enable_if_t<(not (depth == 1 and tri_t::is_lsb_unused and tri_t::is_bool_valued and compression == NodeCompression::compressed))>>
+		size_t changeRefCount(Node<depth, compression, tri> *node, const long diff) {
+			return getNodeStorage<depth, compression>().changeRefCount(node, diff);
+		}
+
+		template<size_t depth>
+		size_t changeRefCount(const NodeContainer<depth, tri> &nodec, const long diff) {
+			if (nodec.isCompressed()) {
+				assert(not (depth == 1 and tri_t::is_lsb_unused and tri_t::is_bool_valued));
+				if constexpr (not (depth == 1 and tri_t::is_lsb_unused and tri_t::is_bool_valued))
+					return changeRefCount<depth, NodeCompression::compressed>(nodec.compressed_node(), diff);
+			}
+			return changeRefCount<depth, NodeCompression::uncompressed>(nodec.uncompressed_node(), diff);
 		}
 
 		template<size_t depth>
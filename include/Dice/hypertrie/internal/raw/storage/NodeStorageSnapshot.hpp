@@ -0,0 +1,470 @@
+#ifndef HYPERTRIE_NODESTORAGESNAPSHOT_HPP
+#define HYPERTRIE_NODESTORAGESNAPSHOT_HPP
+
+#include "Dice/hypertrie/internal/raw/Hypertrie_internal_traits.hpp"
+#include "Dice/hypertrie/internal/raw/node/NodeContainer.hpp"
+#include "Dice/hypertrie/internal/raw/node/TensorHash.hpp"
+#include "Dice/hypertrie/internal/raw/storage/NodeStorage.hpp"
+
+#include <robin_hood.h>
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace hypertrie::internal::raw {
+
+	/**
+	 * A root node of a snapshot.
+	 */
+	struct SnapshotRoot {
+		size_t depth = 0;
+		TensorHash hash{};
+	};
+
+	/**
+	 * Header of a snapshot. Every field is written as a 64 bit unsigned integer in native byte order.
+	 */
+	struct SnapshotHeader {
+		static constexpr const std::uint64_t magic_number = 0x313050414E535448ULL;// "HTSNAP01"
+		static constexpr const std::uint64_t format_version = 1;
+
+		std::uint64_t magic = magic_number;
+		std::uint64_t version = format_version;
+		std::uint64_t max_depth = 0;
+		std::uint64_t key_part_size = 0;
+		std::uint64_t value_size = 0;
+		std::uint64_t bool_valued = 0;
+		std::uint64_t lsb_unused = 0;
+		/**
+		 * Hash of a fixed compressed node. The stored TensorHashes can only be reused if the loading process computes the same hash.
+		 */
+		std::uint64_t hash_fingerprint = 0;
+	};
+
+	/**
+	 * Writes and reads the nodes of a NodeStorage that are reachable from a set of root nodes.
+	 *
+	 * Layout after the header:
+	 *   roots: count, then depth and hash of each root
+	 *   per depth from max_depth down to 1:
+	 *     compressed nodes: count, then hash, key and (if not bool valued) value of each node
+	 *     uncompressed nodes: count, then hash of each node followed by
+	 *       depth > 1: size and indexed positions, then for each indexed position the edge count and the (key part, child hash) edges
+	 *       depth 1: the edge count and the key parts (with values if not bool valued)
+	 * Nodes are identified by their TensorHash only. Reference counts are not stored, they are recomputed from the edges when loading.
+	 * @tparam max_depth max depth of the NodeStorage
+	 * @tparam tri_t internal hypertrie trait
+	 */
+	template<size_t max_depth, HypertrieInternalTrait tri_t>
+	class NodeStorageSnapshot {
+	public:
+		using tri = tri_t;
+		using key_part_type = typename tri::key_part_type;
+		using value_type = typename tri::value_type;
+		using NodeStorage_t = NodeStorage<max_depth, tri>;
+
+		template<size_t depth>
+		using RawKey = typename tri::template RawKey<depth>;
+
+	private:
+		using HashSet = robin_hood::unordered_flat_set<RawTensorHash>;
+		using HashCounts = robin_hood::unordered_flat_map<RawTensorHash, size_t>;
+
+		/**
+		 * Changes that a load made to the storage so far, by depth. They are undone if the snapshot turns out to be invalid.
+		 */
+		struct LoadJournal {
+			/**
+			 * References added to nodes that were contained before.
+			 */
+			std::array<std::vector<std::pair<RawTensorHash, size_t>>, max_depth + 1> added_references{};
+			/**
+			 * Nodes created by the load.
+			 */
+			std::array<std::vector<RawTensorHash>, max_depth + 1> created{};
+		};
+
+		/**
+		 * Depth 1 lsb-unused bool nodes with a single entry are stored as tagged key parts in their parents.
+		 */
+		template<size_t depth>
+		static constexpr bool has_compressed_nodes = not(depth == 1 and tri::is_lsb_unused and tri::is_bool_valued);
+
+		template<typename T>
+		static void write(std::ostream &out, const T &value) {
+			static_assert(std::is_trivially_copyable_v<T>);
+			out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+		}
+
+		template<typename T>
+		static T read(std::istream &in) {
+			static_assert(std::is_trivially_copyable_v<T>);
+			T value;
+			in.read(reinterpret_cast<char *>(&value), sizeof(T));
+			if (not in)
+				throw std::runtime_error{"Snapshot is truncated."};
+			return value;
+		}
+
+		/**
+		 * Reads the number of records that follow. If the stream is seekable, the number is checked against the bytes
+		 * that remain, so a corrupt count is reported before anything is allocated for it.
+		 * @param record_size minimal number of bytes of one record
+		 * @throws std::runtime_error if the remaining bytes cannot hold that many records
+		 */
+		static std::uint64_t readCount(std::istream &in, const std::size_t record_size) {
+			const auto count = read<std::uint64_t>(in);
+			const auto pos = in.tellg();
+			if (pos == std::istream::pos_type(-1))
+				return count;
+			in.seekg(0, std::ios::end);
+			const auto end = in.tellg();
+			in.seekg(pos);
+			if (end == std::istream::pos_type(-1) or not in)
+				throw std::runtime_error{"Snapshot cannot be read."};
+			if (count > std::uint64_t(end - pos) / record_size)
+				throw std::runtime_error{"Snapshot is truncated."};
+			return count;
+		}
+
+		/**
+		 * Hash of the node an edge of an uncompressed node points to. For tagged key parts, the tagged representation is returned.
+		 */
+		template<typename Child>
+		static TensorHash childHash(const Child &child) {
+			if constexpr (std::is_same_v<Child, TaggedTensorHash<tri>>)
+				return child.getTaggedNodeHash();
+			else
+				return TensorHash(child);
+		}
+
+		/**
+		 * Checks if a child hash of a depth node references a node in the storage (and not a tagged key part).
+		 */
+		template<size_t depth>
+		static bool isChildNode(const TensorHash &child_hash) {
+			if constexpr (depth == 2 and tri::is_lsb_unused and tri::is_bool_valued)
+				return child_hash.isUncompressed();
+			else
+				return true;
+		}
+
+	public:
+		/**
+		 * The fingerprint of the entry hash function of this process. See SnapshotHeader::hash_fingerprint.
+		 */
+		static std::uint64_t hashFingerprint() {
+			return TensorHash::getCompressedNodeHash<2, key_part_type, value_type>(
+						   RawKey<2>{key_part_type(2), key_part_type(4)}, value_type(1))
+					.hash();
+		}
+
+		/**
+		 * Writes the nodes that are reachable from roots.
+		 * @param storage node storage that contains the roots
+		 * @param roots root nodes. Empty roots are written as well.
+		 * @param out output stream. It should be opened in binary mode.
+		 */
+		static void save(NodeStorage_t &storage, const std::vector<SnapshotRoot> &roots, std::ostream &out) {
+			SnapshotHeader header{};
+			header.max_depth = max_depth;
+			header.key_part_size = sizeof(key_part_type);
+			header.value_size = sizeof(value_type);
+			header.bool_valued = tri::is_bool_valued;
+			header.lsb_unused = tri::is_lsb_unused;
+			header.hash_fingerprint = hashFingerprint();
+			writeHeader(header, out);
+
+			std::array<HashSet, max_depth + 1> reachable{};
+			write<std::uint64_t>(out, roots.size());
+			for (const auto &root : roots) {
+				if (root.depth < 1 or root.depth > max_depth)
+					throw std::logic_error{"Root depth exceeds the depth of the node storage."};
+				write<std::uint64_t>(out, root.depth);
+				write<RawTensorHash>(out, root.hash.hash());
+				if (not root.hash.empty() and not(root.depth == 1 and not has_compressed_nodes<1> and root.hash.isCompressed()))
+					reachable[root.depth].insert(root.hash.hash());
+			}
+			save_rek<max_depth>(storage, reachable, out);
+			if (not out)
+				throw std::runtime_error{"Writing the snapshot failed."};
+		}
+
+		static void writeHeader(const SnapshotHeader &header, std::ostream &out) {
+			write(out, header.magic);
+			write(out, header.version);
+			write(out, header.max_depth);
+			write(out, header.key_part_size);
+			write(out, header.value_size);
+			write(out, header.bool_valued);
+			write(out, header.lsb_unused);
+			write(out, header.hash_fingerprint);
+		}
+
+		/**
+		 * Reads the header and checks that the snapshot can be loaded into a NodeStorage of this type.
+		 * The hash fingerprint is not checked.
+		 * @throws std::runtime_error if the format or the types do not match
+		 */
+		static SnapshotHeader readHeader(std::istream &in) {
+			SnapshotHeader header{};
+			header.magic = read<std::uint64_t>(in);
+			if (header.magic != SnapshotHeader::magic_number)
+				throw std::runtime_error{"Not a hypertrie snapshot."};
+			header.version = read<std::uint64_t>(in);
+			if (header.version != SnapshotHeader::format_version)
+				throw std::runtime_error{"Unsupported snapshot format version."};
+			header.max_depth = read<std::uint64_t>(in);
+			header.key_part_size = read<std::uint64_t>(in);
+			header.value_size = read<std::uint64_t>(in);
+			header.bool_valued = read<std::uint64_t>(in);
+			header.lsb_unused = read<std::uint64_t>(in);
+			header.hash_fingerprint = read<std::uint64_t>(in);
+			if (header.max_depth > max_depth)
+				throw std::runtime_error{"Snapshot depth exceeds the depth of the node storage."};
+			if (header.key_part_size != sizeof(key_part_type) or header.value_size != sizeof(value_type) or
+				header.bool_valued != tri::is_bool_valued or header.lsb_unused != tri::is_lsb_unused)
+				throw std::runtime_error{"Snapshot was written with different hypertrie traits."};
+			return header;
+		}
+
+		/**
+		 * Reads the roots and nodes that follow the header into storage. Nodes that are already contained are reused.
+		 * Each returned root holds one reference to its node that must be taken over by the caller.
+		 * The stored hashes are used as they are, so the hash fingerprint of the header must match hashFingerprint().
+		 * If the snapshot is invalid, the storage is left as it was before.
+		 * @param storage node storage to load into
+		 * @param header header returned by readHeader
+		 * @param in input stream positioned after the header
+		 * @return the roots in the order they were saved
+		 */
+		static std::vector<SnapshotRoot> load(NodeStorage_t &storage, const SnapshotHeader &header, std::istream &in) {
+			std::array<HashCounts, max_depth + 1> references{};
+			const auto root_count = readCount(in, sizeof(std::uint64_t) + sizeof(RawTensorHash));
+			std::vector<SnapshotRoot> roots;
+			for ([[maybe_unused]] const auto i : iter::range(root_count)) {
+				// the roots are read one by one, so nothing is allocated for roots that the stream does not contain
+				auto &root = roots.emplace_back();
+				root.depth = read<std::uint64_t>(in);
+				root.hash = TensorHash(read<RawTensorHash>(in));
+				if (root.depth < 1 or root.depth > header.max_depth)
+					throw std::runtime_error{"Snapshot contains a root with an invalid depth."};
+				if (not root.hash.empty() and not(root.depth == 1 and not has_compressed_nodes<1> and root.hash.isCompressed()))
+					++references[root.depth][root.hash.hash()];
+			}
+			LoadJournal journal{};
+			try {
+				load_rek<max_depth>(storage, header, references, journal, in);
+			} catch (...) {
+				rollback<max_depth>(storage, journal);
+				throw;
+			}
+			return roots;
+		}
+
+	private:
+		template<size_t depth>
+		static void save_rek(NodeStorage_t &storage, std::array<HashSet, max_depth + 1> &reachable, std::ostream &out) {
+			HashSet compressed_hashes{};
+			HashSet uncompressed_hashes{};
+			for (const auto &hash : reachable[depth])
+				(TensorHash(hash).isCompressed() ? compressed_hashes : uncompressed_hashes).insert(hash);
+
+			write<std::uint64_t>(out, compressed_hashes.size());
+			if constexpr (has_compressed_nodes<depth>) {
+				for (const auto &hash : compressed_hashes) {
+					auto nodec = storage.template getCompressedNode<depth>(TensorHash(hash));
+					assert(not nodec.null());
+					write<RawTensorHash>(out, hash);
+					write(out, nodec.compressed_node()->key());
+					if constexpr (not tri::is_bool_valued)
+						write(out, nodec.compressed_node()->value());
+				}
+			}
+
+			write<std::uint64_t>(out, uncompressed_hashes.size());
+			for (const auto &hash : uncompressed_hashes) {
+				auto nodec = storage.template getUncompressedNode<depth>(TensorHash(hash));
+				assert(not nodec.null());
+				const auto *node = nodec.uncompressed_node();
+				write<RawTensorHash>(out, hash);
+				if constexpr (depth > 1) {
+					write<std::uint64_t>(out, node->size());
+					write<std::uint64_t>(out, node->indexedPositions().to_ullong());
+					for (const size_t pos : iter::range(depth)) {
+						if (not node->isIndexed(pos))
+							continue;
+						write<std::uint64_t>(out, node->edges(pos).size());
+						for (const auto &[key_part, child] : node->edges(pos)) {
+							const TensorHash child_hash = childHash(child);
+							write<key_part_type>(out, key_part);
+							write<RawTensorHash>(out, child_hash.hash());
+							if (isChildNode<depth>(child_hash))
+								reachable[depth - 1].insert(child_hash.hash());
+						}
+					}
+				} else {
+					write<std::uint64_t>(out, node->edges(0).size());
+					if constexpr (tri::is_bool_valued) {
+						for (const auto &key_part : node->edges(0))
+							write<key_part_type>(out, key_part);
+					} else {
+						for (const auto &[key_part, value] : node->edges(0)) {
+							write<key_part_type>(out, key_part);
+							write<value_type>(out, value);
+						}
+					}
+				}
+			}
+
+			if constexpr (depth > 1)
+				save_rek<depth - 1>(storage, reachable, out);
+		}
+
+		/**
+		 * Number of references that loaded parents hold to a node.
+		 */
+		static size_t takeReferences(HashCounts &references, RawTensorHash hash) {
+			auto found = references.find(hash);
+			if (found == references.end())
+				return 0;
+			const size_t count = found->second;
+			references.erase(found);
+			return count;
+		}
+
+		/**
+		 * Undoes the changes of a load that failed: references added to nodes that existed before are removed again and
+		 * created nodes are deleted.
+		 */
+		template<size_t depth>
+		static void rollback(NodeStorage_t &storage, const LoadJournal &journal) {
+			for (const auto &[hash, ref_count] : journal.added_references[depth]) {
+				auto nodec = storage.template getNode<depth>(TensorHash(hash));
+				assert(not nodec.empty());
+				storage.template changeRefCount<depth>(nodec, -long(ref_count));
+			}
+			for (const auto &hash : journal.created[depth])
+				storage.template deleteNode<depth>(TensorHash(hash));
+			if constexpr (depth > 1)
+				rollback<depth - 1>(storage, journal);
+		}
+
+		template<size_t depth>
+		static void load_rek(NodeStorage_t &storage, const SnapshotHeader &header, std::array<HashCounts, max_depth + 1> &references,
+							 LoadJournal &journal, std::istream &in) {
+			if (depth <= header.max_depth) {
+				auto &level_references = references[depth];
+				const auto compressed_count = readCount(in, sizeof(RawTensorHash) + sizeof(RawKey<depth>) +
+																	(tri::is_bool_valued ? 0 : sizeof(value_type)));
+				if constexpr (has_compressed_nodes<depth>) {
+					auto &nodes = storage.template getNodeStorage<depth, NodeCompression::compressed>();
+					nodes.reserve(nodes.size() + compressed_count);
+					for ([[maybe_unused]] const auto i : iter::range(compressed_count)) {
+						const auto hash = read<RawTensorHash>(in);
+						const auto key = read<RawKey<depth>>(in);
+						const size_t ref_count = takeReferences(level_references, hash);
+						[[maybe_unused]] const auto value = [&]() {
+							if constexpr (tri::is_bool_valued)
+								return true;
+							else
+								return read<value_type>(in);
+						}();
+						if (auto nodec = storage.template getCompressedNode<depth>(TensorHash(hash)); not nodec.null()) {
+							if (ref_count > 0) {
+								journal.added_references[depth].emplace_back(hash, ref_count);
+								storage.template changeRefCount<depth, NodeCompression::compressed>(nodec.compressed_node(), long(ref_count));
+							}
+						} else if (ref_count > 0) {
+							// reserved first, so the node is journaled once it is in the storage
+							journal.created[depth].reserve(journal.created[depth].size() + 1);
+							storage.template newCompressedNode<depth>(key, value, ref_count, TensorHash(hash));
+							journal.created[depth].push_back(hash);
+						}
+					}
+				} else if (compressed_count != 0) {
+					throw std::runtime_error{"Snapshot contains compressed nodes of depth 1."};
+				}
+
+				const auto uncompressed_count = readCount(in, sizeof(RawTensorHash) + sizeof(std::uint64_t) * (depth > 1 ? 2 : 1));
+				auto &nodes = storage.template getNodeStorage<depth, NodeCompression::uncompressed>();
+				nodes.reserve(nodes.size() + uncompressed_count);
+				for ([[maybe_unused]] const auto i : iter::range(uncompressed_count)) {
+					const auto hash = read<RawTensorHash>(in);
+					const size_t ref_count = takeReferences(level_references, hash);
+					auto existing = storage.template getUncompressedNode<depth>(TensorHash(hash));
+					if (not existing.null() and ref_count > 0) {
+						journal.added_references[depth].emplace_back(hash, ref_count);
+						storage.template changeRefCount<depth, NodeCompression::uncompressed>(existing.uncompressed_node(), long(ref_count));
+					}
+					// the edges of existing nodes and of unreferenced nodes are read but not used
+					const bool create = existing.null() and ref_count > 0;
+					UncompressedNode<depth, tri> *node = nullptr;
+					try {
+						if constexpr (depth > 1) {
+							const auto size = read<std::uint64_t>(in);
+							const std::bitset<depth> indexed_positions(read<std::uint64_t>(in));
+							if (create) {
+								node = storage.template constructNode<depth, NodeCompression::uncompressed>(ref_count, indexed_positions);
+								node->size_ = size;
+							}
+							for (const size_t pos : iter::range(depth)) {
+								if (not indexed_positions[pos])
+									continue;
+								const auto edge_count = read<std::uint64_t>(in);
+								for ([[maybe_unused]] const auto j : iter::range(edge_count)) {
+									const auto key_part = read<key_part_type>(in);
+									const TensorHash child_hash(read<RawTensorHash>(in));
+									if (not create)
+										continue;
+									node->edges(pos)[key_part] = child_hash;
+									if (isChildNode<depth>(child_hash))
+										++references[depth - 1][child_hash.hash()];
+								}
+							}
+						} else {
+							if (create)
+								node = storage.template constructNode<depth, NodeCompression::uncompressed>(ref_count);
+							const auto edge_count = read<std::uint64_t>(in);
+							for ([[maybe_unused]] const auto j : iter::range(edge_count)) {
+								const auto key_part = read<key_part_type>(in);
+								if constexpr (tri::is_bool_valued) {
+									if (create)
+										node->edges(0).insert(key_part);
+								} else {
+									const auto value = read<value_type>(in);
+									if (create)
+										node->edges(0)[key_part] = value;
+								}
+							}
+						}
+						if (create) {
+							// reserved first, so the node is journaled once it is in the storage
+							journal.created[depth].reserve(journal.created[depth].size() + 1);
+							nodes.insert({TensorHash(hash), node});
+							node = nullptr;
+							journal.created[depth].push_back(hash);
+						}
+					} catch (...) {
+						// the node is not in the storage yet
+						if (node != nullptr)
+							storage.template retireNode<depth, NodeCompression::uncompressed>(node);
+						throw;
+					}
+				}
+				if (not level_references.empty())
+					throw std::runtime_error{"Snapshot references nodes that it does not contain."};
+			}
+			if constexpr (depth > 1)
+				load_rek<depth - 1>(storage, header, references, journal, in);
+		}
+	};
+}// namespace hypertrie::internal::raw
+
+#endif//HYPERTRIE_NODESTORAGESNAPSHOT_HPP
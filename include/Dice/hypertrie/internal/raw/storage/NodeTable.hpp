@@ -0,0 +1,517 @@
+#ifndef HYPERTRIE_NODETABLE_HPP
+#define HYPERTRIE_NODETABLE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "Dice/hypertrie/internal/raw/node/TensorHash.hpp"
+#include "Dice/hypertrie/internal/raw/storage/MemoryStats.hpp"
+#include "Dice/hypertrie/internal/util/EpochManager.hpp"
+
+namespace hypertrie::internal::raw {
+
+	/**
+	 * Footprint of a node type without a more specific nodeFootprint overload: it is counted with its size only.
+	 */
+	template<typename Node>
+	NodeMemoryStats nodeFootprint([[maybe_unused]] const Node *node) noexcept {
+		NodeMemoryStats stats{};
+		stats.node_count = 1;
+		stats.node_bytes = sizeof(Node);
+		return stats;
+	}
+
+	/**
+	 * Open-addressing hash table that maps TensorHash to Node*.
+	 *
+	 * A TensorHash is already an XOR of well-mixed entry hashes, so its bits are used directly to find the home slot.
+	 * They are not hashed a second time. Collisions are resolved by linear probing. Deletion uses backward shifting,
+	 * so the table has no tombstones. The all-zero TensorHash marks an empty slot and must not be inserted.
+	 *
+	 * The table stores only pointers. The nodes live in the slab allocator of the LevelNodeStorage and have stable addresses.
+	 * Inserting or erasing invalidates all iterators.
+	 *
+	 * A single writer may modify the table while other threads look up nodes with lookup() or findMany(). Slots are written
+	 * with atomic stores. Erasing and rehashing move entries, so they increment version_ before and after (seqlock) and
+	 * concurrent lookups retry. The slot array that is replaced by a rehash is retired to the epoch manager, if one is set.
+	 * All other members must only be used by the writer.
+	 *
+	 * The table sums up the footprints of its nodes (node count, reference counts, node, edge and key bytes), so they can
+	 * be reported without visiting the nodes. The footprint of a node is computed by nodeFootprint(const Node *), which is
+	 * found by argument-dependent lookup. It is added when a node is inserted and subtracted when it is erased. Nodes
+	 * must therefore be complete when they are inserted. Contained nodes are only changed with changeInPlace or changeRefCount.
+	 * @tparam Node node type
+	 */
+	template<typename Node>
+	class NodeTable {
+	public:
+		using key_type = TensorHash;
+		using mapped_type = Node *;
+		using value_type = std::pair<TensorHash, Node *>;
+		using size_type = std::size_t;
+
+	private:
+		/**
+		 * Minimal number of slots after the first insert.
+		 */
+		static constexpr size_type min_capacity = 16;
+
+		std::vector<value_type> slots_{};
+		size_type size_ = 0;
+		size_type mask_ = 0;
+		/**
+		 * Incremented whenever an entry is removed and its node is destroyed.
+		 */
+		std::atomic<size_type> revision_ = 0;
+
+		/**
+		 * Sum of the footprints of the contained nodes. table_bytes and allocator_bytes are not set.
+		 */
+		NodeMemoryStats footprint_{};
+
+		/**
+		 * slots_.data() and mask_ for concurrent lookups.
+		 */
+		std::atomic<value_type *> published_slots_ = nullptr;
+		std::atomic<size_type> published_mask_ = 0;
+		/**
+		 * Odd while entries are moved.
+		 */
+		std::atomic<size_type> version_ = 0;
+		/**
+		 * Replaced slot arrays are retired to it. If it is nullptr, they are freed immediately.
+		 */
+		util::EpochManager *epochs_ = nullptr;
+
+		[[nodiscard]] static bool isEmptySlot(const value_type &slot) noexcept {
+			return slot.first.hash() == 0;
+		}
+
+		/**
+		 * The least significant bit is the compression tag. It is the same for all entries of a table, so it is dropped.
+		 */
+		[[nodiscard]] size_type homeSlot(const TensorHash &hash) const noexcept {
+			return (hash.hash() >> 1) & mask_;
+		}
+
+		/**
+		 * Finds the slot of hash, or the empty slot where hash would be inserted. Requires at least one slot.
+		 */
+		[[nodiscard]] size_type probe(const TensorHash &hash) const noexcept {
+			size_type i = homeSlot(hash);
+			while (not isEmptySlot(slots_[i]) and slots_[i].first.hash() != hash.hash())
+				i = (i + 1) & mask_;
+			return i;
+		}
+
+		/**
+		 * Writes a slot for concurrent lookups. The node is stored before the hash, so a lookup that sees the hash sees the node.
+		 */
+		static void storeSlot(value_type &slot, const value_type &entry) noexcept {
+			std::atomic_ref<Node *>(slot.second).store(entry.second, std::memory_order_relaxed);
+			std::atomic_ref<RawTensorHash>(slot.first.hash()).store(entry.first.hash(), std::memory_order_release);
+		}
+
+		void beginMove() noexcept {
+			version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+		}
+
+		void endMove() noexcept {
+			version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+		void publish() noexcept {
+			published_slots_.store(slots_.empty() ? nullptr : slots_.data(), std::memory_order_relaxed);
+			published_mask_.store(mask_, std::memory_order_relaxed);
+		}
+
+		/**
+		 * Frees a replaced slot array once no concurrent lookup can read it anymore.
+		 */
+		void retireSlots(std::vector<value_type> &&old_slots) {
+			if (epochs_ == nullptr or old_slots.empty())
+				return;
+			epochs_->retire(nullptr, new std::vector<value_type>(std::move(old_slots)),
+							[](void *, void *slots) { delete static_cast<std::vector<value_type> *>(slots); });
+		}
+
+		void rehash(size_type capacity) {
+			std::vector<value_type> new_slots(capacity);
+			const size_type new_mask = capacity - 1;
+			for (auto &slot : slots_)
+				if (not isEmptySlot(slot)) {
+					size_type i = (slot.first.hash() >> 1) & new_mask;
+					while (not isEmptySlot(new_slots[i]))
+						i = (i + 1) & new_mask;
+					new_slots[i] = slot;
+				}
+			beginMove();
+			std::swap(new_slots, slots_);
+			mask_ = new_mask;
+			publish();
+			endMove();
+			retireSlots(std::move(new_slots));
+		}
+
+		void growIfNeeded() {
+			// max load factor 7/8
+			if ((size_ + 1) * 8 > slots_.size() * 7)
+				rehash(std::max(min_capacity, slots_.size() * 2));
+		}
+
+	public:
+		template<bool is_const>
+		class iterator_t {
+			friend class NodeTable;
+			using slot_ptr = std::conditional_t<is_const, const NodeTable::value_type *, NodeTable::value_type *>;
+
+			slot_ptr slot_ = nullptr;
+			slot_ptr end_ = nullptr;
+
+			iterator_t(slot_ptr slot, slot_ptr end) noexcept : slot_(slot), end_(end) {}
+
+			void skipEmpty() noexcept {
+				while (slot_ != end_ and isEmptySlot(*slot_))
+					++slot_;
+			}
+
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = NodeTable::value_type;
+			using difference_type = std::ptrdiff_t;
+			using pointer = slot_ptr;
+			using reference = std::conditional_t<is_const, const NodeTable::value_type &, NodeTable::value_type &>;
+
+			iterator_t() = default;
+
+			operator iterator_t<true>() const noexcept { return {slot_, end_}; }
+
+			reference operator*() const noexcept { return *slot_; }
+
+			pointer operator->() const noexcept { return slot_; }
+
+			iterator_t &operator++() noexcept {
+				++slot_;
+				skipEmpty();
+				return *this;
+			}
+
+			iterator_t operator++(int) noexcept {
+				auto copy = *this;
+				++(*this);
+				return copy;
+			}
+
+			bool operator==(const iterator_t &other) const noexcept { return slot_ == other.slot_; }
+
+			bool operator!=(const iterator_t &other) const noexcept { return slot_ != other.slot_; }
+		};
+
+		using iterator = iterator_t<false>;
+		using const_iterator = iterator_t<true>;
+
+		NodeTable() = default;
+
+		NodeTable(const NodeTable &) = delete;
+
+		NodeTable &operator=(const NodeTable &) = delete;
+
+		/**
+		 * Sets the epoch manager that replaced slot arrays are retired to.
+		 */
+		void epochManager(util::EpochManager *epochs) noexcept { epochs_ = epochs; }
+
+		iterator begin() noexcept {
+			iterator it{slots_.data(), slots_.data() + slots_.size()};
+			it.skipEmpty();
+			return it;
+		}
+
+		iterator end() noexcept { return {slots_.data() + slots_.size(), slots_.data() + slots_.size()}; }
+
+		const_iterator begin() const noexcept {
+			const_iterator it{slots_.data(), slots_.data() + slots_.size()};
+			it.skipEmpty();
+			return it;
+		}
+
+		const_iterator end() const noexcept { return {slots_.data() + slots_.size(), slots_.data() + slots_.size()}; }
+
+		[[nodiscard]] size_type size() const noexcept { return size_; }
+
+		[[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+		/**
+		 * The revision changes whenever an entry is removed, unless its node is moved to another hash (see eraseMoved).
+		 * Node pointers that were looked up in the same revision are still valid.
+		 * Inserting does not change the revision because it never moves nodes.
+		 * The revision is table-wide: a single deletion invalidates the node pointers cached in all edges to nodes of this
+		 * table (see SwizzledTensorHash).
+		 */
+		[[nodiscard]] size_type revision() const noexcept { return revision_.load(std::memory_order_acquire); }
+
+		/**
+		 * Number of slots.
+		 */
+		[[nodiscard]] size_type capacity() const noexcept { return slots_.size(); }
+
+		iterator find(const TensorHash &hash) noexcept {
+			if (slots_.empty())
+				return end();
+			value_type *slot = &slots_[probe(hash)];
+			if (isEmptySlot(*slot))
+				return end();
+			return {slot, slots_.data() + slots_.size()};
+		}
+
+		const_iterator find(const TensorHash &hash) const noexcept {
+			return const_cast<NodeTable *>(this)->find(hash);
+		}
+
+		[[nodiscard]] size_type count(const TensorHash &hash) const noexcept {
+			return find(hash) != end();
+		}
+
+		/**
+		 * Looks up the node of hash. It is safe to call while the writer modifies the table.
+		 * @return the node or nullptr if hash is not contained
+		 */
+		[[nodiscard]] Node *lookup(const TensorHash &hash) const noexcept {
+			while (true) {
+				const size_type version = version_.load(std::memory_order_acquire);
+				if ((version & 1) == 0) {
+					Node *node = lookupUnversioned(hash);
+					std::atomic_thread_fence(std::memory_order_acquire);
+					if (version_.load(std::memory_order_relaxed) == version)
+						return node;
+				}
+			}
+		}
+
+	private:
+		/**
+		 * Probes the published slots with atomic loads. The result is only valid if version_ did not change meanwhile.
+		 */
+		[[nodiscard]] Node *lookupUnversioned(const TensorHash &hash) const noexcept {
+			value_type *slots = published_slots_.load(std::memory_order_relaxed);
+			if (slots == nullptr)
+				return nullptr;
+			const size_type mask = published_mask_.load(std::memory_order_relaxed);
+			size_type i = (hash.hash() >> 1) & mask;
+			// a lookup that overlaps a move may see no empty slot. it is bounded and retried.
+			for (size_type probes = 0; probes <= mask; ++probes) {
+				const RawTensorHash slot_hash = std::atomic_ref<RawTensorHash>(slots[i].first.hash()).load(std::memory_order_acquire);
+				if (slot_hash == hash.hash())
+					return std::atomic_ref<Node *>(slots[i].second).load(std::memory_order_relaxed);
+				if (slot_hash == 0)
+					return nullptr;
+				i = (i + 1) & mask;
+			}
+			return nullptr;
+		}
+
+	public:
+
+		/**
+		 * Inserts (hash, node) if hash is not yet contained.
+		 * @return iterator to the entry of hash and whether it was inserted
+		 */
+		std::pair<iterator, bool> insert(const value_type &entry) {
+			assert(not isEmptySlot(entry));
+			growIfNeeded();
+			const size_type i = probe(entry.first);
+			value_type *slot = &slots_[i];
+			const bool inserted = isEmptySlot(*slot);
+			if (inserted) {
+				storeSlot(*slot, entry);
+				++size_;
+				if (entry.second != nullptr)
+					footprint_ += nodeFootprint(static_cast<const Node *>(entry.second));
+			}
+			return {iterator{slot, slots_.data() + slots_.size()}, inserted};
+		}
+
+		/**
+		 * Returns the node pointer of hash. If hash is not contained, it is inserted with a nullptr that must be assigned.
+		 * Only use it to look up contained nodes: an assigned node is not added to footprint().
+		 */
+		Node *&operator[](const TensorHash &hash) {
+			return insert({hash, nullptr}).first->second;
+		}
+
+		void erase(iterator it) noexcept {
+			if (it->second != nullptr)
+				footprint_ -= nodeFootprint(static_cast<const Node *>(it->second));
+			eraseSlot(it);
+			revision_.fetch_add(1, std::memory_order_release);
+		}
+
+		/**
+		 * Removes the entry of a node that is inserted again under another hash (the node is moved in place).
+		 * The node is not destroyed, so the revision does not change and cached node pointers stay valid.
+		 */
+		void eraseMoved(iterator it) noexcept {
+			if (it->second != nullptr)
+				footprint_ -= nodeFootprint(static_cast<const Node *>(it->second));
+			eraseSlot(it);
+		}
+
+		/**
+		 * Changes a contained node in place and counts its footprint again.
+		 * @param node the node
+		 * @param change called with node
+		 */
+		template<typename Change>
+		void changeInPlace(Node *node, Change &&change) {
+			footprint_ -= nodeFootprint(static_cast<const Node *>(node));
+			change(node);
+			footprint_ += nodeFootprint(static_cast<const Node *>(node));
+		}
+
+		/**
+		 * Changes the reference count of a contained node.
+		 * @return the new reference count
+		 */
+		size_type changeRefCount(Node *node, const long diff) noexcept {
+			node->ref_count() += diff;
+			footprint_.ref_count_sum += diff;
+			return node->ref_count();
+		}
+
+		/**
+		 * Sums of the node count, the reference counts and the node, edge and key bytes of the contained nodes.
+		 * The cost is constant.
+		 */
+		[[nodiscard]] const NodeMemoryStats &footprint() const noexcept { return footprint_; }
+
+		size_type erase(const TensorHash &hash) noexcept {
+			auto it = find(hash);
+			if (it == end())
+				return 0;
+			erase(it);
+			return 1;
+		}
+
+	private:
+		void eraseSlot(iterator it) noexcept {
+			assert(it != end());
+			size_type i = static_cast<size_type>(it.slot_ - slots_.data());
+			size_type j = i;
+			beginMove();
+			// backward shift: move entries of the probe sequence after i into the gap if their home slot allows it
+			while (true) {
+				j = (j + 1) & mask_;
+				if (isEmptySlot(slots_[j]))
+					break;
+				const size_type home = homeSlot(slots_[j].first);
+				const bool movable = (i <= j) ? (home <= i or home > j) : (home <= i and home > j);
+				if (movable) {
+					storeSlot(slots_[i], slots_[j]);
+					i = j;
+				}
+			}
+			storeSlot(slots_[i], value_type{});
+			endMove();
+			--size_;
+		}
+
+	public:
+
+		/**
+		 * Makes sure that count entries fit without rehashing.
+		 */
+		void reserve(size_type count) {
+			size_type capacity = min_capacity;
+			while (capacity * 7 < count * 8)
+				capacity *= 2;
+			if (capacity > slots_.size())
+				rehash(capacity);
+		}
+
+		/**
+		 * Removes all entries and frees the slots.
+		 */
+		void clear() {
+			std::vector<value_type> old_slots{};
+			beginMove();
+			std::swap(old_slots, slots_);
+			size_ = 0;
+			mask_ = 0;
+			footprint_ = {};
+			publish();
+			endMove();
+			retireSlots(std::move(old_slots));
+			revision_.fetch_add(1, std::memory_order_release);
+		}
+
+		/**
+		 * Hints the CPU to load the home slot of hash into the cache.
+		 */
+		void prefetch(const TensorHash &hash) const noexcept {
+			if (value_type *slots = published_slots_.load(std::memory_order_relaxed); slots != nullptr)
+				__builtin_prefetch(&slots[(hash.hash() >> 1) & published_mask_.load(std::memory_order_relaxed)]);
+		}
+
+		/**
+		 * Looks up count hashes at once. The home slots of a batch are prefetched before they are probed,
+		 * so the cache misses of the batch overlap. It is safe to call while the writer modifies the table.
+		 * @param hashes the hashes to look up
+		 * @param count number of hashes
+		 * @param nodes output. nodes[i] is the node of hashes[i] or nullptr if it is not contained.
+		 */
+		void findMany(const TensorHash *hashes, size_type count, Node **nodes) const noexcept {
+			static constexpr size_type batch_size = 8;
+			for (size_type batch_start = 0; batch_start < count; batch_start += batch_size) {
+				const size_type batch_end = std::min(count, batch_start + batch_size);
+				while (true) {
+					const size_type version = version_.load(std::memory_order_acquire);
+					if (version & 1)
+						continue;
+					if (value_type *slots = published_slots_.load(std::memory_order_relaxed); slots != nullptr) {
+						const size_type mask = published_mask_.load(std::memory_order_relaxed);
+						for (size_type i = batch_start; i < batch_end; ++i)
+							__builtin_prefetch(&slots[(hashes[i].hash() >> 1) & mask]);
+					}
+					for (size_type i = batch_start; i < batch_end; ++i)
+						nodes[i] = lookupUnversioned(hashes[i]);
+					std::atomic_thread_fence(std::memory_order_acquire);
+					if (version_.load(std::memory_order_relaxed) == version)
+						break;
+				}
+			}
+		}
+	};
+}// namespace hypertrie::internal::raw
+
+template<typename Node>
+struct fmt::formatter<hypertrie::internal::raw::NodeTable<Node>> {
+	auto parse(format_parse_context &ctx) {
+		return ctx.begin();
+	}
+
+	template<typename FormatContext>
+	auto format(const hypertrie::internal::raw::NodeTable<Node> &table, FormatContext &ctx) {
+
+		bool first = true;
+		fmt::format_to(ctx.out(), "{{ ");
+		for (const auto &entry : table) {
+			if (first) {
+				first = false;
+			} else {
+				fmt::format_to(ctx.out(), "\n  ");
+			}
+			fmt::format_to(ctx.out(), "{} -> {} ", entry.first, *entry.second);
+		}
+		return fmt::format_to(ctx.out(), "}}");
+	}
+};
+
+#endif//HYPERTRIE_NODETABLE_HPP
@@ -0,0 +1,89 @@
+#ifndef HYPERTRIE_NODEVERIFICATION_HPP
+#define HYPERTRIE_NODEVERIFICATION_HPP
+
+#include "Dice/hypertrie/internal/raw/Hypertrie_internal_traits.hpp"
+#include "Dice/hypertrie/internal/raw/node/Node.hpp"
+#include "Dice/hypertrie/internal/raw/node/TensorHash.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace hypertrie::internal::raw {
+
+	/**
+	 * Checks that a node which already exists for a hash is the node that a writer is about to share for that hash.
+	 * Instead of building the expected node, the size of the existing node is compared and a few expected entries are
+	 * probed: compressed nodes must hold exactly the expected entry, uncompressed nodes must have an edge for every key
+	 * part of a probed entry at every indexed position. At depth 1, probed entries are looked up with their values.
+	 *
+	 * It is used by RekNodeModification if NodeStorage::verifyHashes() is set.
+	 * @tparam tri_t internal hypertrie trait
+	 */
+	template<HypertrieInternalTrait tri_t>
+	struct NodeVerification {
+		using tri = tri_t;
+		using key_part_type = typename tri::key_part_type;
+		using value_type = typename tri::value_type;
+		template<size_t depth>
+		using RawKey = typename tri::template RawKey<depth>;
+
+		/**
+		 * Maximal number of expected entries that are probed in an existing uncompressed node.
+		 */
+		static const constexpr size_t SAMPLES = 4;
+
+		static std::runtime_error collision(const size_t depth, const TensorHash hash, const char *reason) {
+			return std::runtime_error{fmt::format("Hash collision at depth {} for node {}: {}.", depth, (std::string) hash, reason)};
+		}
+
+		/**
+		 * @throws std::runtime_error if node does not hold exactly the entry (key, value)
+		 */
+		template<size_t depth>
+		static void verifyCompressed(const CompressedNode<depth, tri> *const node, const TensorHash hash,
+									 const RawKey<depth> &key, const value_type value) {
+			if (node->key() != key or node->value() != value)
+				throw collision(depth, hash, "the compressed node holds a different entry");
+		}
+
+		/**
+		 * @param node the existing node
+		 * @param hash its hash
+		 * @param expected_size number of entries the node must have
+		 * @param entries number of entries that may be probed. At most SAMPLES of them are probed.
+		 * @param contained if the probed entries must be contained. Otherwise, they must be missing, which is only checked at depth 1.
+		 * @param key_part_of returns the key part of the i-th entry at pos for (i, pos)
+		 * @param value_of returns the value of the i-th entry for i
+		 * @throws std::runtime_error if node cannot hold the expected entries
+		 */
+		template<size_t depth, typename KeyPartOf, typename ValueOf>
+		static void verifyUncompressed(const UncompressedNode<depth, tri> *const node, const TensorHash hash,
+									   const size_t expected_size, const size_t entries, const bool contained,
+									   KeyPartOf &&key_part_of, ValueOf &&value_of) {
+			if (node->size() != expected_size)
+				throw collision(depth, hash, "the uncompressed node has a different size");
+			const size_t samples = std::min(entries, SAMPLES);
+			if constexpr (depth == 1) {
+				for (size_t i = 0; i < samples; ++i) {
+					const auto [found, iter] = node->find(0, key_part_of(i, 0));
+					if (found != contained)
+						throw collision(depth, hash, "a probed entry differs");
+					if constexpr (not tri::is_bool_valued)
+						if (contained and iter->second != value_of(i))
+							throw collision(depth, hash, "a probed entry has a different value");
+				}
+			} else if (contained) {
+				for (size_t pos = 0; pos < depth; ++pos)
+					if (node->isIndexed(pos))
+						for (size_t i = 0; i < samples; ++i)
+							if (not node->find(pos, key_part_of(i, pos)).first)
+								throw collision(depth, hash, "a probed entry is missing");
+			}
+		}
+	};
+}// namespace hypertrie::internal::raw
+
+#endif//HYPERTRIE_NODEVERIFICATION_HPP
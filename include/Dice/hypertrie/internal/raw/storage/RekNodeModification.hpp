@@ -4,15 +4,24 @@
 #include "Dice/hypertrie/internal/Hypertrie_traits.hpp"
 #include "Dice/hypertrie/internal/raw/node/NodeContainer.hpp"
 #include "Dice/hypertrie/internal/raw/node/TensorHash.hpp"
+#include "Dice/hypertrie/internal/raw/storage/BulkBuilder.hpp"
 #include "Dice/hypertrie/internal/raw/storage/Entry.hpp"
 #include "Dice/hypertrie/internal/raw/storage/NodeModificationPlan.hpp"
 #include "Dice/hypertrie/internal/raw/storage/NodeStorage.hpp"
+#include "Dice/hypertrie/internal/raw/storage/NodeVerification.hpp"
 #include "Dice/hypertrie/internal/util/CONSTANTS.hpp"
 #include "Dice/hypertrie/internal/util/IntegralTemplatedTuple.hpp"
+#include "Dice/hypertrie/internal/util/ParallelFor.hpp"
 
+#include <fmt/format.h>
 #include <robin_hood.h>
 #include <tsl/hopscotch_map.h>
 
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
 namespace hypertrie::internal::raw {
 
 	template<size_t node_storage_depth,
@@ -34,11 +43,18 @@ namespace hypertrie::internal::raw {
 		static const constexpr long INC_COUNT_DIFF_BEFORE = -1;
 		static const constexpr long DEC_COUNT_DIFF_BEFORE = 1;
 
+		/**
+		 * Minimal number of new uncompressed nodes of one depth to populate them in parallel.
+		 */
+		static const constexpr size_t PARALLEL_MIN_NEW_NODES = 64;
+
 		template<size_t depth>
 		using NodeStorage_t = NodeStorage<depth, tri>;
 
 		template<size_t depth>
-		using Modification_t = NodeModificationPlan<depth, tri>;
+		using Modification_t = NodeModificationPlan<depth, tri, update_depth>;
+
+		using entry_index_type = typename Modification_t<update_depth>::entry_index_type;
 
 		template<size_t depth>
 		using LevelModifications_t = robin_hood::unordered_node_set<Modification_t<depth>, absl::Hash<Modification_t<depth>>>;
@@ -54,6 +70,19 @@ namespace hypertrie::internal::raw {
 
 		using RefChanges = util::IntegralTemplatedTuple<LevelRefChanges, 1, update_depth>;
 
+		/**
+		 * Modifications of one depth together with the reference count of the node after.
+		 */
+		template <size_t depth>
+		using LevelCountedModifications = std::vector<std::pair<Modification_t<depth>, size_t>>;
+
+		using CountedModifications = util::IntegralTemplatedTuple<LevelCountedModifications, 1, update_depth>;
+
+		template <size_t depth>
+		using LevelVerifiedHashes = robin_hood::unordered_flat_set<TensorHash>;
+
+		using VerifiedHashes = util::IntegralTemplatedTuple<LevelVerifiedHashes, 1, update_depth>;
+
 		template <size_t depth>
 		using re = RawEntry_t<depth, tri>;
 
@@ -70,6 +99,26 @@ namespace hypertrie::internal::raw {
 
 		RefChanges ref_changes{};
 
+		/**
+		 * Modifications that reuse a node before which is not referenced anymore.
+		 */
+		CountedModifications moveable_multi_updates{};
+
+		/**
+		 * Modifications that create a new node.
+		 */
+		CountedModifications unmoveable_multi_updates{};
+
+		/**
+		 * Entries of the modification. The plans of all depths refer to them by index.
+		 */
+		std::vector<Entry<update_depth>> entries_buffer{};
+
+		/**
+		 * Hashes after of the plans that were verified by verifyPlan.
+		 */
+		VerifiedHashes verified_hashes{};
+
 		template<size_t updates_depth>
 		auto getRefChanges()
 				-> LevelRefChanges<updates_depth> & {
@@ -109,11 +158,27 @@ namespace hypertrie::internal::raw {
 		}
 
 		auto apply_update(std::vector<RawKey<update_depth>> keys) {
-			Modification_t<update_depth> update{};
-			if (keys.empty())
+			static_assert(tri::is_bool_valued, "Use apply_insert to insert keys with values.");
+			apply_insert(std::move(keys));
+		}
+
+		/**
+		 * Inserts entries into the node in nodec.
+		 * @param entries entries to be inserted. Their keys must not be contained yet and must be pairwise distinct. The values must not be zero.
+		 * @throws std::length_error if there are more than max_root_entries entries. The node is not changed then.
+		 */
+		void apply_insert(std::vector<Entry<update_depth>> entries) {
+			Modification_t<update_depth> update{&entries_buffer};
+			if (entries.empty())
 				return;
-			else if (nodec.empty())
-				if (keys.size() == 1)
+			else if (nodec.empty() and entries.size() > 1 and node_storage.modificationThreads() == 1 and not node_storage.verifyHashes()) {
+				// built depth first from sorted runs. Multiple threads populate the levels of the plan in parallel instead.
+				// With hash verification, the plan is taken, too, so it is verified before the first node is created.
+				BulkBuilder<node_storage_depth, tri> builder{node_storage};
+				nodec = builder.template build<update_depth>(std::move(entries));
+				return;
+			} else if (nodec.empty())
+				if (entries.size() == 1)
 					update.modOp() = ModificationOperations::NEW_COMPRESSED_NODE;
 				else
 					update.modOp() = ModificationOperations::NEW_UNCOMPRESSED_NODE;
@@ -123,11 +188,9 @@ namespace hypertrie::internal::raw {
 				update.modOp() = ModificationOperations::INSERT_INTO_UNCOMPRESSED_NODE;
 
 			update.hashBefore() = nodec.hash().hash();
-			update.entries() = std::move(keys);
+			addRootEntries(update, std::move(entries));
 
-			planUpdate(std::move(update), INC_COUNT_DIFF_AFTER);
-
-			apply_update_rek<update_depth>();
+			applyRootUpdate(std::move(update));
 		}
 
 		void apply_update(const RawKey<update_depth> &key, const value_type value, const value_type old_value) {
@@ -138,13 +201,15 @@ namespace hypertrie::internal::raw {
 
 			bool value_changes = old_value != value_type{};
 
-			Modification_t<update_depth> update{};
-			update.hashBefore() = nodec.hash().hash();
-			update.addEntry(key, value);
 			if (value_deleted) {
-				update.modOp() = ModificationOperations::REMOVE_FROM_UC;
-				throw std::logic_error{"deleting values from hypertrie is not yet implemented. "};
-			} else if (value_changes) {
+				apply_remove({re<update_depth>::make_Entry(key, old_value)});
+				return;
+			}
+
+			Modification_t<update_depth> update{&entries_buffer};
+			update.hashBefore() = nodec.hash().hash();
+			appendEntry(update, key, value);
+			if (value_changes) {
 				update.modOp() = ModificationOperations::CHANGE_VALUE;
 				update.oldValue() = old_value;
 			} else {// new entry
@@ -156,6 +221,126 @@ namespace hypertrie::internal::raw {
 					update.modOp() = ModificationOperations::INSERT_INTO_UNCOMPRESSED_NODE;
 			}
 
+			applyRootUpdate(std::move(update));
+		}
+
+		/**
+		 * Removes entries from the node in nodec. Nodes that are not referenced anymore afterwards are deleted or reused.
+		 * @param entries entries to be removed. They must be contained with exactly the given values and must be pairwise distinct.
+		 * @throws std::length_error if there are more than max_root_entries entries. The node is not changed then.
+		 */
+		void apply_remove(std::vector<Entry<update_depth>> entries) {
+			if (entries.empty())
+				return;
+			assert(not nodec.empty());
+			const size_t size_before = (nodec.isCompressed()) ? 1 : nodec.uncompressed_node()->size();
+			assert(entries.size() <= size_before);
+			if (entries.size() == size_before) {
+				// the node becomes empty
+				if constexpr (not(update_depth == 1 and tri::is_bool_valued and tri::is_lsb_unused)) {
+					planChangeCount<update_depth>(nodec.hash(), DEC_COUNT_DIFF_AFTER);
+					apply_update_rek<update_depth>();
+				}
+				nodec = {};
+				return;
+			}
+
+			Modification_t<update_depth> update{&entries_buffer};
+			update.modOp() = ModificationOperations::REMOVE_FROM_UC;
+			update.hashBefore() = nodec.hash().hash();
+			update.sizeAfter() = size_before - entries.size();
+			addRootEntries(update, std::move(entries));
+
+			applyRootUpdate(std::move(update));
+		}
+
+		/**
+		 * Removes and inserts entries of the node in nodec in a single modification, so every node is rewritten at most once.
+		 * A key that is removed and inserted changes its value. A node in which only that entry changes gets a CHANGE_VALUE
+		 * update, other uncompressed nodes are updated in place (UPDATE_UC).
+		 * @param removed entries to be removed. They must be contained with exactly the given values and must be pairwise distinct.
+		 * @param inserted entries to be inserted. Their keys must be pairwise distinct and must not be contained unless they
+		 * are removed, too. The values must not be zero and must differ from the removed values of the same keys.
+		 * @throws std::length_error if there are more than max_root_entries entries. The node is not changed then.
+		 */
+		void apply_changes(std::vector<Entry<update_depth>> removed, std::vector<Entry<update_depth>> inserted) {
+			if (removed.empty()) {
+				apply_insert(std::move(inserted));
+				return;
+			}
+			if (inserted.empty()) {
+				apply_remove(std::move(removed));
+				return;
+			}
+			assert(not nodec.empty());
+			const size_t size_before = (nodec.isCompressed()) ? 1 : nodec.uncompressed_node()->size();
+			assert(removed.size() <= size_before);
+
+			Modification_t<update_depth> update{&entries_buffer};
+			update.hashBefore() = nodec.hash().hash();
+			addRootEntries(update.entries(), std::move(inserted));
+			addRootEntries(update.removedEntries(), std::move(removed));
+			// at least one entry is inserted, so the node does not become empty
+			[[maybe_unused]] const bool remains = planExistingUpdate<update_depth>(update, size_before);
+			assert(remains);
+
+			applyRootUpdate(std::move(update));
+		}
+
+	private:
+		/**
+		 * Moves entries into the buffer and adds them to a plan of the root.
+		 */
+		void addRootEntries(Modification_t<update_depth> &update, std::vector<Entry<update_depth>> &&entries) {
+			addRootEntries(update.entries(), std::move(entries));
+		}
+
+		/**
+		 * Maximal number of root entries in the buffer. Planning a level appends at most one entry per root entry (see
+		 * appendEntry), so the buffer never holds more than entry_index_type can address.
+		 */
+		static constexpr size_t max_root_entries = std::numeric_limits<entry_index_type>::max() / (update_depth + 1);
+
+		/**
+		 * Moves entries into the buffer and appends their indices to entry_indices.
+		 * @throws std::length_error if the buffer would hold more than max_root_entries root entries. Nothing is changed then.
+		 */
+		void addRootEntries(std::vector<entry_index_type> &entry_indices, std::vector<Entry<update_depth>> &&entries) {
+			if (entries_buffer.size() + entries.size() > max_root_entries)
+				throw std::length_error{fmt::format("A single modification supports at most {} entries, but {} were given.",
+													max_root_entries, entries_buffer.size() + entries.size())};
+			const auto offset = entry_index_type(entries_buffer.size());
+			if (entries_buffer.empty())
+				entries_buffer = std::move(entries);
+			else
+				entries_buffer.insert(entries_buffer.end(), entries.begin(), entries.end());
+			entry_indices.resize(entries_buffer.size() - offset);
+			std::iota(entry_indices.begin(), entry_indices.end(), offset);
+		}
+
+		/**
+		 * Adds an entry that is not in the buffer yet to a plan. It is appended to the buffer as a root entry that
+		 * holds the key parts of key at the key positions of the plan. The other key parts are never read.
+		 * @throws std::length_error if entry_index_type cannot address the entry. addRootEntries bounds the number of root
+		 * entries, so it is not thrown while a modification is applied.
+		 */
+		template<size_t depth>
+		void appendEntry(Modification_t<depth> &update, const RawKey<depth> &key, const value_type value) {
+			if (entries_buffer.size() >= std::numeric_limits<entry_index_type>::max())
+				throw std::length_error{"The entries of a modification exceed the entry index range."};
+			RawKey<update_depth> root_key{};
+			for (const size_t pos : iter::range(depth))
+				root_key[update.keyPositions()[pos]] = key[pos];
+			update.addEntry(entry_index_type(entries_buffer.size()));
+			entries_buffer.push_back(re<update_depth>::make_Entry(root_key, value));
+		}
+
+		/**
+		 * Applies an update to the node in nodec. If the resulting node already exists, only the reference counts are changed.
+		 */
+		void applyRootUpdate(Modification_t<update_depth> update) {
+			if (node_storage.verifyHashes())
+				verifyPlan<update_depth>(update);
 			if(not update.hashAfter().empty()) {
 				auto nc_after = node_storage.template getNode<update_depth>(update.hashAfter());
 				if (not nc_after.empty()) {
@@ -173,6 +358,215 @@ namespace hypertrie::internal::raw {
 			apply_update_rek<update_depth>();
 		}
 
+		/**
+		 * Size of the node with the given hash. Compressed nodes have size 1.
+		 */
+		template<size_t depth>
+		size_t nodeSize(const TensorHash hash) {
+			if (hash.empty())
+				return 0;
+			else if (hash.isCompressed())
+				return 1;
+			else
+				return node_storage.template getUncompressedNode<depth>(hash).uncompressed_node()->size();
+		}
+
+		/**
+		 * Checks that a node that already exists for the hash after an update is the result of the update (see
+		 * NodeVerification). Compressed nodes must hold exactly the planned entry, uncompressed nodes are probed with
+		 * inserted entries. Entries that are removed are only probed at depth 1.
+		 * Nothing is checked if no node exists for the hash after.
+		 * @throws std::runtime_error if the existing node cannot be the result of the update, i.e. on a hash collision
+		 */
+		template<size_t depth>
+		void verifyExistingNode(Modification_t<depth> &update) {
+			using verification = NodeVerification<tri>;
+			// computes the hash after if it was not computed yet
+			const TensorHash hash_after = update.hashAfter();
+			if (hash_after.empty())
+				return;
+
+			size_t expected_size = 0;
+			switch (update.modOp()) {
+				case ModificationOperations::CHANGE_VALUE:
+					expected_size = nodeSize<depth>(update.hashBefore());
+					break;
+				case ModificationOperations::NEW_COMPRESSED_NODE:
+					[[fallthrough]];
+				case ModificationOperations::NEW_UNCOMPRESSED_NODE:
+					expected_size = update.size();
+					break;
+				case ModificationOperations::INSERT_INTO_COMPRESSED_NODE:
+					[[fallthrough]];
+				case ModificationOperations::INSERT_INTO_UNCOMPRESSED_NODE:
+					expected_size = nodeSize<depth>(update.hashBefore()) + update.size();
+					break;
+				case ModificationOperations::REMOVE_FROM_UC:
+					[[fallthrough]];
+				case ModificationOperations::UPDATE_UC:
+					expected_size = update.sizeAfter();
+					break;
+				default:
+					assert(false);
+			}
+			const bool removes = update.modOp() == ModificationOperations::REMOVE_FROM_UC;
+
+			if (hash_after.isCompressed()) {
+				if (expected_size != 1)
+					throw verification::collision(depth, hash_after, "a compressed node exists for a result with more than one entry");
+				if constexpr (not(depth == 1 and tri::is_bool_valued and tri::is_lsb_unused)) {
+					// the entry that remains after a removal is not known here
+					if (removes)
+						return;
+					const CompressedNode<depth, tri> *node = node_storage.template getCompressedNode<depth>(hash_after).compressed_node();
+					if (node == nullptr)
+						return;
+					verification::template verifyCompressed<depth>(node, hash_after, update.firstKey(), update.firstValue());
+				}
+			} else {
+				const UncompressedNode<depth, tri> *node = node_storage.template getUncompressedNode<depth>(hash_after).uncompressed_node();
+				if (node == nullptr)
+					return;
+				verification::template verifyUncompressed<depth>(
+						node, hash_after, expected_size, update.size(), not removes,
+						[&](size_t i, size_t pos) { return update.keyPart(i, pos); },
+						[&](size_t i) { return update.value(i); });
+			}
+		}
+
+		/**
+		 * Verifies all nodes that an update shares before anything is applied, so a collision leaves the storage untouched.
+		 * If a node exists for the hash after, it is verified with verifyExistingNode and shared as a whole. Otherwise, the
+		 * plans of its children are derived like processUpdate derives them, but without changing the storage, and verified
+		 * recursively. Each hash after is verified once per depth.
+		 * @throws std::runtime_error on a hash collision
+		 */
+		template<size_t depth>
+		void verifyPlan(Modification_t<depth> &update) {
+			const TensorHash hash_after = update.hashAfter();
+			if (hash_after.empty())
+				return;
+			if constexpr (depth == 1 and tri::is_bool_valued and tri::is_lsb_unused)
+				if (hash_after.isCompressed())
+					return;
+			if (not verified_hashes.template get<depth>().insert(hash_after).second)
+				return;
+			if (not node_storage.template getNode<depth>(hash_after).null()) {
+				verifyExistingNode<depth>(update);
+				return;
+			}
+			if constexpr (depth > 1) {
+				// compressed nodes have no children
+				if (hash_after.isCompressed())
+					return;
+				if (update.modOp() == ModificationOperations::INSERT_INTO_COMPRESSED_NODE) {
+					// see insertBulkIntoC
+					Modification_t<depth> new_update = update;
+					const CompressedNode<depth, tri> *node_before = node_storage.template getCompressedNode<depth>(update.hashBefore()).compressed_node();
+					new_update.modOp() = ModificationOperations::NEW_UNCOMPRESSED_NODE;
+					appendEntry(new_update, node_before->key(), node_before->value());
+					new_update.hashBefore() = {};
+					verifyNewNodeChildren<depth>(new_update);
+				} else if (update.hashBefore().empty()) {
+					verifyNewNodeChildren<depth>(update);
+				} else {
+					// the node before is copied, so the node after indexes the same positions
+					const UncompressedNode<depth, tri> *node_before = node_storage.template getUncompressedNode<depth>(update.hashBefore()).uncompressed_node();
+					for (const size_t pos : iter::range(depth))
+						if (node_before->isIndexed(pos))
+							verifyChildren<depth>(update, node_before, pos);
+				}
+			}
+		}
+
+		/**
+		 * Verifies the children of a new uncompressed node at the positions that new nodes of depth index.
+		 */
+		template<size_t depth>
+		void verifyNewNodeChildren(const Modification_t<depth> &update) {
+			const auto indexed_positions = node_storage.template indexedPositions<depth>();
+			for (const size_t pos : iter::range(depth))
+				if (indexed_positions[pos])
+					verifyChildren<depth>(update, nullptr, pos);
+		}
+
+		/**
+		 * Derives the plans of the children at pos that update changes and verifies them with verifyPlan.
+		 * @param update the update of the node
+		 * @param node_before the uncompressed node before or nullptr if the node is new
+		 * @param pos the position
+		 */
+		template<size_t depth>
+		void verifyChildren(const Modification_t<depth> &update, const UncompressedNode<depth, tri> *node_before, const size_t pos) {
+			if (update.modOp() == ModificationOperations::CHANGE_VALUE) {
+				// see changeValue
+				if constexpr (not tri::is_bool_valued) {
+					Modification_t<depth - 1> child_update = update.childPlan(pos);
+					child_update.modOp() = ModificationOperations::CHANGE_VALUE;
+					child_update.addEntry(update.entries()[0]);
+					child_update.oldValue() = update.oldValue();
+					child_update.hashBefore() = node_before->child(pos, update.keyPart(0, pos));
+					verifyPlan<depth - 1>(child_update);
+				}
+				return;
+			}
+
+			// maps key parts to the plan of that child. It holds the inserted and the removed entries of the child.
+			robin_hood::unordered_map<key_part_type, Modification_t<depth - 1>> children_updates{};
+			for (const size_t i : iter::range(update.size())) {
+				auto &child_update = children_updates.try_emplace(update.keyPart(i, pos), update.childPlan(pos)).first->second;
+				if (update.modOp() == ModificationOperations::REMOVE_FROM_UC)
+					child_update.addRemovedEntry(update.entries()[i]);
+				else
+					child_update.addEntry(update.entries()[i]);
+			}
+			for (const size_t i : iter::range(update.removedSize()))
+				children_updates.try_emplace(update.removedKeyPart(i, pos), update.childPlan(pos))
+						.first->second.addRemovedEntry(update.removedEntries()[i]);
+
+			for (auto &[key_part, child_update] : children_updates) {
+				TensorHash child_before{};
+				if (node_before != nullptr) {
+					if (auto [key_part_exists, iter] = node_before->find(pos, key_part); key_part_exists) {
+						if constexpr (depth == 2 and tri::is_bool_valued and tri::is_lsb_unused) {
+							const TaggedTensorHash<tri> child = iter->second;
+							if (not child.isCompressed())
+								child_before = child.getTaggedNodeHash();
+							else if (child_update.removedSize() == 0)
+								appendEntry(child_update, RawKey<depth - 1>{child.getKeyPart()}, true);
+							else// the only entry of the child is removed
+								child_update.removedEntries().clear();
+						} else {
+							child_before = iter->second;
+						}
+					}
+				}
+
+				if (child_before.empty()) {
+					assert(child_update.removedSize() == 0);
+					if (child_update.size() == 0)
+						continue;
+					if (child_update.size() == 1) {
+						// the key part is stored in the edge
+						if constexpr (depth == 2 and tri::is_bool_valued and tri::is_lsb_unused)
+							continue;
+						child_update.modOp() = ModificationOperations::NEW_COMPRESSED_NODE;
+					} else
+						child_update.modOp() = ModificationOperations::NEW_UNCOMPRESSED_NODE;
+				} else {
+					child_update.hashBefore() = child_before;
+					const size_t size_before = nodeSize<depth - 1>(child_before);
+					if constexpr (depth == 2 and tri::is_bool_valued and tri::is_lsb_unused)
+						if (size_before + child_update.size() - child_update.removedSize() <= 1)
+							continue;
+					if (not chooseExistingOperation<depth - 1>(child_update, size_before))
+						continue;
+				}
+				verifyPlan<depth - 1>(child_update);
+			}
+		}
+
+	public:
 		template<size_t depth>
 		void apply_update_rek() {
 
@@ -210,10 +604,7 @@ namespace hypertrie::internal::raw {
 					continue;
 				auto nodec = node_storage.template getNode<depth>(hash);
 				if (not nodec.null()){
-					size_t &ref_count = nodec.ref_count();
-					ref_count += diff_u_ptr.count_diff;
-
-					if (ref_count == 0) {
+					if (node_storage.template changeRefCount<depth>(nodec, diff_u_ptr.count_diff) == 0) {
 						unreferenced_nodes_before.insert({hash, nodec.node()});
 					}
 				} else {
@@ -222,7 +613,7 @@ namespace hypertrie::internal::raw {
 				}
 			}
 
-			static std::vector<std::pair<Modification_t<depth>, size_t>> moveable_multi_updates{};
+			LevelCountedModifications<depth> &moveable_multi_updates = this->moveable_multi_updates.template get<depth>();
 			moveable_multi_updates.clear();
 			moveable_multi_updates.reserve(multi_updates.size());
 			// extract movables
@@ -230,6 +621,9 @@ namespace hypertrie::internal::raw {
 				// skip if it cannot be a movable
 				if (update.modOp() == ModificationOperations::NEW_UNCOMPRESSED_NODE or update.modOp() == ModificationOperations::NEW_COMPRESSED_NODE or update.modOp() == ModificationOperations::INSERT_INTO_COMPRESSED_NODE)
 					continue;
+				// an uncompressed node cannot be reused for a compressed one
+				if (update.modOp() == ModificationOperations::REMOVE_FROM_UC and update.hashAfter().isCompressed())
+					continue;
 				// check if it is a moveable. then save it and skip to the next iteration
 				auto unref_before = unreferenced_nodes_before.find(update.hashBefore());
 				if (unref_before != unreferenced_nodes_before.end()) {
@@ -242,7 +636,7 @@ namespace hypertrie::internal::raw {
 				}
 			}
 
-			static std::vector<std::pair<Modification_t<depth>, size_t>> unmoveable_multi_updates{};
+			LevelCountedModifications<depth> &unmoveable_multi_updates = this->unmoveable_multi_updates.template get<depth>();
 			unmoveable_multi_updates.clear();
 			unmoveable_multi_updates.reserve(multi_updates.size());
 			// extract unmovables
@@ -260,13 +654,22 @@ namespace hypertrie::internal::raw {
 			tsl::sparse_map<TensorHash, long> node_before_children_count_diffs{};
 
 			// do unmoveables
+			std::vector<std::pair<UncompressedNode<depth, tri> *, const Modification_t<depth> *>> new_uncompressed_nodes{};
+			const bool parallel = node_storage.modificationThreads() > 1 and unmoveable_multi_updates.size() >= PARALLEL_MIN_NEW_NODES;
 			for (auto &[update, count] : unmoveable_multi_updates) {
 				assert (count > 0);
+				if (parallel and update.modOp() == ModificationOperations::NEW_UNCOMPRESSED_NODE) {
+					// new nodes are independent. they are populated in parallel below
+					new_uncompressed_nodes.emplace_back(constructNewUncompressed<depth>(update, (size_t) count), &update);
+					continue;
+				}
 				const long node_before_children_count_diff = processUpdate<depth, false>(update, (size_t) count);
 
 				if (node_before_children_count_diff != 0)
 					node_before_children_count_diffs[update.hashBefore()] += node_before_children_count_diff;
 			}
+			if (not new_uncompressed_nodes.empty())
+				populateNewUncompressedParallel<depth>(new_uncompressed_nodes);
 
 			// remove remaining unreferenced_nodes_before and update the references of their children
 			for (const auto &[hash_before, node_ptr] : unreferenced_nodes_before) {
@@ -296,6 +699,9 @@ namespace hypertrie::internal::raw {
 
 			if constexpr (depth > 1)
 				apply_update_rek<depth - 1>();
+			// the modification is complete. free the deleted nodes that no reader can reach
+			if constexpr (depth == update_depth)
+				node_storage.reclaim();
 		}
 
 		template<size_t depth>
@@ -362,7 +768,10 @@ namespace hypertrie::internal::raw {
 					newUncompressedBulk<depth>(update, after_count_diff);
 					break;
 				case ModificationOperations::REMOVE_FROM_UC:
-					assert(false);// not yet implemented
+					node_before_children_count_diff = removeBulkFromUC<depth, reuse_node_before>(update, after_count_diff);
+					break;
+				case ModificationOperations::UPDATE_UC:
+					node_before_children_count_diff = updateBulkInUC<depth, reuse_node_before>(update, after_count_diff);
 					break;
 				default:
 					assert(false);
@@ -397,14 +806,14 @@ namespace hypertrie::internal::raw {
 						// change the values of children recursively
 
 
-						static constexpr const auto subkey = &tri::template subkey<depth>;
 						for (const size_t pos : iter::range(depth)) {
-							auto sub_key = subkey(update.firstKey(), pos);
-							auto key_part = update.firstKey()[pos];
+							if (not node_before->isIndexed(pos))
+								continue;
+							auto key_part = update.keyPart(0, pos);
 
-							Modification_t<depth - 1> child_update{};
+							Modification_t<depth - 1> child_update = update.childPlan(pos);
 							child_update.modOp() = ModificationOperations::CHANGE_VALUE;
-							child_update.addEntry(sub_key, update.firstValue());
+							child_update.addEntry(update.entries()[0]);
 							child_update.oldValue() = update.oldValue();
 
 							child_update.hashBefore() = node_before->child(pos, key_part);
@@ -430,14 +839,14 @@ namespace hypertrie::internal::raw {
 
 					if constexpr (compression == NodeCompression::uncompressed and depth > 1) {
 
-						static constexpr const auto subkey = &tri::template subkey<depth>;
 						for (const size_t pos : iter::range(depth)) {
-							auto sub_key = subkey(update.firstKey(), pos);
-							auto key_part = update.firstKey()[pos];
+							if (not node_before->isIndexed(pos))
+								continue;
+							auto key_part = update.keyPart(0, pos);
 
-							Modification_t<depth - 1> child_update{};
+							Modification_t<depth - 1> child_update = update.childPlan(pos);
 							child_update.modOp() = ModificationOperations::CHANGE_VALUE;
-							child_update.addEntry(sub_key, update.firstValue());
+							child_update.addEntry(update.entries()[0]);
 							child_update.oldValue() = update.oldValue();
 
 							child_update.hashBefore() = node_before->child(pos, key_part);
@@ -460,68 +869,203 @@ namespace hypertrie::internal::raw {
 
 		template<size_t depth>
 		void newUncompressedBulk(const Modification_t<depth> &update, const size_t after_count_diff) {
-			// TODO: implement for valued
-			static constexpr const auto subkey = &tri::template subkey<depth>;
-			using red = re<depth>;
-			// move or copy the node from old_hash to new_hash
-			auto &storage = node_storage.template getNodeStorage<depth, NodeCompression::uncompressed>();
+			UncompressedNode<depth, tri> *const node = constructNewUncompressed<depth>(update, after_count_diff);
+			populateNewUncompressed<depth>(node, update, [&](auto &&child_update) {
+				planUpdate(std::move(child_update), INC_COUNT_DIFF_AFTER);
+			});
+			node_storage.template getNodeStorage<depth, NodeCompression::uncompressed>().insert({update.hashAfter(), node});
+		}
+
+		/**
+		 * Creates the node of a NEW_UNCOMPRESSED_NODE update. Its edges are not populated. It must be inserted into the
+		 * storage once it is populated, so the node table counts its complete footprint.
+		 * @return the new node
+		 */
+		template<size_t depth>
+		UncompressedNode<depth, tri> *constructNewUncompressed(const Modification_t<depth> &update, const size_t after_count_diff) {
+			[[maybe_unused]] auto &storage = node_storage.template getNodeStorage<depth, NodeCompression::uncompressed>();
 			// make sure everything is set correctly
 			assert(update.hashBefore().empty());
 			assert(storage.find(update.hashAfter()) == storage.end());
 
-			// create node and insert it into the storage
-			UncompressedNode<depth, tri> *const node = new UncompressedNode<depth, tri>{(size_t) after_count_diff};
-			storage.insert({update.hashAfter(), node});
+			// create node
+			UncompressedNode<depth, tri> *const node = [&]() {
+				if constexpr (depth > 1)
+					return node_storage.template constructNode<depth, NodeCompression::uncompressed>((size_t) after_count_diff, node_storage.template indexedPositions<depth>());
+				else
+					return node_storage.template constructNode<depth, NodeCompression::uncompressed>((size_t) after_count_diff);
+			}();
+			if constexpr (depth == update_depth)
+				this->nodec = {update.hashAfter(), node};
+			return node;
+		}
 
-			if constexpr (depth > 1)
-				node->size_ = update.entries().size();
-
-			// populate the new node
-			for (const size_t pos : iter::range(depth)) {
-				if constexpr (depth == 1) {
-					for (const Entry<depth> &entry : update.entries()){
-						if constexpr (tri_t::is_bool_valued)
-							node->edges().insert(red::key(entry)[0]);
-						else
-							node->edges().emplace(red::key(entry)[0], red::value(entry));
-					}
-				} else {
-					// # group the subkeys by the key part at pos
+		/**
+		 * Populates the edges of a new uncompressed node. It touches no state but the node, so different nodes can be populated concurrently.
+		 * @param node the node
+		 * @param update the update that holds all entries of the node
+		 * @param plan_child called with the plan of every new child
+		 */
+		template<size_t depth, typename PlanChild>
+		void populateNewUncompressed(UncompressedNode<depth, tri> *const node, const Modification_t<depth> &update, PlanChild &&plan_child) {
+			if constexpr (depth == 1) {
+				for (const size_t i : iter::range(update.size())) {
+					if constexpr (tri_t::is_bool_valued)
+						node->edges().insert(update.keyPart(i, 0));
+					else
+						node->edges().emplace(update.keyPart(i, 0), update.value(i));
+				}
+			} else {
+				node->size_ = update.size();
+				for (const size_t pos : iter::range(depth))
+					if (node->isIndexed(pos))
+						newEdges<depth>(node, pos, update, plan_child);
+			}
+		}
 
-					// maps key parts to the keys to be inserted for that child
-					robin_hood::unordered_map<key_part_type, std::vector<Entry<depth - 1>>> children_inserted_keys{};
+		/**
+		 * Populates new uncompressed nodes of one depth on multiple threads and inserts them into the storage afterwards.
+		 * Each thread collects the plans of the children it creates. They are planned afterwards, so the reference count
+		 * changes of all threads are merged.
+		 * @param new_nodes the nodes and their updates
+		 */
+		template<size_t depth>
+		void populateNewUncompressedParallel(const std::vector<std::pair<UncompressedNode<depth, tri> *, const Modification_t<depth> *>> &new_nodes) {
+			if constexpr (depth == 1) {
+				util::parallelFor(new_nodes.size(), node_storage.modificationPool(), [&](size_t, size_t i) {
+					populateNewUncompressed<depth>(new_nodes[i].first, *new_nodes[i].second, [](auto &&) {});
+				});
+			} else {
+				std::vector<std::vector<Modification_t<depth - 1>>> child_updates(node_storage.modificationThreads());
+				util::parallelFor(new_nodes.size(), node_storage.modificationPool(), [&](size_t worker, size_t i) {
+					populateNewUncompressed<depth>(new_nodes[i].first, *new_nodes[i].second, [&](Modification_t<depth - 1> &&child_update) {
+						child_updates[worker].push_back(std::move(child_update));
+					});
+				});
+				for (auto &worker_child_updates : child_updates)
+					for (auto &child_update : worker_child_updates)
+						planUpdate(std::move(child_update), INC_COUNT_DIFF_AFTER);
+			}
+			auto &storage = node_storage.template getNodeStorage<depth, NodeCompression::uncompressed>();
+			for (const auto &[node, update] : new_nodes)
+				storage.insert({update->hashAfter(), node});
+		}
 
-					// populate children_inserted_keys
-					for (const Entry<depth> &entry : update.entries())
-						children_inserted_keys[red::key(entry)[pos]]
-								.push_back(re<depth-1>::make_Entry(subkey(red::key(entry), pos), red::value(entry)));
+		/**
+		 * Populates the edges at pos of a node that has no edges at pos yet. The children are planned as new nodes.
+		 * @tparam depth depth of the node
+		 * @param node the node
+		 * @param pos the position to be populated
+		 * @param update the update that holds all entries of the node
+		 */
+		template<size_t depth>
+		void newEdges(UncompressedNode<depth, tri> *const node, const size_t pos, const Modification_t<depth> &update) {
+			newEdges<depth>(node, pos, update, [&](Modification_t<depth - 1> &&child_update) {
+				planUpdate(std::move(child_update), INC_COUNT_DIFF_AFTER);
+			});
+		}
 
-					// process the changes to the node at pos and plan the updates to the sub nodes
-					for (auto &[key_part, child_inserted_entries] : children_inserted_keys) {
-						assert(child_inserted_entries.size() > 0);
+		/**
+		 * Like newEdges above, but the plans of the children are passed to plan_child instead of being planned.
+		 */
+		template<size_t depth, typename PlanChild>
+		void newEdges(UncompressedNode<depth, tri> *const node, const size_t pos, const Modification_t<depth> &update, PlanChild &&plan_child) {
+			// # group the entries by the key part at pos
+
+			// maps key parts to the plan of that child
+			robin_hood::unordered_map<key_part_type, Modification_t<depth - 1>> children_updates{};
+
+			// populate children_updates
+			for (const size_t i : iter::range(update.size()))
+				children_updates.try_emplace(update.keyPart(i, pos), update.childPlan(pos))
+						.first->second.addEntry(update.entries()[i]);
+
+			// process the changes to the node at pos and plan the updates to the sub nodes
+			for (auto &[key_part, child_update] : children_updates) {
+				assert(child_update.size() > 0);
+
+				// plan the new subnodes and insert references
+				if (child_update.size() == 1){
+					if constexpr (not (depth == 2 and tri::is_bool_valued and tri::is_lsb_unused)) {
+						child_update.modOp() = ModificationOperations::NEW_COMPRESSED_NODE;
+					} else {
+						node->edges(pos)[key_part] = TaggedTensorHash<tri>{child_update.keyPart(0, 0)};
+						continue;
+					}
+				} else
+					child_update.modOp() = ModificationOperations::NEW_UNCOMPRESSED_NODE;
 
-						// plan the new subnodes and insert references
-						Modification_t<depth - 1> child_update{};
-						if (child_inserted_entries.size() == 1){
-							if constexpr (not (depth == 2 and tri::is_bool_valued and tri::is_lsb_unused)) {
-								child_update.modOp() = ModificationOperations::NEW_COMPRESSED_NODE;
-							} else {
-								node->edges(pos)[key_part] = TaggedTensorHash<tri>{child_inserted_entries[0][0]};
-								continue;
-							}
-						} else
-							child_update.modOp() = ModificationOperations::NEW_UNCOMPRESSED_NODE;
-						child_update.entries() = std::move(child_inserted_entries);
+				// insert reference to subnode
+				node->edges(pos)[key_part] = child_update.hashAfter();
+				// submit subnode plan
+				plan_child(std::move(child_update));
+			}
+		}
 
-						// insert reference to subnode
-						node->edges(pos)[key_part] = child_update.hashAfter();
-						// submit subnode plan
-						planUpdate(std::move(child_update), INC_COUNT_DIFF_AFTER);
+		/**
+		 * Collects all entries of a node. Only the edges at position 0 are traversed, they are always indexed.
+		 * @tparam depth depth of the node
+		 * @param nc container of the node
+		 * @param entries output. The entries are appended.
+		 */
+		template<size_t depth>
+		void collectEntries(const NodeContainer<depth, tri> &nc, std::vector<Entry<depth>> &entries) {
+			if (nc.isCompressed()) {
+				if constexpr (not (depth == 1 and tri::is_bool_valued and tri::is_lsb_unused))
+					entries.push_back(re<depth>::make_Entry(nc.compressed_node()->key(), nc.compressed_node()->value()));
+			} else if constexpr (depth == 1) {
+				for (const auto &edge : nc.uncompressed_node()->edges(0)) {
+					if constexpr (tri::is_bool_valued)
+						entries.push_back(re<depth>::make_Entry(RawKey<depth>{edge}, true));
+					else
+						entries.push_back(re<depth>::make_Entry(RawKey<depth>{edge.first}, edge.second));
+				}
+			} else {
+				std::vector<Entry<depth - 1>> child_entries;
+				for (const auto &[key_part, child] : nc.uncompressed_node()->edges(0)) {
+					child_entries.clear();
+					if constexpr (depth == 2 and tri::is_bool_valued and tri::is_lsb_unused) {
+						if (child.isCompressed())
+							child_entries.push_back(RawKey<depth - 1>{child.getKeyPart()});
+						else
+							collectEntries<depth - 1>(node_storage.template getUncompressedNode<depth - 1>(child.getTaggedNodeHash()), child_entries);
+					} else {
+						collectEntries<depth - 1>(node_storage.template getNode<depth - 1>(child), child_entries);
+					}
+					for (const Entry<depth - 1> &child_entry : child_entries) {
+						const RawKey<depth - 1> &sub_key = re<depth - 1>::key(child_entry);
+						RawKey<depth> key;
+						key[0] = key_part;
+						std::copy(sub_key.begin(), sub_key.end(), key.begin() + 1);
+						entries.push_back(re<depth>::make_Entry(key, re<depth - 1>::value(child_entry)));
 					}
 				}
 			}
-			if constexpr (depth == update_depth)
-				this->nodec = {update.hashAfter(), node};
+		}
+
+		/**
+		 * Populates the edges at pos of the uncompressed node in nodec if they are not populated yet.
+		 * Missing children are created. The hash of the node does not change.
+		 * @param pos the position to be indexed
+		 */
+		void apply_index_position(const size_t pos) {
+			if constexpr (update_depth > 1) {
+				UncompressedNode<update_depth, tri> *const node = nodec.uncompressed_node();
+				if (node->isIndexed(pos))
+					return;
+				std::vector<Entry<update_depth>> entries;
+				entries.reserve(node->size());
+				collectEntries<update_depth>(nodec, entries);
+				Modification_t<update_depth> update{&entries_buffer};
+				addRootEntries(update, std::move(entries));
+				if (node_storage.verifyHashes())
+					verifyChildren<update_depth>(update, nullptr, pos);
+				node_storage.template getNodeStorage<update_depth, NodeCompression::uncompressed>().changeInPlace(node, [&](auto *) {
+					node->setIndexed(pos);
+					newEdges<update_depth>(node, pos, update);
+				});
+				apply_update_rek<update_depth - 1>();
+			}
 		}
 
 		template<size_t depth>
@@ -533,15 +1077,13 @@ namespace hypertrie::internal::raw {
 			CompressedNode<depth, tri> const *const node_before = storage[update.hashBefore()];
 
 			update.modOp() = ModificationOperations::NEW_UNCOMPRESSED_NODE;
-			update.addEntry(node_before->key(), node_before->value());
+			appendEntry(update, node_before->key(), node_before->value());
 			update.hashBefore() = {};
 			newUncompressedBulk<depth>(update, after_count_diff);
 		}
 
 		template<size_t depth, bool reuse_node_before = false>
 		long insertBulkIntoUC(const Modification_t<depth> &update, const long after_count_diff) {
-				static constexpr const auto subkey = &tri::template subkey<depth>;
-				using red = re<depth>;
 				const long node_before_children_count_diff =
 						(not reuse_node_before and depth > 1) ? INC_COUNT_DIFF_BEFORE : 0;
 
@@ -551,45 +1093,45 @@ namespace hypertrie::internal::raw {
 				assert(node_it != storage.end());
 				UncompressedNode<depth, tri> *node = node_it->second;
 				if constexpr (reuse_node_before) {// node before ref_count is zero -> maybe reused
-					storage.erase(node_it);
+					storage.eraseMoved(node_it);
 				} else {
-					node = new UncompressedNode<depth, tri>{*node};
+					node = node_storage.template constructNode<depth, NodeCompression::uncompressed>(*node);
 					node->ref_count() = 0;
 				}
 				assert(storage.find(update.hashAfter()) == storage.end());
-				storage[update.hashAfter()] = node;
 
 				// update the node count
 				node->ref_count() += after_count_diff;
 				if constexpr (depth > 1)
-					node->size_ += update.entries().size();
+					node->size_ += update.size();
 
 				// update the node (new_hash)
 				for (const size_t pos : iter::range(depth)) {
 					if constexpr (depth == 1) {
-						for (const Entry <depth> &entry : update.entries()){
+						for (const size_t i : iter::range(update.size())) {
 							if constexpr (tri_t::is_bool_valued)
-								node->edges().insert(red::key(entry)[0]);
+								node->edges().insert(update.keyPart(i, 0));
 							else
-								node->edges().emplace(red::key(entry)[0], red::value(entry));
+								node->edges().emplace(update.keyPart(i, 0), update.value(i));
 						}
 					} else {
-						// # group the subkeys by the key part at pos
+						if (not node->isIndexed(pos))
+							continue;
+						// # group the entries by the key part at pos
 
-						// maps key parts to the keys to be inserted for that child
-						robin_hood::unordered_map<key_part_type, std::vector<Entry<depth - 1>>> children_inserted_keys{};
+						// maps key parts to the plan of that child
+						robin_hood::unordered_map<key_part_type, Modification_t<depth - 1>> children_updates{};
 
-						// populate children_inserted_keys
-						for (const Entry<depth> &entry : update.entries())
-							children_inserted_keys[red::key(entry)[pos]]
-									.push_back(re<depth-1>::make_Entry(subkey(red::key(entry), pos), red::value(entry)));
+						// populate children_updates
+						for (const size_t i : iter::range(update.size()))
+							children_updates.try_emplace(update.keyPart(i, pos), update.childPlan(pos))
+									.first->second.addEntry(update.entries()[i]);
 
 						// process the changes to the node at pos and plan the updates to the sub nodes
-						for (auto &[key_part, child_inserted_entries] : children_inserted_keys) {
-							assert(child_inserted_entries.size() > 0);
+						for (auto &[key_part, child_update] : children_updates) {
+							assert(child_update.size() > 0);
 							auto [key_part_exists, iter] = node->find(pos, key_part);
 
-							Modification_t<depth - 1> child_update{};
 							if constexpr (not (depth == 2 and tri::is_bool_valued and tri::is_lsb_unused)) {
 								if (key_part_exists) {
 									child_update.hashBefore() = iter->second;
@@ -598,7 +1140,7 @@ namespace hypertrie::internal::raw {
 									else
 										child_update.modOp() = ModificationOperations::INSERT_INTO_UNCOMPRESSED_NODE;
 								} else {
-									if (child_inserted_entries.size() == 1)
+									if (child_update.size() == 1)
 										child_update.modOp() = ModificationOperations::NEW_COMPRESSED_NODE;
 									else
 										child_update.modOp() = ModificationOperations::NEW_UNCOMPRESSED_NODE;
@@ -606,15 +1148,15 @@ namespace hypertrie::internal::raw {
 							} else {
 								if (key_part_exists) {
 									if (iter->second.isCompressed()) {
-										child_inserted_entries.push_back({iter->second.getKeyPart()});
+										appendEntry(child_update, RawKey<depth - 1>{iter->second.getKeyPart()}, true);
 										child_update.modOp() = ModificationOperations::NEW_UNCOMPRESSED_NODE;
 									} else {
 										child_update.hashBefore() = iter->second.getTaggedNodeHash();
 										child_update.modOp() = ModificationOperations::INSERT_INTO_UNCOMPRESSED_NODE;
 									}
 								} else {
-									if (child_inserted_entries.size() == 1) {
-										node->edges(pos)[key_part] = TaggedTensorHash<tri>{child_inserted_entries[0][0]};
+									if (child_update.size() == 1) {
+										node->edges(pos)[key_part] = TaggedTensorHash<tri>{child_update.keyPart(0, 0)};
 										continue;
 									} else {
 										child_update.modOp() = ModificationOperations::NEW_UNCOMPRESSED_NODE;
@@ -622,13 +1164,10 @@ namespace hypertrie::internal::raw {
 								}
 							}
 
-
-							child_update.entries() = std::move(child_inserted_entries);
-
 							// execute changes
 							if (key_part_exists)
 								if constexpr (not (depth == 2 and tri::is_bool_valued and tri::is_lsb_unused))
-									tri::template deref<key_part_type, TensorHash>(iter) = child_update.hashAfter();
+									tri::template deref<key_part_type, typename UncompressedNode<depth, tri>::ChildType>(iter) = child_update.hashAfter();
 								else
 									tri::template deref<key_part_type, TaggedTensorHash<tri>>(iter) = child_update.hashAfter();
 							else
@@ -638,6 +1177,8 @@ namespace hypertrie::internal::raw {
 						}
 					}
 				}
+				// the node is inserted once it is complete, so the node table counts its footprint as it is
+				storage.insert({update.hashAfter(), node});
 				if constexpr (depth == update_depth)
 					this->nodec = {update.hashAfter(), node};
 
@@ -645,7 +1186,358 @@ namespace hypertrie::internal::raw {
 
 		}
 
+		/**
+		 * Finds the entry of an uncompressed node that is not removed by update. Exactly one entry must remain.
+		 */
+		template<size_t depth>
+		Entry<depth> remainingEntry(const Modification_t<depth> &update) {
+			using red = re<depth>;
+			std::vector<RawKey<depth>> removed_keys;
+			removed_keys.reserve(update.size());
+			for (const size_t i : iter::range(update.size()))
+				removed_keys.push_back(update.key(i));
+			std::sort(removed_keys.begin(), removed_keys.end());
+
+			std::vector<Entry<depth>> entries;
+			entries.reserve(update.size() + 1);
+			collectEntries<depth>(node_storage.template getUncompressedNode<depth>(update.hashBefore()), entries);
+			for (const Entry<depth> &entry : entries)
+				if (not std::binary_search(removed_keys.begin(), removed_keys.end(), red::key(entry)))
+					return entry;
+			assert(false);
+			return {};
+		}
 
+		/**
+		 * Removes the entries of update from an uncompressed node. If a single entry remains, a compressed node is created instead.
+		 * Children that lose all their entries are dereferenced, the others are planned as REMOVE_FROM_UC updates.
+		 * @return the count diff to be applied to the children of the node before
+		 */
+		template<size_t depth, bool reuse_node_before = false>
+		long removeBulkFromUC(const Modification_t<depth> &update, const long after_count_diff) {
+			using red = re<depth>;
+
+			if (update.hashAfter().isCompressed()) {
+				assert(not reuse_node_before);
+				if constexpr (not(depth == 1 and tri::is_bool_valued and tri::is_lsb_unused)) {
+					const Entry<depth> remaining = remainingEntry<depth>(update);
+					auto nodec_after = node_storage.template newCompressedNode<depth>(
+							red::key(remaining), red::value(remaining), after_count_diff, update.hashAfter());
+					if constexpr (depth == update_depth)
+						this->nodec = nodec_after;
+				}
+				return 0;
+			}
+
+			const long node_before_children_count_diff =
+					(not reuse_node_before and depth > 1) ? INC_COUNT_DIFF_BEFORE : 0;
+
+			// move or copy the node from old_hash to new_hash
+			auto &storage = node_storage.template getNodeStorage<depth, NodeCompression::uncompressed>();
+			auto node_it = storage.find(update.hashBefore());
+			assert(node_it != storage.end());
+			UncompressedNode<depth, tri> *node = node_it->second;
+			if constexpr (reuse_node_before) {// node before ref_count is zero -> maybe reused
+				storage.eraseMoved(node_it);
+			} else {
+				node = node_storage.template constructNode<depth, NodeCompression::uncompressed>(*node);
+				node->ref_count() = 0;
+			}
+			assert(storage.find(update.hashAfter()) == storage.end());
+
+			// update the node count
+			node->ref_count() += after_count_diff;
+
+			if constexpr (depth == 1) {
+				for (const size_t i : iter::range(update.size()))
+					node->edges().erase(update.keyPart(i, 0));
+			} else {
+				node->size_ -= update.size();
+				for (const size_t pos : iter::range(depth)) {
+					if (not node->isIndexed(pos))
+						continue;
+					// maps key parts to the plan of that child
+					robin_hood::unordered_map<key_part_type, Modification_t<depth - 1>> children_updates{};
+					for (const size_t i : iter::range(update.size()))
+						children_updates.try_emplace(update.keyPart(i, pos), update.childPlan(pos))
+								.first->second.addEntry(update.entries()[i]);
+
+					for (auto &[key_part, child_update] : children_updates) {
+						auto [key_part_exists, iter] = node->find(pos, key_part);
+						assert(key_part_exists);
+
+						const size_t removed_count = child_update.size();
+						size_t child_size = 0;
+						if constexpr (depth == 2 and tri::is_bool_valued and tri::is_lsb_unused) {
+							const TaggedTensorHash<tri> child = iter->second;
+							if (child.isCompressed()) {
+								assert(removed_count == 1);
+								node->edges(pos).erase(key_part);
+								continue;
+							}
+							const TensorHash child_hash = child.getTaggedNodeHash();
+							const auto *child_node = node_storage.template getUncompressedNode<depth - 1>(child_hash).uncompressed_node();
+							child_size = child_node->size();
+							if (child_size - removed_count <= 1) {
+								if (removed_count == child_size) {
+									node->edges(pos).erase(key_part);
+								} else {
+									// the remaining key part is stored directly in the edge
+									for (const auto &child_key_part : child_node->edges(0)) {
+										bool removed = false;
+										for (const size_t i : iter::range(removed_count))
+											removed |= child_update.keyPart(i, 0) == child_key_part;
+										if (not removed) {
+											node->edges(pos)[key_part] = TaggedTensorHash<tri>{child_key_part};
+											break;
+										}
+									}
+								}
+								planChangeCount<depth - 1>(child_hash, DEC_COUNT_DIFF_AFTER);
+								continue;
+							}
+							child_update.hashBefore() = child_hash;
+						} else {
+							const TensorHash child_hash = iter->second;
+							child_size = (child_hash.isCompressed())
+												 ? 1
+												 : node_storage.template getUncompressedNode<depth - 1>(child_hash).uncompressed_node()->size();
+							if (removed_count == child_size) {
+								node->edges(pos).erase(key_part);
+								planChangeCount<depth - 1>(child_hash, DEC_COUNT_DIFF_AFTER);
+								continue;
+							}
+							child_update.hashBefore() = child_hash;
+						}
+
+						child_update.modOp() = ModificationOperations::REMOVE_FROM_UC;
+						child_update.sizeAfter() = child_size - removed_count;
+
+						node->edges(pos)[key_part] = child_update.hashAfter();
+						planUpdate(std::move(child_update), INC_COUNT_DIFF_AFTER);
+					}
+				}
+			}
+			storage.insert({update.hashAfter(), node});
+			if constexpr (depth == update_depth)
+				this->nodec = {update.hashAfter(), node};
+
+			return node_before_children_count_diff;
+		}
+
+		/**
+		 * Chooses the operation of an update of an existing node with chooseExistingOperation. If the node before is
+		 * dereferenced, the reference change is planned.
+		 * @return false if no entry remains. The plan must be dropped.
+		 */
+		template<size_t depth>
+		bool planExistingUpdate(Modification_t<depth> &update, const size_t size_before) {
+			const TensorHash hash_before = update.hashBefore();
+			const bool remains = chooseExistingOperation<depth>(update, size_before);
+			if (update.hashBefore().empty())
+				planChangeCount<depth>(hash_before, DEC_COUNT_DIFF_AFTER);
+			return remains;
+		}
+
+		/**
+		 * Chooses the operation of a plan that removes entries from and inserts entries into an existing node. The plan
+		 * must hold the hash of the node before, the inserted entries and the removed entries. Removed entries that are not
+		 * needed by the chosen operation are dropped from the plan:
+		 * - only insertions: INSERT_INTO_COMPRESSED_NODE or INSERT_INTO_UNCOMPRESSED_NODE
+		 * - only removals: REMOVE_FROM_UC
+		 * - a single entry changes its value: CHANGE_VALUE
+		 * - all entries are removed: the node before is dereferenced and a new node is planned
+		 * - otherwise: UPDATE_UC
+		 * The hash before of the plan is cleared if the node before is dereferenced. Nothing else is changed but the plan.
+		 * @param update the plan
+		 * @param size_before number of entries of the node before
+		 * @return false if no entry remains. The node before is dereferenced and the plan must be dropped.
+		 */
+		template<size_t depth>
+		bool chooseExistingOperation(Modification_t<depth> &update, const size_t size_before) {
+			assert(not update.hashBefore().empty());
+			assert(update.removedSize() <= size_before);
+			const size_t size_after = size_before + update.size() - update.removedSize();
+			if (size_after == 0) {
+				update.hashBefore() = {};
+				return false;
+			}
+
+			if (update.removedSize() == 0) {
+				update.modOp() = (hash_before.isCompressed()) ? ModificationOperations::INSERT_INTO_COMPRESSED_NODE
+															  : ModificationOperations::INSERT_INTO_UNCOMPRESSED_NODE;
+			} else if (update.size() == 0) {
+				update.modOp() = ModificationOperations::REMOVE_FROM_UC;
+				update.sizeAfter() = size_after;
+				update.entries() = std::move(update.removedEntries());
+				update.removedEntries().clear();
+			} else if (update.size() == 1 and update.removedSize() == 1 and update.removedKey(0) == update.firstKey()) {
+				update.modOp() = ModificationOperations::CHANGE_VALUE;
+				update.oldValue() = update.removedValue(0);
+				update.removedEntries().clear();
+			} else if (update.removedSize() == size_before) {
+				update.hashBefore() = {};
+				update.removedEntries().clear();
+				update.modOp() = (update.size() == 1) ? ModificationOperations::NEW_COMPRESSED_NODE
+													  : ModificationOperations::NEW_UNCOMPRESSED_NODE;
+			} else {
+				update.modOp() = ModificationOperations::UPDATE_UC;
+				update.sizeAfter() = size_after;
+			}
+			return true;
+		}
+
+		/**
+		 * Removes the removed entries of update from an uncompressed node and inserts the inserted ones. The node stays
+		 * uncompressed. Entries that change their value are changed in place. The children are planned with
+		 * planExistingUpdate, so each child is rewritten once, too.
+		 * @return the count diff to be applied to the children of the node before
+		 */
+		template<size_t depth, bool reuse_node_before = false>
+		long updateBulkInUC(const Modification_t<depth> &update, const long after_count_diff) {
+			const long node_before_children_count_diff =
+					(not reuse_node_before and depth > 1) ? INC_COUNT_DIFF_BEFORE : 0;
+
+			// move or copy the node from old_hash to new_hash
+			auto &storage = node_storage.template getNodeStorage<depth, NodeCompression::uncompressed>();
+			auto node_it = storage.find(update.hashBefore());
+			assert(node_it != storage.end());
+			UncompressedNode<depth, tri> *node = node_it->second;
+			if constexpr (reuse_node_before) {// node before ref_count is zero -> maybe reused
+				storage.eraseMoved(node_it);
+			} else {
+				node = node_storage.template constructNode<depth, NodeCompression::uncompressed>(*node);
+				node->ref_count() = 0;
+			}
+			assert(storage.find(update.hashAfter()) == storage.end());
+
+			// update the node count
+			node->ref_count() += after_count_diff;
+
+			if constexpr (depth == 1) {
+				if constexpr (tri_t::is_bool_valued) {
+					for (const size_t i : iter::range(update.removedSize()))
+						node->edges().erase(update.removedKeyPart(i, 0));
+					for (const size_t i : iter::range(update.size()))
+						node->edges().insert(update.keyPart(i, 0));
+				} else {
+					for (const size_t i : iter::range(update.size())) {
+						if (auto [found, iter] = node->find(0, update.keyPart(i, 0)); found)
+							tri::template deref<key_part_type, value_type>(iter) = update.value(i);
+						else
+							node->edges().emplace(update.keyPart(i, 0), update.value(i));
+					}
+					// entries that changed their value hold the new value already
+					for (const size_t i : iter::range(update.removedSize()))
+						if (auto [found, iter] = node->find(0, update.removedKeyPart(i, 0)); found and iter->second == update.removedValue(i))
+							node->edges().erase(update.removedKeyPart(i, 0));
+				}
+			} else {
+				node->size_ = update.sizeAfter();
+				for (const size_t pos : iter::range(depth)) {
+					if (not node->isIndexed(pos))
+						continue;
+					// maps key parts to the plan of that child
+					robin_hood::unordered_map<key_part_type, Modification_t<depth - 1>> children_updates{};
+					for (const size_t i : iter::range(update.size()))
+						children_updates.try_emplace(update.keyPart(i, pos), update.childPlan(pos))
+								.first->second.addEntry(update.entries()[i]);
+					for (const size_t i : iter::range(update.removedSize()))
+						children_updates.try_emplace(update.removedKeyPart(i, pos), update.childPlan(pos))
+								.first->second.addRemovedEntry(update.removedEntries()[i]);
+
+					for (auto &[key_part, child_update] : children_updates)
+						updateChild<depth>(node, pos, key_part, child_update);
+				}
+			}
+			storage.insert({update.hashAfter(), node});
+			if constexpr (depth == update_depth)
+				this->nodec = {update.hashAfter(), node};
+
+			return node_before_children_count_diff;
+		}
+
+		/**
+		 * Applies the removed and inserted entries of child_update to the child of node at (pos, key_part) and plans the
+		 * update of the child.
+		 */
+		template<size_t depth>
+		void updateChild(UncompressedNode<depth, tri> *const node, const size_t pos, const key_part_type key_part,
+						 Modification_t<depth - 1> &child_update) {
+			auto [key_part_exists, iter] = node->find(pos, key_part);
+			if constexpr (depth == 2 and tri::is_bool_valued and tri::is_lsb_unused) {
+				// compressed children are stored in the edge as their key part
+				const size_t inserted_count = child_update.size();
+				const size_t removed_count = child_update.removedSize();
+				if (not key_part_exists) {
+					assert(removed_count == 0);
+					if (inserted_count == 1) {
+						node->edges(pos)[key_part] = TaggedTensorHash<tri>{child_update.keyPart(0, 0)};
+						return;
+					}
+					child_update.modOp() = ModificationOperations::NEW_UNCOMPRESSED_NODE;
+				} else if (const TaggedTensorHash<tri> child = iter->second; child.isCompressed()) {
+					if (removed_count == 0) {
+						appendEntry(child_update, RawKey<depth - 1>{child.getKeyPart()}, true);
+					} else {
+						// the only entry of the child is removed
+						assert(removed_count == 1);
+						child_update.removedEntries().clear();
+						if (inserted_count == 0) {
+							node->edges(pos).erase(key_part);
+							return;
+						} else if (inserted_count == 1) {
+							node->edges(pos)[key_part] = TaggedTensorHash<tri>{child_update.keyPart(0, 0)};
+							return;
+						}
+					}
+					child_update.modOp() = ModificationOperations::NEW_UNCOMPRESSED_NODE;
+				} else {
+					const TensorHash child_hash = child.getTaggedNodeHash();
+					const auto *child_node = node_storage.template getUncompressedNode<depth - 1>(child_hash).uncompressed_node();
+					const size_t child_size = child_node->size();
+					const size_t size_after = child_size + inserted_count - removed_count;
+					if (size_after <= 1) {
+						if (size_after == 0) {
+							node->edges(pos).erase(key_part);
+						} else if (inserted_count == 1) {
+							// all entries before are removed
+							node->edges(pos)[key_part] = TaggedTensorHash<tri>{child_update.keyPart(0, 0)};
+						} else {
+							// the remaining key part is stored directly in the edge
+							for (const auto &child_key_part : child_node->edges(0)) {
+								bool removed = false;
+								for (const size_t i : iter::range(removed_count))
+									removed |= child_update.removedKeyPart(i, 0) == child_key_part;
+								if (not removed) {
+									node->edges(pos)[key_part] = TaggedTensorHash<tri>{child_key_part};
+									break;
+								}
+							}
+						}
+						planChangeCount<depth - 1>(child_hash, DEC_COUNT_DIFF_AFTER);
+						return;
+					}
+					child_update.hashBefore() = child_hash;
+					planExistingUpdate<depth - 1>(child_update, child_size);
+				}
+			} else {
+				if (not key_part_exists) {
+					assert(child_update.removedSize() == 0);
+					child_update.modOp() = (child_update.size() == 1) ? ModificationOperations::NEW_COMPRESSED_NODE
+																	  : ModificationOperations::NEW_UNCOMPRESSED_NODE;
+				} else {
+					const TensorHash child_hash = iter->second;
+					child_update.hashBefore() = child_hash;
+					if (not planExistingUpdate<depth - 1>(child_update, nodeSize<depth - 1>(child_hash))) {
+						node->edges(pos).erase(key_part);
+						return;
+					}
+				}
+			}
+			node->edges(pos)[key_part] = child_update.hashAfter();
+			planUpdate(std::move(child_update), INC_COUNT_DIFF_AFTER);
+		}
 	};
 }// namespace hypertrie::internal
 
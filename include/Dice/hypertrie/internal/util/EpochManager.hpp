@@ -0,0 +1,199 @@
+#ifndef HYPERTRIE_EPOCHMANAGER_HPP
+#define HYPERTRIE_EPOCHMANAGER_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hypertrie::internal::util {
+
+	/**
+	 * Epoch based memory reclamation for a single writer and any number of readers.
+	 *
+	 * A reader pins the current epoch for the duration of a read. The writer does not free memory that readers may still
+	 * reach. It retires the memory instead, tagged with the current epoch, and frees it in reclaim() once no reader is
+	 * pinned to that epoch or the one after it.
+	 *
+	 * Readers never block. pin() and unpinning are one atomic increment and decrement of the reader count of the
+	 * epoch's parity. The writer advances the epoch only if no reader of the previous parity is left.
+	 *
+	 * retire(), reclaim() and drain() must only be called by the writer.
+	 */
+	class EpochManager {
+	public:
+		/**
+		 * Frees a retired object.
+		 * @param context context passed to retire, e.g. the owner of the object's memory
+		 * @param object the retired object
+		 */
+		using Deleter = void (*)(void *context, void *object);
+
+	private:
+		/**
+		 * Each counter is on its own cache line, so readers of different epochs do not share one.
+		 */
+		struct alignas(64) ReaderCount {
+			std::atomic<std::size_t> count{0};
+		};
+
+		struct Retired {
+			std::uint64_t epoch;
+			void *context;
+			void *object;
+			Deleter deleter;
+		};
+
+		alignas(64) std::atomic<std::uint64_t> epoch_{0};
+
+		std::array<ReaderCount, 2> readers_{};
+
+		/**
+		 * Retired objects in the order they were retired, i.e. ordered by epoch.
+		 */
+		std::vector<Retired> retired_{};
+
+		void unpin(std::uint64_t epoch) noexcept {
+			readers_[epoch & 1].count.fetch_sub(1, std::memory_order_release);
+		}
+
+		/**
+		 * Advances the epoch if no reader is pinned to the previous epoch.
+		 * @return if the epoch was advanced
+		 */
+		bool tryAdvance() noexcept {
+			const std::uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+			if (readers_[(epoch + 1) & 1].count.load(std::memory_order_seq_cst) != 0)
+				return false;
+			epoch_.store(epoch + 1, std::memory_order_seq_cst);
+			return true;
+		}
+
+	public:
+		/**
+		 * Keeps the epoch it was pinned to from being reclaimed until it is destructed.
+		 */
+		class Guard {
+			friend class EpochManager;
+
+			EpochManager *manager_ = nullptr;
+			std::uint64_t epoch_ = 0;
+
+			Guard(EpochManager *manager, std::uint64_t epoch) noexcept : manager_(manager), epoch_(epoch) {}
+
+		public:
+			Guard() noexcept = default;
+
+			Guard(const Guard &) = delete;
+
+			Guard &operator=(const Guard &) = delete;
+
+			Guard(Guard &&other) noexcept : manager_(other.manager_), epoch_(other.epoch_) {
+				other.manager_ = nullptr;
+			}
+
+			Guard &operator=(Guard &&other) noexcept {
+				if (this != &other) {
+					release();
+					manager_ = other.manager_;
+					epoch_ = other.epoch_;
+					other.manager_ = nullptr;
+				}
+				return *this;
+			}
+
+			~Guard() { release(); }
+
+			/**
+			 * Unpins the epoch before the guard is destructed.
+			 */
+			void release() noexcept {
+				if (manager_ != nullptr) {
+					manager_->unpin(epoch_);
+					manager_ = nullptr;
+				}
+			}
+
+			[[nodiscard]] bool active() const noexcept { return manager_ != nullptr; }
+		};
+
+		EpochManager() = default;
+
+		EpochManager(const EpochManager &) = delete;
+
+		EpochManager &operator=(const EpochManager &) = delete;
+
+		~EpochManager() {
+			drain();
+		}
+
+		/**
+		 * Pins the current epoch. Memory that is retired while the guard is alive is not freed.
+		 * @return guard that unpins the epoch when it is destructed
+		 */
+		[[nodiscard]] Guard pin() noexcept {
+			while (true) {
+				const std::uint64_t epoch = epoch_.load(std::memory_order_seq_cst);
+				auto &count = readers_[epoch & 1].count;
+				count.fetch_add(1, std::memory_order_seq_cst);
+				// the writer may have advanced the epoch before the reader was counted. retry with the new epoch.
+				if (epoch_.load(std::memory_order_seq_cst) == epoch)
+					return {this, epoch};
+				count.fetch_sub(1, std::memory_order_release);
+			}
+		}
+
+		/**
+		 * Retires an object. It must not be reachable for readers that pin an epoch from now on.
+		 * @param context passed to deleter
+		 * @param object the object
+		 * @param deleter frees the object once no reader can access it anymore
+		 */
+		void retire(void *context, void *object, Deleter deleter) {
+			retired_.push_back({epoch_.load(std::memory_order_relaxed), context, object, deleter});
+		}
+
+		/**
+		 * Frees all retired objects that no pinned reader can access. Without pinned readers, all retired objects are freed.
+		 */
+		void reclaim() noexcept {
+			if (retired_.empty())
+				return;
+			// an object retired in epoch e is safe after all readers of e have left, i.e. the epoch was advanced twice.
+			if (tryAdvance())
+				tryAdvance();
+			const std::uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+			auto first_kept = std::find_if(retired_.begin(), retired_.end(),
+										   [&](const Retired &retired) { return retired.epoch + 2 > epoch; });
+			for (auto it = retired_.begin(); it != first_kept; ++it)
+				it->deleter(it->context, it->object);
+			retired_.erase(retired_.begin(), first_kept);
+		}
+
+		/**
+		 * Frees all retired objects regardless of pinned readers. Must only be called if no reader is pinned.
+		 */
+		void drain() noexcept {
+			for (const Retired &retired : retired_)
+				retired.deleter(retired.context, retired.object);
+			retired_.clear();
+		}
+
+		/**
+		 * Number of retired objects that are not freed yet.
+		 */
+		[[nodiscard]] std::size_t retiredCount() const noexcept { return retired_.size(); }
+
+		/**
+		 * Number of readers that are currently pinned.
+		 */
+		[[nodiscard]] std::size_t pinnedReaders() const noexcept {
+			return readers_[0].count.load(std::memory_order_relaxed) + readers_[1].count.load(std::memory_order_relaxed);
+		}
+	};
+}// namespace hypertrie::internal::util
+
+#endif//HYPERTRIE_EPOCHMANAGER_HPP
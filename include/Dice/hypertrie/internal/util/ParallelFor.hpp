@@ -0,0 +1,65 @@
+#ifndef HYPERTRIE_PARALLELFOR_HPP
+#define HYPERTRIE_PARALLELFOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+
+#include "Dice/hypertrie/internal/util/ThreadPool.hpp"
+
+namespace hypertrie::internal::util {
+
+	/**
+	 * Calls f(worker, i) for all i in [0, count) on up to pool.threads() threads. The calling thread is worker 0.
+	 * The threads of the pool are reused, so a call does not start or join threads.
+	 *
+	 * The indices are claimed in chunks from a shared counter. A worker that finishes its chunk claims the next one, so
+	 * workers that got cheap items take over the remaining work of slower ones. The first exception thrown by f is rethrown
+	 * after all workers have finished.
+	 * @tparam F callable with signature void(size_t worker, size_t i)
+	 * @param count number of items
+	 * @param pool thread pool whose helpers take part. The calling thread must be the only one that runs jobs on it.
+	 * @param f called for every item
+	 * @param chunk_size number of items claimed at once
+	 * @return number of workers. worker is always smaller than it.
+	 */
+	template<typename F>
+	std::size_t parallelFor(std::size_t count, ThreadPool &pool, F &&f, std::size_t chunk_size = 16) {
+		const std::size_t workers = std::max<std::size_t>(1, std::min(pool.threads(), (count + chunk_size - 1) / chunk_size));
+		if (workers == 1) {
+			for (std::size_t i = 0; i < count; ++i)
+				f(std::size_t(0), i);
+			return 1;
+		}
+
+		std::atomic<std::size_t> next{0};
+		std::exception_ptr error = nullptr;
+		std::atomic_flag error_set = ATOMIC_FLAG_INIT;
+
+		auto work = [&](std::size_t worker) {
+			try {
+				while (true) {
+					const std::size_t begin = next.fetch_add(chunk_size, std::memory_order_relaxed);
+					if (begin >= count)
+						break;
+					const std::size_t end = std::min(count, begin + chunk_size);
+					for (std::size_t i = begin; i < end; ++i)
+						f(worker, i);
+				}
+			} catch (...) {
+				if (not error_set.test_and_set())
+					error = std::current_exception();
+				// stop the other workers
+				next.store(count, std::memory_order_relaxed);
+			}
+		};
+
+		pool.run(workers, work);
+		if (error)
+			std::rethrow_exception(error);
+		return workers;
+	}
+}// namespace hypertrie::internal::util
+
+#endif//HYPERTRIE_PARALLELFOR_HPP
@@ -0,0 +1,70 @@
+#ifndef HYPERTRIE_RADIXSORT_HPP
+#define HYPERTRIE_RADIXSORT_HPP
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace hypertrie::internal::util {
+
+	/**
+	 * Sorts [begin, end) by an integral sort key with a least significant digit radix sort on bytes.
+	 *
+	 * The histograms of all bytes are counted in one pass. Bytes in which all sort keys agree are skipped, so keys with
+	 * small values, e.g. dense ids, need only few passes. Short ranges are sorted with std::sort.
+	 * @tparam T type of the items. Must be cheap to copy.
+	 * @tparam KeyFn callable that returns the integral sort key of an item
+	 * @param begin first item
+	 * @param end end of the items
+	 * @param buffer scratch space. It is resized to the number of items.
+	 * @param key returns the sort key of an item
+	 */
+	template<typename T, typename KeyFn>
+	void radixSort(T *begin, T *end, std::vector<T> &buffer, KeyFn &&key) {
+		using sort_key_type = std::decay_t<decltype(key(*begin))>;
+		static_assert(std::is_integral_v<sort_key_type>);
+		using digits_type = std::make_unsigned_t<sort_key_type>;
+		static constexpr const std::size_t bytes = sizeof(digits_type);
+		// flipping the sign bit orders negative sort keys before positive ones
+		static constexpr const digits_type sign_flip = (std::is_signed_v<sort_key_type>) ? digits_type(1) << (bytes * CHAR_BIT - 1) : 0;
+		static constexpr const std::size_t min_radix_size = 256;
+
+		const std::size_t size = end - begin;
+		if (size < min_radix_size) {
+			std::sort(begin, end, [&](const T &left, const T &right) { return key(left) < key(right); });
+			return;
+		}
+
+		std::array<std::array<std::size_t, 256>, bytes> counts{};
+		for (const T *item = begin; item != end; ++item) {
+			const digits_type digits = digits_type(key(*item)) ^ sign_flip;
+			for (std::size_t byte = 0; byte < bytes; ++byte)
+				++counts[byte][(digits >> (byte * CHAR_BIT)) & 0xFF];
+		}
+
+		buffer.resize(size);
+		T *source = begin;
+		T *target = buffer.data();
+		for (std::size_t byte = 0; byte < bytes; ++byte) {
+			auto &byte_counts = counts[byte];
+			if (std::find(byte_counts.begin(), byte_counts.end(), size) != byte_counts.end())
+				continue;// all items have the same digit
+			std::size_t offset = 0;
+			for (auto &count : byte_counts) {
+				const std::size_t bucket_size = count;
+				count = offset;
+				offset += bucket_size;
+			}
+			for (const T *item = source; item != source + size; ++item)
+				target[byte_counts[((digits_type(key(*item)) ^ sign_flip) >> (byte * CHAR_BIT)) & 0xFF]++] = *item;
+			std::swap(source, target);
+		}
+		if (source != begin)
+			std::copy(source, source + size, begin);
+	}
+}// namespace hypertrie::internal::util
+
+#endif//HYPERTRIE_RADIXSORT_HPP
@@ -0,0 +1,138 @@
+#ifndef HYPERTRIE_SLABALLOCATOR_HPP
+#define HYPERTRIE_SLABALLOCATOR_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace hypertrie::internal::util {
+
+	/**
+	 * A slab allocator for objects of type T.
+	 * Memory is requested from the system in slabs of slab_size objects. Freed slots are kept in a free list and are reused by
+	 * subsequent allocations. All slabs are released at once when the allocator is released or destructed.
+	 *
+	 * Note: Each allocator serves exactly one size class, namely sizeof(T). Use one allocator per object type.
+	 * Note 2: The allocator does not keep track of which slots are in use. Before it is released, all objects must be destroyed
+	 * (unless T is trivially destructible), otherwise their destructors are never run.
+	 * @tparam T type of the allocated objects
+	 * @tparam slab_size number of objects per slab
+	 */
+	template<typename T, std::size_t slab_size = std::max<std::size_t>(1, (std::size_t(1) << 16) / sizeof(T))>
+	class SlabAllocator {
+		static_assert(slab_size > 0);
+
+		/**
+		 * A slot either holds an object or, if it is free, the pointer to the next free slot.
+		 */
+		union Slot {
+			Slot *next_free;
+			alignas(T) std::byte storage[sizeof(T)];
+		};
+
+		/**
+		 * All slabs requested from the system.
+		 */
+		std::vector<std::unique_ptr<Slot[]>> slabs_{};
+
+		/**
+		 * Head of the free list.
+		 */
+		Slot *free_list_ = nullptr;
+
+		/**
+		 * Number of slots in the last slab that have never been used.
+		 */
+		std::size_t untouched_slots_ = 0;
+
+		/**
+		 * Number of objects that are currently allocated.
+		 */
+		std::size_t size_ = 0;
+
+		Slot *allocateSlot() {
+			if (free_list_ != nullptr) {
+				Slot *slot = free_list_;
+				free_list_ = slot->next_free;
+				return slot;
+			}
+			if (untouched_slots_ == 0) {
+				slabs_.emplace_back(new Slot[slab_size]);
+				untouched_slots_ = slab_size;
+			}
+			return &slabs_.back()[slab_size - untouched_slots_--];
+		}
+
+	public:
+		SlabAllocator() = default;
+
+		SlabAllocator(const SlabAllocator &) = delete;
+
+		SlabAllocator &operator=(const SlabAllocator &) = delete;
+
+		SlabAllocator(SlabAllocator &&other) noexcept
+			: slabs_(std::move(other.slabs_)), free_list_(other.free_list_), untouched_slots_(other.untouched_slots_), size_(other.size_) {
+			other.free_list_ = nullptr;
+			other.untouched_slots_ = 0;
+			other.size_ = 0;
+		}
+
+		/**
+		 * Allocates a slot and constructs an object in it.
+		 * @param args arguments forwarded to the constructor of T
+		 * @return pointer to the new object
+		 */
+		template<typename... Args>
+		T *construct(Args &&...args) {
+			Slot *slot = allocateSlot();
+			T *object = new (slot->storage) T(std::forward<Args>(args)...);
+			++size_;
+			return object;
+		}
+
+		/**
+		 * Destroys an object and puts its slot into the free list.
+		 * @param object an object that was allocated by this allocator
+		 */
+		void destroy(T *object) noexcept {
+			assert(object != nullptr);
+			assert(size_ > 0);
+			object->~T();
+			Slot *slot = reinterpret_cast<Slot *>(object);
+			slot->next_free = free_list_;
+			free_list_ = slot;
+			--size_;
+		}
+
+		/**
+		 * Releases all slabs at once. Objects that are still allocated are not destructed.
+		 */
+		void release() noexcept {
+			slabs_.clear();
+			free_list_ = nullptr;
+			untouched_slots_ = 0;
+			size_ = 0;
+		}
+
+		/**
+		 * Number of objects that are currently allocated.
+		 */
+		[[nodiscard]] std::size_t size() const noexcept { return size_; }
+
+		/**
+		 * Number of objects that fit into the slabs requested so far.
+		 */
+		[[nodiscard]] std::size_t capacity() const noexcept { return slabs_.size() * slab_size; }
+
+		/**
+		 * Number of bytes requested from the system.
+		 */
+		[[nodiscard]] std::size_t allocatedBytes() const noexcept { return capacity() * sizeof(Slot); }
+	};
+}// namespace hypertrie::internal::util
+
+#endif//HYPERTRIE_SLABALLOCATOR_HPP
@@ -0,0 +1,141 @@
+#ifndef HYPERTRIE_THREADPOOL_HPP
+#define HYPERTRIE_THREADPOOL_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hypertrie::internal::util {
+
+	/**
+	 * Helper threads that are started once and run jobs together with the calling thread.
+	 *
+	 * The helpers wait on a condition variable between jobs, so running a job costs a notification instead of starting
+	 * and joining threads. Only one thread may run jobs at a time, and a job must not run another job on the same pool.
+	 * The helpers are joined when the pool is resized or destructed.
+	 */
+	class ThreadPool {
+		/**
+		 * Calls the job with the given worker.
+		 */
+		using Invoke = void (*)(void *job, std::size_t worker);
+
+		std::vector<std::thread> helpers_;
+
+		std::mutex mutex_;
+		std::condition_variable start_;
+		std::condition_variable done_;
+
+		/**
+		 * The current job and the number of workers that run it, including the calling thread.
+		 */
+		Invoke invoke_ = nullptr;
+		void *job_ = nullptr;
+		std::size_t workers_ = 0;
+		/**
+		 * Incremented for every job, so helpers do not run a job twice.
+		 */
+		std::size_t generation_ = 0;
+		/**
+		 * Number of helpers that have not finished the current job.
+		 */
+		std::size_t running_ = 0;
+		bool stop_ = false;
+
+		void helperLoop(const std::size_t worker) {
+			std::size_t seen_generation = 0;
+			std::unique_lock lock{mutex_};
+			while (true) {
+				start_.wait(lock, [&]() { return stop_ or generation_ != seen_generation; });
+				if (stop_)
+					return;
+				seen_generation = generation_;
+				if (worker >= workers_)
+					continue;
+				const Invoke invoke = invoke_;
+				void *const job = job_;
+				lock.unlock();
+				invoke(job, worker);
+				lock.lock();
+				if (--running_ == 0)
+					done_.notify_one();
+			}
+		}
+
+		void stopHelpers() {
+			{
+				std::lock_guard lock{mutex_};
+				stop_ = true;
+			}
+			start_.notify_all();
+			for (auto &helper : helpers_)
+				helper.join();
+			helpers_.clear();
+			stop_ = false;
+		}
+
+	public:
+		/**
+		 * @param threads number of threads including the calling thread. 0 is treated as 1.
+		 */
+		explicit ThreadPool(const std::size_t threads = 1) { resize(threads); }
+
+		ThreadPool(const ThreadPool &) = delete;
+
+		ThreadPool &operator=(const ThreadPool &) = delete;
+
+		~ThreadPool() { stopHelpers(); }
+
+		/**
+		 * Number of threads including the calling thread.
+		 */
+		[[nodiscard]] std::size_t threads() const noexcept { return helpers_.size() + 1; }
+
+		/**
+		 * Replaces the helpers. It must not be called while a job runs.
+		 * @param threads number of threads including the calling thread. 0 is treated as 1.
+		 */
+		void resize(const std::size_t threads) {
+			const std::size_t helpers = std::max<std::size_t>(1, threads) - 1;
+			if (helpers == helpers_.size())
+				return;
+			stopHelpers();
+			generation_ = 0;
+			helpers_.reserve(helpers);
+			for (std::size_t worker = 1; worker <= helpers; ++worker)
+				helpers_.emplace_back(&ThreadPool::helperLoop, this, worker);
+		}
+
+		/**
+		 * Calls job(worker) for every worker in [0, workers). The calling thread is worker 0. Returns once all workers
+		 * have returned. job must not throw.
+		 * @param workers number of workers. It is limited to threads().
+		 * @param job callable with signature void(size_t worker)
+		 */
+		template<typename Job>
+		void run(std::size_t workers, Job &job) {
+			workers = std::min(workers, threads());
+			if (workers > 1) {
+				{
+					std::lock_guard lock{mutex_};
+					invoke_ = [](void *job_ptr, std::size_t worker) { (*static_cast<Job *>(job_ptr))(worker); };
+					job_ = &job;
+					workers_ = workers;
+					running_ = workers - 1;
+					++generation_;
+				}
+				start_.notify_all();
+			}
+			job(std::size_t(0));
+			if (workers > 1) {
+				std::unique_lock lock{mutex_};
+				done_.wait(lock, [&]() { return running_ == 0; });
+			}
+		}
+	};
+}// namespace hypertrie::internal::util
+
+#endif//HYPERTRIE_THREADPOOL_HPP
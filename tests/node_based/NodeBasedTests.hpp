@@ -7,6 +7,11 @@
 #include "TestRawDiagonal.hpp"
 #include "TestNodeContext.hpp"
 #include "TestNodeContextRandomized.hpp"
+#include "TestNodeTable.hpp"
+#include "TestMemoryStats.hpp"
+#include "TestSnapshot.hpp"
+#include "TestConcurrentReaders.hpp"
+#include "TestAdaptiveContainer.hpp"
 #include "TestTaggedNodeHash.hpp"
 
 #ifdef HYPERTRIE_ENABLE_LIBTORCH
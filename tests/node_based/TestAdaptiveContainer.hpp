@@ -0,0 +1,114 @@
+#ifndef HYPERTRIE_TESTADAPTIVECONTAINER_HPP
+#define HYPERTRIE_TESTADAPTIVECONTAINER_HPP
+
+#include <map>
+#include <random>
+#include <set>
+
+#include <Dice/hypertrie/internal/container/AdaptiveMap.hpp>
+#include <Dice/hypertrie/internal/container/AdaptiveSet.hpp>
+
+namespace hypertrie::tests::container::adaptive {
+	using namespace hypertrie::internal::container;
+
+	TEST_CASE("adaptive map behaves like std::map", "[AdaptiveContainer]") {
+		adaptive_map_t<unsigned long, long, 4> map;
+		std::map<unsigned long, long> expected;
+		std::mt19937_64 rand{42};
+		// the key range makes the map grow above and shrink below the threshold repeatedly
+		std::uniform_int_distribution<unsigned long> key_dist{0, 12};
+		for (size_t i = 0; i < 5000; ++i) {
+			const unsigned long key = key_dist(rand);
+			switch (rand() % 4) {
+				case 0:
+					REQUIRE(map.erase(key) == expected.erase(key));
+					break;
+				case 1:
+					map[key] += 1;
+					expected[key] += 1;
+					break;
+				default:
+					REQUIRE(map.insert({key, long(i)}).second == expected.insert({key, long(i)}).second);
+			}
+			REQUIRE(map.size() == expected.size());
+			if (map.size() > 4)
+				REQUIRE(not map.isInline());
+			for (const auto &[expected_key, expected_value] : expected) {
+				REQUIRE(map.count(expected_key));
+				REQUIRE(map.at(expected_key) == expected_value);
+				REQUIRE(map.find(expected_key)->second == expected_value);
+			}
+			size_t iterated = 0;
+			for (const auto &[actual_key, actual_value] : map) {
+				REQUIRE(expected.at(actual_key) == actual_value);
+				++iterated;
+			}
+			REQUIRE(iterated == expected.size());
+		}
+		auto copy = map;
+		REQUIRE(copy.size() == map.size());
+		for (const auto &[key, value] : map)
+			REQUIRE(copy.at(key) == value);
+	}
+
+	TEST_CASE("adaptive set behaves like std::set", "[AdaptiveContainer]") {
+		adaptive_set_t<unsigned int, 8> set;
+		std::set<unsigned int> expected;
+		std::mt19937_64 rand{42};
+		std::uniform_int_distribution<unsigned int> key_dist{0, 20};
+		for (size_t i = 0; i < 5000; ++i) {
+			const unsigned int key = key_dist(rand);
+			if (rand() % 3 == 0)
+				REQUIRE(set.erase(key) == expected.erase(key));
+			else
+				REQUIRE(set.insert(key).second == expected.insert(key).second);
+			REQUIRE(set.size() == expected.size());
+			for (const auto &expected_key : expected)
+				REQUIRE(*set.find(expected_key) == expected_key);
+			REQUIRE(std::set<unsigned int>{set.begin(), set.end()} == expected);
+			if (set.isInline())
+				REQUIRE(std::is_sorted(set.begin(), set.end()));
+		}
+	}
+
+	TEST_CASE("adaptive containers shrink when erasing by iterator", "[AdaptiveContainer]") {
+		adaptive_map_t<unsigned long, long, 4> map;
+		adaptive_set_t<unsigned long, 4> set;
+		for (unsigned long key = 0; key < 12; ++key) {
+			map[key] = long(key);
+			set.insert(key);
+		}
+		REQUIRE(not map.isInline());
+		REQUIRE(not set.isInline());
+		// erase the odd keys while iterating
+		for (auto it = map.begin(); it != map.end();) {
+			if (it->first % 2 == 1)
+				it = map.erase(it);
+			else
+				++it;
+		}
+		for (auto it = set.begin(); it != set.end();) {
+			if (*it % 2 == 1)
+				it = set.erase(it);
+			else
+				++it;
+		}
+		REQUIRE(map.size() == 6);
+		REQUIRE(set.size() == 6);
+		// erasing by iterator drops to threshold / 2 entries, so both containers are inline again
+		for (auto it = map.begin(); map.size() > 2;)
+			it = map.erase(it);
+		for (auto it = set.begin(); set.size() > 2;)
+			it = set.erase(it);
+		REQUIRE(map.isInline());
+		REQUIRE(set.isInline());
+		for (const auto &[key, value] : map) {
+			REQUIRE(key % 2 == 0);
+			REQUIRE(map.at(key) == long(key));
+		}
+		for (const auto &key : set)
+			REQUIRE(*set.find(key) == key);
+	}
+}// namespace hypertrie::tests::container::adaptive
+
+#endif//HYPERTRIE_TESTADAPTIVECONTAINER_HPP
@@ -0,0 +1,304 @@
+#ifndef HYPERTRIE_TESTCONCURRENTREADERS_HPP
+#define HYPERTRIE_TESTCONCURRENTREADERS_HPP
+
+#include <Dice/hypertrie/internal/Hypertrie.hpp>
+#include <Dice/hypertrie/internal/HypertrieContext.hpp>
+#include <Dice/hypertrie/internal/util/EpochManager.hpp>
+
+#include <atomic>
+#include <map>
+#include <optional>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "../utils/AssetGenerator.hpp"
+#include "../utils/GenerateTriples.hpp"
+
+namespace hypertrie::tests::concurrent_readers {
+	using namespace hypertrie::tests::utils;
+	using namespace hypertrie::internal;
+
+	TEST_CASE("epochs delay reclamation while readers are pinned", "[Concurrency]") {
+		size_t freed = 0;
+		auto count_freed = [](void *context, void *) { ++*static_cast<size_t *>(context); };
+		util::EpochManager epochs;
+
+		epochs.retire(&freed, nullptr, count_freed);
+		epochs.reclaim();
+		REQUIRE(freed == 1);
+
+		auto guard = epochs.pin();
+		REQUIRE(epochs.pinnedReaders() == 1);
+		epochs.retire(&freed, nullptr, count_freed);
+		epochs.reclaim();
+		epochs.reclaim();
+		REQUIRE(freed == 1);
+		REQUIRE(epochs.retiredCount() == 1);
+
+		// a reader that pins later does not block memory retired before
+		guard.release();
+		auto later_guard = epochs.pin();
+		epochs.reclaim();
+		REQUIRE(freed == 2);
+		epochs.retire(&freed, nullptr, count_freed);
+		epochs.reclaim();
+		REQUIRE(freed == 2);
+		later_guard.release();
+		epochs.reclaim();
+		REQUIRE(freed == 3);
+		REQUIRE(epochs.pinnedReaders() == 0);
+	}
+
+	TEST_CASE("deleted nodes are freed after the readers", "[Concurrency]") {
+		using tr = default_bool_Hypertrie_t;
+		HypertrieContext<tr> context;
+		auto &storage = context.rawContext().storage;
+
+		std::optional<Hypertrie<tr>> hypertrie{std::in_place, 3, context};
+		std::vector<typename tr::Key> keys{{1, 2, 3}, {1, 2, 4}, {2, 5, 3}, {7, 2, 3}};
+		for (const auto &key : keys)
+			hypertrie->set(key, true);
+
+		auto guard = context.readGuard();
+		hypertrie.reset();
+		// the nodes are removed from the storage but their memory is kept
+		REQUIRE(context.memoryStats().total().node_count == 0);
+		REQUIRE(storage.retiredCount() > 0);
+		guard.release();
+
+		Hypertrie<tr> other{3, context};
+		other.set({1, 1, 1}, true);
+		REQUIRE(storage.retiredCount() == 0);
+		REQUIRE(context.memoryStats().total().node_count == 1);
+	}
+
+	TEST_CASE("readers run concurrently with a writer", "[Concurrency]") {
+		using tr = default_bool_Hypertrie_t;
+		using Key = typename tr::Key;
+		utils::resetDefaultRandomNumberGenerator();
+		HypertrieContext<tr> context;
+
+		RawGenerator<3, unsigned long, bool, 1, 20> gen{};
+		std::set<Key> entries;
+		for (const auto &[raw_key, value] : gen.entries(300))
+			entries.insert(Key(raw_key.begin(), raw_key.end()));
+		Hypertrie<tr> read{3, context};
+		for (const auto &key : entries)
+			read.set(key, true);
+		// shares all nodes with read at the start
+		Hypertrie<tr> written{read};
+
+		std::atomic<bool> done = false;
+		std::atomic<size_t> failed_reads = 0;
+		std::vector<std::thread> readers;
+		for (size_t i = 0; i < 3; ++i)
+			readers.emplace_back([&]() {
+				while (not done.load()) {
+					auto guard = context.readGuard();
+					if (read.size() != entries.size())
+						++failed_reads;
+					for (const auto &key : entries)
+						if (not read[key])
+							++failed_reads;
+				}
+			});
+
+		RawGenerator<3, unsigned long, bool, 1, 20> writer_gen{};
+		for (size_t round = 0; round < 200; ++round) {
+			const auto changes = writer_gen.entries(20);
+			for (const auto &[raw_key, value] : changes)
+				written.set(Key(raw_key.begin(), raw_key.end()), round % 2 == 0);
+			Hypertrie<tr> temporary{3, context};
+			for (const auto &[raw_key, value] : changes)
+				temporary.set(Key(raw_key.begin(), raw_key.end()), true);
+		}
+		done = true;
+		for (auto &reader : readers)
+			reader.join();
+
+		REQUIRE(failed_reads == 0);
+		REQUIRE(read.size() == entries.size());
+		context.rawContext().storage.reclaim();
+		REQUIRE(context.rawContext().storage.retiredCount() == 0);
+	}
+
+	TEST_CASE("snapshots keep their version", "[Concurrency]") {
+		using tr = default_long_Hypertrie_t;
+		using Key = typename tr::Key;
+		utils::resetDefaultRandomNumberGenerator();
+		HypertrieContext<tr> context;
+
+		RawGenerator<3, unsigned long, long, 1, 10> gen{1, 5};
+		std::map<Key, long> entries;
+		Hypertrie<tr> live{3, context};
+		for (const auto &[raw_key, value] : gen.entries(200)) {
+			Key key(raw_key.begin(), raw_key.end());
+			entries[key] = value;
+			live.set(key, value);
+		}
+		const size_t node_count = context.memoryStats().total().node_count;
+
+		std::optional<HypertrieSnapshot<tr>> snapshot{live.snapshot()};
+		// taking a snapshot does not copy nodes
+		REQUIRE(context.memoryStats().total().node_count == node_count);
+
+		std::vector<std::pair<Key, long>> changes;
+		for (const auto &[raw_key, value] : gen.entries(100))
+			changes.emplace_back(Key(raw_key.begin(), raw_key.end()), value);
+		for (const auto &[key, value] : entries)
+			if (changes.size() < 150)
+				changes.emplace_back(key, 0);
+		live.set_many(changes);
+		live.set(changes.front().first, 42);
+		std::map<Key, long> live_entries = entries;
+		changes.emplace_back(changes.front().first, 42);
+		for (const auto &[key, value] : changes)
+			if (value == 0)
+				live_entries.erase(key);
+			else
+				live_entries[key] = value;
+		REQUIRE(live.size() == live_entries.size());
+
+		HypertrieSnapshot<tr> copy{*snapshot};
+		REQUIRE(snapshot->size() == entries.size());
+		for (const auto &[key, value] : entries)
+			REQUIRE((*snapshot)[key] == value);
+		REQUIRE(live[changes.front().first] == 42);
+
+		// nodes of the old version are freed when no snapshot references them anymore
+		snapshot.reset();
+		REQUIRE(copy.size() == entries.size());
+		{
+			HypertrieSnapshot<tr> moved{std::move(copy)};
+			REQUIRE(moved.size() == entries.size());
+		}
+		HypertrieContext<tr> fresh_context;
+		Hypertrie<tr> fresh{3, fresh_context};
+		for (const auto &[key, value] : live_entries)
+			fresh.set(key, value);
+		REQUIRE(context.memoryStats().total().node_count == fresh_context.memoryStats().total().node_count);
+	}
+
+	TEST_CASE("snapshots are read while the hypertrie is modified", "[Concurrency]") {
+		using tr = default_bool_Hypertrie_t;
+		using Key = typename tr::Key;
+		utils::resetDefaultRandomNumberGenerator();
+		HypertrieContext<tr> context;
+
+		RawGenerator<3, unsigned long, bool, 1, 20> gen{};
+		std::set<Key> entries;
+		for (const auto &[raw_key, value] : gen.entries(300))
+			entries.insert(Key(raw_key.begin(), raw_key.end()));
+		Hypertrie<tr> live{3, context};
+		for (const auto &key : entries)
+			live.set(key, true);
+		const auto snapshot = live.snapshot();
+
+		std::atomic<bool> done = false;
+		std::atomic<size_t> failed_reads = 0;
+		std::vector<std::thread> readers;
+		for (size_t i = 0; i < 2; ++i)
+			readers.emplace_back([&]() {
+				while (not done.load()) {
+					auto guard = context.readGuard();
+					size_t count = 0;
+					for (const auto &key : snapshot) {
+						if (not entries.count(key))
+							++failed_reads;
+						++count;
+					}
+					if (count != entries.size())
+						++failed_reads;
+				}
+			});
+
+		for (size_t round = 0; round < 100; ++round) {
+			std::vector<std::pair<Key, bool>> changes;
+			for (const auto &[raw_key, value] : gen.entries(30))
+				changes.emplace_back(Key(raw_key.begin(), raw_key.end()), round % 2 == 0);
+			live.set_many(changes);
+		}
+		done = true;
+		for (auto &reader : readers)
+			reader.join();
+
+		REQUIRE(failed_reads == 0);
+		REQUIRE(snapshot.size() == entries.size());
+	}
+
+	TEST_CASE("snapshots are sliced while the hypertrie is modified", "[Concurrency]") {
+		using tr = default_bool_Hypertrie_t;
+		using Key = typename tr::Key;
+		using SliceKey = typename tr::SliceKey;
+		utils::resetDefaultRandomNumberGenerator();
+		HypertrieContext<tr> context;
+		// position 1 is not indexed, so slices of it are scanned. Reads must neither index it nor change any other node
+		context.setIndexedPositions(3, {0, 2});
+
+		RawGenerator<3, unsigned long, bool, 1, 20> gen{};
+		std::set<Key> entries;
+		for (const auto &[raw_key, value] : gen.entries(300))
+			entries.insert(Key(raw_key.begin(), raw_key.end()));
+		Hypertrie<tr> live{3, context};
+		for (const auto &key : entries)
+			live.set(key, true);
+		const auto snapshot = live.snapshot();
+
+		std::map<unsigned long, size_t> first_counts;
+		std::map<unsigned long, size_t> last_counts;
+		std::map<unsigned long, size_t> middle_counts;
+		std::set<unsigned long> middle_key_parts;
+		for (const auto &key : entries) {
+			++first_counts[key[0]];
+			++last_counts[key[2]];
+			++middle_counts[key[1]];
+			middle_key_parts.insert(key[1]);
+		}
+		auto slice_size = [&](const SliceKey &slice_key) -> size_t {
+			auto result = snapshot[slice_key];
+			const auto &sliced = std::get<0>(result);
+			return sliced.has_value() ? sliced->size() : 0;
+		};
+		for (const auto &[key_part, count] : middle_counts)
+			REQUIRE(slice_size({std::nullopt, key_part, std::nullopt}) == count);
+
+		std::atomic<bool> done = false;
+		std::atomic<size_t> failed_reads = 0;
+		std::vector<std::thread> readers;
+		for (size_t i = 0; i < 2; ++i)
+			readers.emplace_back([&]() {
+				while (not done.load()) {
+					auto guard = context.readGuard();
+					for (const auto &[key_part, count] : first_counts)
+						if (slice_size({key_part, std::nullopt, std::nullopt}) != count)
+							++failed_reads;
+					for (const auto &[key_part, count] : last_counts)
+						if (slice_size({std::nullopt, std::nullopt, key_part}) != count)
+							++failed_reads;
+					for (const auto &[key_part, count] : middle_counts)
+						if (slice_size({std::nullopt, key_part, std::nullopt}) != count)
+							++failed_reads;
+					if (snapshot.getCards({0, 1, 2}) != std::vector<size_t>{first_counts.size(), middle_key_parts.size(), last_counts.size()})
+						++failed_reads;
+				}
+			});
+
+		for (size_t round = 0; round < 100; ++round) {
+			std::vector<std::pair<Key, bool>> changes;
+			for (const auto &[raw_key, value] : gen.entries(30))
+				changes.emplace_back(Key(raw_key.begin(), raw_key.end()), round % 2 == 0);
+			live.set_many(changes);
+		}
+		done = true;
+		for (auto &reader : readers)
+			reader.join();
+
+		REQUIRE(failed_reads == 0);
+		const auto *root = static_cast<const raw::UncompressedNode<3, raw::Hypertrie_internal_t<tr>> *>(snapshot.rawNode());
+		REQUIRE(not root->isIndexed(1));
+		REQUIRE(root->edges(1).empty());
+	}
+}// namespace hypertrie::tests::concurrent_readers
+
+#endif//HYPERTRIE_TESTCONCURRENTREADERS_HPP
@@ -1,9 +1,17 @@
 #ifndef HYPERTRIE_TESTHYPERTRIE_H
 #define HYPERTRIE_TESTHYPERTRIE_H
 
+#include <Dice/hypertrie/internal/AsyncBulkInserter.hpp>
+#include <Dice/hypertrie/internal/BulkInserter.hpp>
+#include <Dice/hypertrie/internal/BulkRemover.hpp>
 #include <Dice/hypertrie/internal/Hypertrie.hpp>
 #include <Dice/hypertrie/internal/HypertrieContext.hpp>
 
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <thread>
+
 
 #include <fmt/format.h>
 
@@ -82,6 +90,52 @@ namespace hypertrie::tests::node_context {
 
 	}
 
+	TEST_CASE("test_iterator adaptive containers", "[BoolHypertrie]") {
+		using tr = Hypertrie_t<unsigned long,
+							   bool,
+							   hypertrie::internal::container::adaptive_map,
+							   hypertrie::internal::container::adaptive_set,
+							   false>;
+		constexpr const size_t depth = 4;
+		using key_part_type = typename tr::key_part_type;
+		using value_type = typename tr::value_type;
+
+		// few distinct key parts to get nodes below and above the inline threshold
+		utils::EntryGenerator<depth, key_part_type, value_type,1,15> gen{};
+		auto keys = gen.keys(150);
+
+		HypertrieContext<tr> context;
+		Hypertrie<tr> t{depth, context};
+		for (const auto &key : keys) {
+			t.set(key, true);
+			REQUIRE(t[key]);
+		}
+
+		std::vector<typename tr::Key> actual_keys;
+		for (const auto &key : t)
+			actual_keys.push_back(key);
+
+		REQUIRE(keys.size() == actual_keys.size());
+
+		for (const auto &actual_key : actual_keys)
+			REQUIRE(keys.count(actual_key));
+
+		for (key_part_type key_part : iter::range(1, 15)) {
+			size_t expected_count = 0;
+			for (const auto &key : keys)
+				if (key[0] == key_part and key[3] == key_part)
+					++expected_count;
+			typename tr::SliceKey slice_key = {key_part, {}, {}, {}};
+			auto result = std::get<0>(t[slice_key]);
+			size_t actual_count = 0;
+			if (result.has_value())
+				for (const auto &key : result.value())
+					if (key[2] == key_part)
+						++actual_count;
+			REQUIRE(actual_count == expected_count);
+		}
+	}
+
 	TEST_CASE("test_diagonal", "[BoolHypertrie]") {
 		using tr = default_bool_Hypertrie_t;
 		constexpr const size_t depth = 4;
@@ -135,6 +189,408 @@ namespace hypertrie::tests::node_context {
 
 	}
 
+	TEST_CASE("test_remove", "[BoolHypertrie]") {
+		using tr = default_bool_Hypertrie_t;
+		constexpr const size_t depth = 3;
+		using key_part_type = typename tr::key_part_type;
+		using value_type = typename tr::value_type;
+
+		utils::resetDefaultRandomNumberGenerator();
+		utils::EntryGenerator<depth, key_part_type, value_type, 1, 10> gen{};
+		auto key_set = gen.keys(100);
+		std::vector<typename tr::Key> keys{key_set.begin(), key_set.end()};
+
+		HypertrieContext<tr> context;
+		Hypertrie<tr> t{depth, context};
+		for (const auto &key : keys)
+			t.set(key, true);
+
+		std::shuffle(keys.begin(), keys.end(), utils::defaultRandomNumberGenerator);
+		size_t expected_size = keys.size();
+		for (const auto &key : keys) {
+			REQUIRE(t.set(key, false));
+			REQUIRE(not t[key]);
+			REQUIRE(t.size() == --expected_size);
+		}
+		REQUIRE(t.empty());
+		REQUIRE(context.memoryStats().total().node_count == 0);
+	}
+
+	template<HypertrieTrait tr>
+	void checkBulkInserter(typename BulkInserter<tr>::LookupMode lookup_mode) {
+		constexpr const size_t depth = 3;
+		using key_part_type = typename tr::key_part_type;
+		using value_type = typename tr::value_type;
+		using Key = typename tr::Key;
+
+		utils::resetDefaultRandomNumberGenerator();
+		utils::EntryGenerator<depth, key_part_type, value_type, 1, 12> gen{};
+		std::set<Key> expected;
+
+		HypertrieContext<tr> context;
+		Hypertrie<tr> t{depth, context};
+		for (const size_t round : iter::range(4)) {
+			BulkInserter<tr> inserter{t, 100, lookup_mode};
+			for (auto key : gen.keys(150 * (round + 1))) {
+				if constexpr (tr::lsb_unused)
+					for (auto &key_part : key)
+						key_part <<= 1;
+				expected.insert(key);
+				inserter.add(std::move(key));
+			}
+			inserter.flush();
+			REQUIRE(inserter.size() == 0);
+			REQUIRE(t.size() == expected.size());
+			for (const auto &key : expected)
+				REQUIRE(t[key]);
+		}
+	}
+
+	TEST_CASE("test_bulk_inserter", "[BoolHypertrie]") {
+		using tr = default_bool_Hypertrie_t;
+		SECTION("lookup per entry") { checkBulkInserter<tr>(BulkInserter<tr>::LookupMode::per_entry); }
+		SECTION("batched lookup") { checkBulkInserter<tr>(BulkInserter<tr>::LookupMode::batched); }
+		using lsb_tr = Hypertrie_t<unsigned long, bool, container::tsl_sparse_map, container::tsl_sparse_set, true>;
+		SECTION("batched lookup, unused lsb") { checkBulkInserter<lsb_tr>(BulkInserter<lsb_tr>::LookupMode::batched); }
+	}
+
+	TEST_CASE("test_bulk_inserter valued", "[BoolHypertrie]") {
+		using tr = default_long_Hypertrie_t;
+		constexpr const size_t depth = 3;
+		using Key = typename tr::Key;
+		using DuplicatePolicy = typename BulkInserter<tr>::DuplicatePolicy;
+
+		for (const auto policy : {DuplicatePolicy::overwrite, DuplicatePolicy::sum, DuplicatePolicy::max}) {
+			utils::resetDefaultRandomNumberGenerator();
+			utils::EntryGenerator<depth, unsigned long, long, 1, 8> gen{1, 9};
+			std::map<Key, long> expected;
+
+			HypertrieContext<tr> context;
+			Hypertrie<tr> t{depth, context};
+			for (const size_t round : iter::range(3)) {
+				// the keys repeat within the buffer, across flushes and across rounds
+				BulkInserter<tr> inserter{t, 50, policy};
+				for (const auto &key : gen.keys(100 * (round + 1))) {
+					for ([[maybe_unused]] const auto repetition : iter::range(2)) {
+						const long value = gen.value();
+						auto found = expected.find(key);
+						if (found == expected.end())
+							expected[key] = value;
+						else
+							found->second = internal::raw::combineDuplicate(policy, found->second, value);
+						inserter.add({key, value});
+					}
+				}
+				inserter.flush();
+				REQUIRE(t.size() == expected.size());
+				for (const auto &[key, value] : expected)
+					REQUIRE(t[key] == value);
+			}
+		}
+	}
+
+	template<HypertrieTrait tr>
+	void checkBulkRemover() {
+		constexpr const size_t depth = 3;
+		using key_part_type = typename tr::key_part_type;
+		using value_type = typename tr::value_type;
+		using Key = typename tr::Key;
+
+		utils::resetDefaultRandomNumberGenerator();
+		utils::EntryGenerator<depth, key_part_type, value_type, 1, 12> gen{};
+		std::vector<Key> keys;
+		for (auto key : gen.keys(800)) {
+			if constexpr (tr::lsb_unused)
+				for (auto &key_part : key)
+					key_part <<= 1;
+			keys.push_back(key);
+		}
+
+		HypertrieContext<tr> context;
+		Hypertrie<tr> t{depth, context};
+		{
+			BulkInserter<tr> inserter{t, 0};
+			for (auto key : keys)
+				inserter.add(std::move(key));
+		}
+		std::set<Key> expected{keys.begin(), keys.end()};
+		REQUIRE(t.size() == expected.size());
+
+		std::shuffle(keys.begin(), keys.end(), utils::defaultRandomNumberGenerator);
+		for (const auto round : iter::range(4)) {
+			// removes a quarter of the keys, some of them twice and some that were removed before
+			BulkRemover<tr> remover{t, 50};
+			for (const auto &key : iter::slice(keys, 0UL, keys.size() * (round + 1) / 4)) {
+				remover.add(key);
+				expected.erase(key);
+			}
+			remover.add(keys.front());
+			remover.flush();
+			REQUIRE(remover.size() == 0);
+			REQUIRE(t.size() == expected.size());
+			for (const auto &key : keys)
+				REQUIRE(t[key] == expected.count(key));
+		}
+		REQUIRE(t.empty());
+		REQUIRE(context.memoryStats().total().node_count == 0);
+	}
+
+	TEST_CASE("test_bulk_remover", "[BoolHypertrie]") {
+		SECTION("bool") { checkBulkRemover<default_bool_Hypertrie_t>(); }
+		using lsb_tr = Hypertrie_t<unsigned long, bool, container::tsl_sparse_map, container::tsl_sparse_set, true>;
+		SECTION("unused lsb") { checkBulkRemover<lsb_tr>(); }
+	}
+
+	TEST_CASE("test_hash_verification", "[BoolHypertrie]") {
+		using tr = default_long_Hypertrie_t;
+		constexpr const size_t depth = 3;
+		using Key = typename tr::Key;
+
+		utils::resetDefaultRandomNumberGenerator();
+		utils::EntryGenerator<depth, unsigned long, long, 1, 8> gen{1, 9};
+		std::vector<std::pair<Key, long>> entries;
+		for (const auto &key : gen.keys(200))
+			entries.emplace_back(key, gen.value());
+
+		HypertrieContext<tr> context;
+		context.setHashVerification(true);
+		// t2 holds the same entries as t1, so building it shares the nodes of t1 after they are checked
+		Hypertrie<tr> t1{depth, context};
+		Hypertrie<tr> t2{depth, context};
+		for (const auto &[key, value] : entries)
+			t1.set(key, value);
+		REQUIRE_NOTHROW(t2.set_many(entries));
+		for (const auto &[key, value] : entries)
+			REQUIRE_NOTHROW(t2.set(key, value + 1));
+		for (const auto &[key, value] : entries)
+			REQUIRE_NOTHROW(t1.set(key, value + 1));
+		REQUIRE(t1.size() == entries.size());
+		for (const auto &[key, value] : entries)
+			REQUIRE(t1[key] == t2[key]);
+		for (const auto &[key, _] : entries)
+			REQUIRE_NOTHROW(t2.set(key, 0));
+		REQUIRE(t2.empty());
+	}
+
+	TEST_CASE("test_hash_verification detects collisions", "[BoolHypertrie]") {
+		using tr = default_long_Hypertrie_t;
+		constexpr const size_t depth = 3;
+		using Key = typename tr::Key;
+		using RawKey = hypertrie::internal::RawKey<depth, unsigned long>;
+		using RawSubKey = hypertrie::internal::RawKey<depth - 1, unsigned long>;
+
+		HypertrieContext<tr> context;
+		context.setHashVerification(true);
+		auto &storage = context.rawContext().storage;
+		Hypertrie<tr> t{depth, context};
+		// stores a node with other content under the hash of the node that the next modification results in
+		const auto inject = [&](const auto &key, long value) {
+			constexpr size_t key_depth = std::tuple_size_v<std::decay_t<decltype(key)>>;
+			storage.template newCompressedNode<key_depth>(hypertrie::internal::RawKey<key_depth, unsigned long>{}, 1, 1,
+														  raw::TensorHash::getCompressedNodeHash(key, value));
+		};
+
+		SECTION("insert") {
+			inject(RawKey{1, 2, 3}, 5);
+			REQUIRE_THROWS_AS(t.set(Key{1, 2, 3}, 5), std::runtime_error);
+		}
+
+		SECTION("change value") {
+			t.set(Key{1, 2, 3}, 5);
+			inject(RawKey{1, 2, 3}, 6);
+			REQUIRE_THROWS_AS(t.set(Key{1, 2, 3}, 6), std::runtime_error);
+			REQUIRE(t[Key{1, 2, 3}] == 5);
+		}
+
+		SECTION("bulk build") {
+			// the child of the root at position 0 with key part 1 is the compressed node holding ({2, 3}, 5)
+			inject(RawSubKey{2, 3}, 5);
+			const std::vector<std::pair<Key, long>> entries{{Key{1, 2, 3}, 5}, {Key{4, 5, 6}, 7}};
+			REQUIRE_THROWS_AS(t.set_many(entries), std::runtime_error);
+			// only the injected node exists
+			REQUIRE(context.memoryStats().total().node_count == 1);
+			REQUIRE(t.size() == 0);
+		}
+	}
+
+	TEST_CASE("test_hash_verification leaves the context unchanged on a collision below the root", "[BoolHypertrie]") {
+		using tr = default_long_Hypertrie_t;
+		constexpr const size_t depth = 3;
+		using Key = typename tr::Key;
+		using RawSubKey = hypertrie::internal::RawKey<depth - 1, unsigned long>;
+
+		HypertrieContext<tr> context;
+		context.setHashVerification(true);
+		auto &storage = context.rawContext().storage;
+		Hypertrie<tr> t{depth, context};
+		t.set(Key{1, 2, 3}, 5);
+		t.set(Key{4, 5, 6}, 7);
+		// the next insertion rewrites the root. Its new child at position 0 with key part 7 is the compressed node at
+		// depth 2 holding ({8, 9}, 3). A node with other content is stored under that hash.
+		storage.template newCompressedNode<depth - 1>(RawSubKey{}, 1, 1, raw::TensorHash::getCompressedNodeHash(RawSubKey{8, 9}, 3L));
+		// node counts and reference count sums of all levels
+		const auto counts = [&]() {
+			std::vector<std::size_t> counts;
+			for (const auto &level : storage.memoryStats().levels)
+				for (const auto &stats : {level.compressed, level.uncompressed}) {
+					counts.push_back(stats.node_count);
+					counts.push_back(stats.ref_count_sum);
+				}
+			return counts;
+		};
+		const auto counts_before = counts();
+
+		REQUIRE_THROWS_AS(t.set(Key{7, 8, 9}, 3), std::runtime_error);
+		REQUIRE(counts() == counts_before);
+		REQUIRE(t.size() == 2);
+		REQUIRE(t[Key{1, 2, 3}] == 5);
+		REQUIRE(t[Key{4, 5, 6}] == 7);
+		REQUIRE(t[Key{7, 8, 9}] == 0);
+	}
+
+	TEST_CASE("test_async_bulk_inserter", "[BoolHypertrie]") {
+		constexpr const size_t depth = 3;
+		utils::resetDefaultRandomNumberGenerator();
+
+		SECTION("bool, multiple producers") {
+			using tr = default_bool_Hypertrie_t;
+			using Key = typename tr::Key;
+			utils::EntryGenerator<depth, unsigned long, bool, 1, 15> gen{};
+			std::vector<std::vector<Key>> producer_keys;
+			std::set<Key> expected;
+			for ([[maybe_unused]] const auto producer : iter::range(3)) {
+				const auto keys = gen.keys(1000);
+				producer_keys.emplace_back(keys.begin(), keys.end());
+				expected.insert(keys.begin(), keys.end());
+			}
+
+			HypertrieContext<tr> context;
+			Hypertrie<tr> t{depth, context};
+			t.set(producer_keys[0][0], true);
+			AsyncBulkInserter<tr> inserter{t, 64};
+			std::vector<std::thread> producers;
+			for (auto &keys : producer_keys)
+				producers.emplace_back([&]() {
+					for (auto key : keys)
+						inserter.add(std::move(key));
+				});
+			for (auto &producer : producers)
+				producer.join();
+			inserter.flush();
+			REQUIRE(t.size() == expected.size());
+			for (const auto &key : expected)
+				REQUIRE(t[key]);
+
+			// the inserter can be used further after flushing
+			std::vector<Key> batch{{20, 20, 20}, {20, 21, 20}};
+			inserter.add(std::move(batch));
+			inserter.close();
+			REQUIRE(t.size() == expected.size() + 2);
+		}
+
+		SECTION("long, summed up") {
+			using tr = default_long_Hypertrie_t;
+			using Key = typename tr::Key;
+			utils::EntryGenerator<depth, unsigned long, long, 1, 6> gen{1, 9};
+			std::map<Key, long> expected;
+			HypertrieContext<tr> context;
+			Hypertrie<tr> t{depth, context};
+			{
+				AsyncBulkInserter<tr> inserter{t, 50, AsyncBulkInserter<tr>::DuplicatePolicy::sum};
+				for ([[maybe_unused]] const auto round : iter::range(4))
+					for (const auto &key : gen.keys(150)) {
+						const long value = gen.value();
+						expected[key] += value;
+						inserter.add({key, value});
+					}
+			}
+			REQUIRE(t.size() == expected.size());
+			for (const auto &[key, value] : expected)
+				REQUIRE(t[key] == value);
+		}
+	}
+
+	template<HypertrieTrait tr>
+	void checkSetMany() {
+		constexpr const size_t depth = 3;
+		using key_part_type = typename tr::key_part_type;
+		using value_type = typename tr::value_type;
+		using Key = typename tr::Key;
+
+		utils::resetDefaultRandomNumberGenerator();
+		utils::EntryGenerator<depth, key_part_type, value_type, 1, 8> gen{value_type(1), value_type(5)};
+
+		HypertrieContext<tr> context;
+		Hypertrie<tr> batched{depth, context};
+		Hypertrie<tr> single{depth, context};
+		for (const size_t batch_size : {1, 10, 100, 100, 300}) {
+			std::vector<std::pair<Key, value_type>> batch;
+			for (const auto &key : gen.keys(batch_size)) {
+				// every fourth entry removes a key, some keys are set twice
+				batch.emplace_back(key, (batch.size() % 4 == 3) ? value_type{} : gen.value());
+				if (batch.size() % 7 == 0)
+					batch.emplace_back(key, gen.value());
+			}
+			for (const auto &[key, value] : batch)
+				single.set(key, value);
+			batched.set_many(batch);
+			REQUIRE(batched.size() == single.size());
+			// the nodes are shared if both hypertries are equal
+			REQUIRE(batched.rawNodeContainer()->hash_sized == single.rawNodeContainer()->hash_sized);
+			for (const auto &[key, value] : batch)
+				REQUIRE(batched[key] == single[key]);
+		}
+	}
+
+	TEST_CASE("test_set_many", "[BoolHypertrie]") {
+		SECTION("bool") { checkSetMany<default_bool_Hypertrie_t>(); }
+		SECTION("long") { checkSetMany<default_long_Hypertrie_t>(); }
+		SECTION("double") { checkSetMany<default_double_Hypertrie_t>(); }
+	}
+
+	template<HypertrieTrait tr>
+	void checkGetMany() {
+		constexpr const size_t depth = 3;
+		using key_part_type = typename tr::key_part_type;
+		using value_type = typename tr::value_type;
+		using Key = typename tr::Key;
+
+		utils::resetDefaultRandomNumberGenerator();
+		utils::EntryGenerator<depth, key_part_type, value_type, 1, 12> gen{value_type(1), value_type(5)};
+
+		HypertrieContext<tr> context;
+		Hypertrie<tr> t{depth, context};
+		REQUIRE(t.get_many(std::vector<Key>{{2, 4, 6}}) == std::vector<value_type>{value_type{}});
+		auto shifted = [](Key key) {
+			if constexpr (tr::lsb_unused)
+				for (auto &key_part : key)
+					key_part <<= 1;
+			return key;
+		};
+		for (const auto &key : gen.keys(300))
+			t.set(shifted(key), gen.value());
+
+		// contained and not contained keys, more than one batch
+		std::vector<Key> keys;
+		for (const auto &key : gen.keys(500))
+			keys.push_back(shifted(key));
+		const std::vector<value_type> values = t.get_many(keys);
+		const std::vector<bool> contained = t.contains_many(keys);
+		REQUIRE(values.size() == keys.size());
+		REQUIRE(contained.size() == keys.size());
+		for (size_t i = 0; i < keys.size(); ++i) {
+			REQUIRE(values[i] == t[keys[i]]);
+			REQUIRE(contained[i] == (t[keys[i]] != value_type{}));
+		}
+	}
+
+	TEST_CASE("test_get_many", "[BoolHypertrie]") {
+		SECTION("bool") { checkGetMany<default_bool_Hypertrie_t>(); }
+		SECTION("long") { checkGetMany<default_long_Hypertrie_t>(); }
+		using lsb_tr = Hypertrie_t<unsigned long, bool, container::tsl_sparse_map, container::tsl_sparse_set, true>;
+		SECTION("unused lsb") { checkGetMany<lsb_tr>(); }
+	}
+
 	TEST_CASE("test_slice", "[BoolHypertrie]") {
 		using tr = default_bool_Hypertrie_t;
 		constexpr const size_t depth = 4;
@@ -160,6 +616,314 @@ namespace hypertrie::tests::node_context {
 
 	}
 
+	TEST_CASE("test_contextless_slice_copy", "[BoolHypertrie]") {
+		using tr = default_long_Hypertrie_t;
+		using SliceKey = typename tr::SliceKey;
+
+		HypertrieContext<tr> context;
+		Hypertrie<tr> t{3, context};
+		t.set({1, 2, 3}, 5);
+
+		// the only entry is stored in a compressed node, so the slice is not in the node storage
+		std::optional<const_Hypertrie<tr>> copy;
+		{
+			const_Hypertrie<tr> sliced = std::get<0>(t[SliceKey{1, {}, {}}]).value();
+			REQUIRE(sliced.context() == nullptr);
+			REQUIRE(sliced.size() == 1);
+			const_Hypertrie<tr> assigned = sliced;
+			assigned = std::get<0>(t[SliceKey{{}, 2, {}}]).value();
+			assigned = sliced;
+			copy = assigned;
+			REQUIRE(copy->rawNode() != sliced.rawNode());
+			REQUIRE(*copy == sliced);
+		}
+		REQUIRE(copy->size() == 1);
+		REQUIRE(*copy == std::get<0>(t[SliceKey{1, {}, {}}]).value());
+		const auto *node = static_cast<const raw::CompressedNode<2, raw::Hypertrie_internal_t<tr>> *>(copy->rawNode());
+		REQUIRE(node->key()[0] == 2);
+		REQUIRE(node->key()[1] == 3);
+		REQUIRE(node->value() == 5);
+	}
+
+	TEST_CASE("test_slice_cache", "[BoolHypertrie]") {
+		using tr = default_long_Hypertrie_t;
+		constexpr const size_t depth = 3;
+		using SliceKey = typename tr::SliceKey;
+
+		utils::resetDefaultRandomNumberGenerator();
+		utils::EntryGenerator<depth, unsigned long, long, 1, 6> gen{1, 9};
+
+		HypertrieContext<tr> context;
+		context.setSliceCacheCapacity(8);
+		Hypertrie<tr> t{depth, context};
+
+		// compares the cached results with the results of an uncached traversal
+		auto check = [&](const SliceKey &slice_key) {
+			context.setSliceCacheCapacity(0);
+			auto expected = std::get<0>(t[slice_key]).value();
+			context.setSliceCacheCapacity(8);
+			for ([[maybe_unused]] const auto repetition : iter::range(2)) {
+				auto actual = std::get<0>(t[slice_key]).value();
+				REQUIRE(actual.hash() == expected.hash());
+				REQUIRE(actual.size() == expected.size());
+				REQUIRE(actual.context() == expected.context());
+			}
+		};
+
+		for (const size_t round : iter::range(3)) {
+			for (const auto &key : gen.keys(20 * (round + 1)))
+				t.set(key, gen.value());
+			for (const unsigned long key_part : iter::range(1UL, 7UL)) {
+				check(SliceKey{key_part, {}, {}});
+				check(SliceKey{{}, key_part, {}});
+				check(SliceKey{key_part, {}, key_part});
+			}
+		}
+		const auto stats = context.sliceCacheStats();
+		REQUIRE(stats.hits > 0);
+		REQUIRE(stats.misses > 0);
+		REQUIRE(stats.size <= stats.capacity);
+	}
+
+	TEST_CASE("test_slice_cache drops stale entries", "[BoolHypertrie]") {
+		using tr = default_long_Hypertrie_t;
+		constexpr const size_t depth = 3;
+		using SliceKey = typename tr::SliceKey;
+		using RawKey = hypertrie::internal::RawKey<depth - 1, unsigned long>;
+
+		HypertrieContext<tr> context;
+		Hypertrie<tr> t{depth, context};
+		for (const auto &key : std::vector<typename tr::Key>{{1, 2, 3}, {1, 2, 4}, {1, 5, 3}, {2, 5, 3}})
+			t.set(key, 1);
+		const SliceKey slice_key{1, {}, {}};
+		const auto expected = std::get<0>(t[slice_key]).value();
+
+		context.setSliceCacheCapacity(64);
+		// a managed result whose node is not in the node storage, e.g. because it was deleted since it was cached
+		typename SliceCache<tr>::Result stale{};
+		stale.hash = raw::TensorHash::getCompressedNodeHash(RawKey{7, 7}, 1L).addEntry(RawKey{8, 8}, 1L);
+		stale.managed = true;
+		context.sliceCache().insert(depth, raw::TensorHash(t.hash()), slice_key, stale);
+
+		for ([[maybe_unused]] const auto repetition : iter::range(2)) {
+			auto actual = std::get<0>(t[slice_key]).value();
+			REQUIRE(actual.hash() == expected.hash());
+			REQUIRE(actual.size() == expected.size());
+		}
+		// the stale entry is counted as a miss and replaced by the recomputed result, which is hit afterwards
+		const auto stats = context.sliceCacheStats();
+		REQUIRE(stats.misses == 1);
+		REQUIRE(stats.hits == 1);
+		REQUIRE(stats.size == 1);
+	}
+
+	template<HypertrieTrait tr>
+	void checkSliceMany() {
+		constexpr const size_t depth = 3;
+		using SliceKey = typename tr::SliceKey;
+		using key_part_type = typename tr::key_part_type;
+		using value_type = typename tr::value_type;
+
+		utils::resetDefaultRandomNumberGenerator();
+		utils::EntryGenerator<depth, key_part_type, value_type, 1, 8> gen{};
+
+		HypertrieContext<tr> context;
+		Hypertrie<tr> t{depth, context};
+		// includes key parts that are not contained and duplicates
+		std::vector<key_part_type> key_parts{9, 1, 3, 5, 7, 2, 4, 6, 8, 3};
+
+		// compares the results with slicing once per key part
+		auto check = [&](const SliceKey &slice_key, size_t pos) {
+			auto results = t.slice_many(slice_key, pos, key_parts);
+			REQUIRE(std::is_sorted(results.begin(), results.end(), [](const auto &a, const auto &b) { return a.first < b.first; }));
+			size_t non_empty = 0;
+			for (const key_part_type key_part : std::set<key_part_type>(key_parts.begin(), key_parts.end())) {
+				SliceKey single_slice_key = slice_key;
+				single_slice_key[pos] = key_part;
+				auto expected = t[single_slice_key];
+				auto found = std::find_if(results.begin(), results.end(), [&](const auto &result) { return result.first == key_part; });
+				if (expected.index() == 0) {
+					if (not std::get<0>(expected).has_value() or std::get<0>(expected)->empty()) {
+						REQUIRE(found == results.end());
+						continue;
+					}
+					REQUIRE(found != results.end());
+					const auto &actual = std::get<0>(found->second).value();
+					REQUIRE(actual.hash() == std::get<0>(expected)->hash());
+					REQUIRE(actual.size() == std::get<0>(expected)->size());
+				} else {
+					if (std::get<1>(expected) == value_type{}) {
+						REQUIRE(found == results.end());
+						continue;
+					}
+					REQUIRE(found != results.end());
+					REQUIRE(std::get<1>(found->second) == std::get<1>(expected));
+				}
+				++non_empty;
+			}
+			REQUIRE(results.size() == non_empty);
+		};
+
+		for (const size_t round : iter::range(3)) {
+			for (const auto &key : gen.keys(5 * (round + 1) * (round + 1))) {
+				if constexpr (tr::is_bool_valued)
+					t.set(key, true);
+				else
+					t.set(key, gen.value());
+			}
+			check(SliceKey{{}, {}, {}}, 0);
+			check(SliceKey{{}, {}, {}}, 2);
+			for (const key_part_type key_part : iter::range(key_part_type(1), key_part_type(9))) {
+				check(SliceKey{{}, key_part, {}}, 0);
+				check(SliceKey{key_part, {}, {}}, 1);
+				check(SliceKey{key_part, key_part, {}}, 2);
+				check(SliceKey{key_part, {}, key_part}, 1);
+			}
+		}
+	}
+
+	TEST_CASE("test_slice_many", "[BoolHypertrie]") {
+		checkSliceMany<default_bool_Hypertrie_t>();
+		checkSliceMany<default_long_Hypertrie_t>();
+	}
+
+	template<HypertrieTrait tr>
+	void checkNotIndexedPositions() {
+		constexpr const size_t depth = 3;
+		using Key = typename tr::Key;
+		using SliceKey = typename tr::SliceKey;
+		using KeyPositions = typename tr::KeyPositions;
+		using key_part_type = typename tr::key_part_type;
+		using value_type = typename tr::value_type;
+
+		utils::resetDefaultRandomNumberGenerator();
+		utils::EntryGenerator<depth, key_part_type, value_type, 1, 5> gen{value_type(1), value_type(5)};
+
+		// only position 0 is indexed in nodes of depth 3 and 2. The reference indexes all positions.
+		HypertrieContext<tr> context;
+		context.setIndexedPositions(3, {0});
+		context.setIndexedPositions(2, {0});
+		HypertrieContext<tr> reference_context;
+		Hypertrie<tr> t{depth, context};
+		Hypertrie<tr> reference{depth, reference_context};
+		auto shifted = [](auto key_or_key_part) {
+			if constexpr (tr::lsb_unused) {
+				if constexpr (std::is_same_v<decltype(key_or_key_part), Key>)
+					for (auto &key_part : key_or_key_part)
+						key_part <<= 1;
+				else
+					key_or_key_part <<= 1;
+			}
+			return key_or_key_part;
+		};
+		for (const auto &key : gen.keys(60)) {
+			const value_type value = gen.value();
+			t.set(shifted(key), value);
+			reference.set(shifted(key), value);
+		}
+		const size_t node_count = context.memoryStats().total().node_count;
+
+		auto entries_of = [](const const_Hypertrie<tr> &hypertrie) {
+			std::map<Key, value_type> entries;
+			for (const auto &entry : hypertrie) {
+				if constexpr (tr::is_bool_valued)
+					entries[entry] = true;
+				else
+					entries[entry.first] = entry.second;
+			}
+			return entries;
+		};
+		auto require_same = [&](const auto &result, const auto &expected) {
+			REQUIRE(result.index() == expected.index());
+			if (expected.index() == 0) {
+				const auto &expected_slice = std::get<0>(expected);
+				const auto &result_slice = std::get<0>(result);
+				const bool expected_empty = not expected_slice.has_value() or expected_slice->empty();
+				REQUIRE((not result_slice.has_value() or result_slice->empty()) == expected_empty);
+				if (not expected_empty) {
+					REQUIRE(result_slice->hash() == expected_slice->hash());
+					REQUIRE(entries_of(*result_slice) == entries_of(*expected_slice));
+				}
+			} else {
+				REQUIRE(std::get<1>(result) == std::get<1>(expected));
+			}
+		};
+
+		std::vector<key_part_type> key_parts;
+		for (const key_part_type key_part : iter::range(key_part_type(1), key_part_type(6)))
+			key_parts.push_back(shifted(key_part));
+
+		SECTION("slices") {
+			for (const key_part_type first : key_parts) {
+				require_same(t[SliceKey{{}, first, {}}], reference[SliceKey{{}, first, {}}]);
+				require_same(t[SliceKey{{}, {}, first}], reference[SliceKey{{}, {}, first}]);
+				for (const key_part_type second : key_parts) {
+					require_same(t[SliceKey{{}, first, second}], reference[SliceKey{{}, first, second}]);
+					require_same(t[SliceKey{first, {}, second}], reference[SliceKey{first, {}, second}]);
+					require_same(t[SliceKey{first, second, {}}], reference[SliceKey{first, second, {}}]);
+				}
+				// slices of a result that is not in the node storage
+				auto sliced = t[SliceKey{{}, first, {}}];
+				auto expected = reference[SliceKey{{}, first, {}}];
+				if (std::get<0>(expected).has_value() and not std::get<0>(expected)->empty())
+					for (const key_part_type second : key_parts) {
+						require_same(std::get<0>(sliced)->operator[](SliceKey{second, {}}), std::get<0>(expected)->operator[](SliceKey{second, {}}));
+						require_same(std::get<0>(sliced)->operator[](SliceKey{{}, second}), std::get<0>(expected)->operator[](SliceKey{{}, second}));
+					}
+			}
+		}
+
+		SECTION("slice_many") {
+			auto require_same_many = [&](const SliceKey &slice_key, size_t pos) {
+				auto results = t.slice_many(slice_key, pos, key_parts);
+				auto expected = reference.slice_many(slice_key, pos, key_parts);
+				REQUIRE(results.size() == expected.size());
+				for (size_t i = 0; i < results.size(); ++i) {
+					REQUIRE(results[i].first == expected[i].first);
+					require_same(results[i].second, expected[i].second);
+				}
+			};
+			require_same_many(SliceKey{{}, {}, {}}, 1);
+			require_same_many(SliceKey{{}, {}, {}}, 2);
+			for (const key_part_type key_part : key_parts) {
+				require_same_many(SliceKey{key_part, {}, {}}, 2);
+				require_same_many(SliceKey{{}, key_part, {}}, 2);
+				require_same_many(SliceKey{key_part, {}, key_part}, 1);
+			}
+		}
+
+		SECTION("diagonals") {
+			auto diagonal_of = [&](const const_Hypertrie<tr> &hypertrie, const KeyPositions &positions) {
+				std::map<key_part_type, std::map<Key, value_type>> diagonal;
+				HashDiagonal<tr> d{hypertrie, positions};
+				for (d.begin(); not d.ended(); ++d) {
+					if (positions.size() == depth)
+						diagonal[d.currentKeyPart()][Key{}] = d.currentScalar();
+					else
+						diagonal[d.currentKeyPart()] = entries_of(d.currentHypertrie());
+				}
+				for (const key_part_type key_part : key_parts)
+					REQUIRE(d.find(key_part) == diagonal.contains(key_part));
+				return diagonal;
+			};
+			for (const KeyPositions &positions : std::vector<KeyPositions>{{1}, {2}, {1, 2}, {0, 2}, {0, 1, 2}})
+				REQUIRE(diagonal_of(t, positions) == diagonal_of(reference, positions));
+		}
+
+		// reads do not add nodes or indexes
+		REQUIRE(context.memoryStats().total().node_count == node_count);
+		const auto *root = static_cast<const raw::UncompressedNode<depth, raw::Hypertrie_internal_t<tr>> *>(t.rawNode());
+		REQUIRE(not root->isIndexed(1));
+		REQUIRE(not root->isIndexed(2));
+	}
+
+	TEST_CASE("slices and diagonals of positions that are not indexed", "[BoolHypertrie]") {
+		SECTION("bool") { checkNotIndexedPositions<default_bool_Hypertrie_t>(); }
+		SECTION("long") { checkNotIndexedPositions<default_long_Hypertrie_t>(); }
+		using lsb_tr = Hypertrie_t<unsigned long, bool, container::tsl_sparse_map, container::tsl_sparse_set, true>;
+		SECTION("unused lsb") { checkNotIndexedPositions<lsb_tr>(); }
+	}
+
 };// namespace hypertrie::tests::node_context
 
 #endif//HYPERTRIE_TESTHYPERTRIE_H
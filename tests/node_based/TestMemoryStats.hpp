@@ -0,0 +1,124 @@
+#ifndef HYPERTRIE_TESTMEMORYSTATS_HPP
+#define HYPERTRIE_TESTMEMORYSTATS_HPP
+
+#include <Dice/hypertrie/internal/raw/storage/NodeContext.hpp>
+
+#include <random>
+
+namespace hypertrie::tests::raw::memory_stats {
+	using namespace hypertrie::internal::raw;
+
+	TEST_CASE("memory stats of a node storage", "[MemoryStats]") {
+		using tr = default_bool_Hypertrie_internal_t;
+		constexpr pos_type depth = 3;
+		using Key = typename tr::template RawKey<depth>;
+		constexpr size_t key_part_size = sizeof(typename tr::key_part_type);
+
+		NodeContext<depth, tr> context{};
+		UncompressedNodeContainer<depth, tr> nc{};
+
+		SECTION("empty storage") {
+			auto stats = context.storage.memoryStats();
+			REQUIRE(stats.levels.size() == depth);
+			REQUIRE(stats.total().node_count == 0);
+			REQUIRE(stats.total().ref_count_sum == 0);
+			REQUIRE(stats.total().dedupRatio() == 0.0);
+		}
+
+		SECTION("shared nodes") {
+			context.template bulk_insert<depth>(nc, {Key{1, 2, 3}, Key{1, 2, 4}});
+			auto stats = context.storage.memoryStats();
+			REQUIRE(stats.levels.size() == depth);
+			for (const auto &level : stats.levels)
+				REQUIRE(level.depth == (&level - stats.levels.data()) + 1);
+
+			// [1,2,3], [1,2,4]
+			const auto &level_3 = stats.levels[2];
+			REQUIRE(level_3.uncompressed.node_count == 1);
+			REQUIRE(level_3.uncompressed.ref_count_sum == 1);
+			REQUIRE(level_3.uncompressed.key_bytes == 4 * key_part_size);
+			REQUIRE(level_3.compressed.node_count == 0);
+
+			// [2,3], [2,4] and [1,3], [1,4] uncompressed; [1,2] compressed is referenced twice
+			const auto &level_2 = stats.levels[1];
+			REQUIRE(level_2.uncompressed.node_count == 2);
+			REQUIRE(level_2.uncompressed.ref_count_sum == 2);
+			REQUIRE(level_2.compressed.node_count == 1);
+			REQUIRE(level_2.compressed.ref_count_sum == 2);
+			REQUIRE(level_2.compressed.dedupRatio() == 2.0);
+			REQUIRE(level_2.compressed.key_bytes == 2 * key_part_size);
+
+			// [3], [4] is referenced twice, [1] and [2] are referenced twice each
+			const auto &level_1 = stats.levels[0];
+			REQUIRE(level_1.uncompressed.node_count == 1);
+			REQUIRE(level_1.uncompressed.ref_count_sum == 2);
+			REQUIRE(level_1.compressed.node_count == 2);
+			REQUIRE(level_1.compressed.ref_count_sum == 4);
+
+			const auto total = stats.total();
+			REQUIRE(total.node_count == 7);
+			REQUIRE(total.allocator_bytes >= total.node_bytes);
+			REQUIRE(total.table_bytes > 0);
+			REQUIRE(total.totalBytes() > total.node_bytes);
+			REQUIRE(fmt::format("{}", stats).find("uncompressed") != std::string::npos);
+
+			SECTION("removing the last reference frees all nodes") {
+				context.template decrRefCount<depth>(nc);
+				REQUIRE(context.storage.memoryStats().total().node_count == 0);
+			}
+		}
+	}
+
+	template<HypertrieInternalTrait tr>
+	void checkRunningSums(const NodeContext<3, tr> &context) {
+		const auto stats = context.storage.memoryStats();
+		const auto exact = context.storage.exactMemoryStats();
+		REQUIRE(stats.levels.size() == exact.levels.size());
+		for (const size_t i : iter::range(stats.levels.size())) {
+			REQUIRE(stats.levels[i].compressed == exact.levels[i].compressed);
+			REQUIRE(stats.levels[i].uncompressed == exact.levels[i].uncompressed);
+		}
+	}
+
+	template<HypertrieInternalTrait tr>
+	void runningSumsAfterModifications() {
+		constexpr pos_type depth = 3;
+		using Key = typename tr::template RawKey<depth>;
+		using value_type = typename tr::value_type;
+
+		NodeContext<depth, tr> context{};
+		NodeContainer<depth, tr> nc{};
+		NodeContainer<depth, tr> copy{};
+
+		std::mt19937_64 rand{42};
+		std::uniform_int_distribution<size_t> key_part_dist{1, 8};
+		for (const size_t i : iter::range(500)) {
+			const Key key{key_part_dist(rand), key_part_dist(rand), key_part_dist(rand)};
+			// non-zero values of existing entries are changed, 0 removes the entry
+			context.template set<depth>(nc, key, value_type(rand() % 3));
+			if (i % 100 == 0) {
+				if (not copy.empty())
+					context.template decrRefCount<depth>(copy);
+				copy = nc;
+				if (not copy.empty())
+					context.template incRefCount<depth>(copy);
+			}
+			if (i == 250)
+				context.template indexPositions<depth>(std::bitset<depth>{0b111});
+		}
+		checkRunningSums(context);
+
+		for (auto *nodec : {&nc, &copy})
+			if (not nodec->empty())
+				context.template decrRefCount<depth>(*nodec);
+		checkRunningSums(context);
+		REQUIRE(context.storage.memoryStats().total().node_count == 0);
+	}
+
+	TEST_CASE("running memory sums equal the exact memory stats", "[MemoryStats]") {
+		SECTION("bool") { runningSumsAfterModifications<default_bool_Hypertrie_internal_t>(); }
+		SECTION("long") { runningSumsAfterModifications<default_long_Hypertrie_internal_t>(); }
+	}
+};// namespace hypertrie::tests::raw::memory_stats
+
+#endif//HYPERTRIE_TESTMEMORYSTATS_HPP
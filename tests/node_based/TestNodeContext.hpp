@@ -559,6 +559,51 @@ namespace hypertrie::tests::raw::node_context {
 		}
 	}
 
+	TEST_CASE("bulk set changes the values of present entries", "[NodeContext]") {
+		using tr = default_long_Hypertrie_internal_t;
+		constexpr pos_type depth = 3;
+		using Key = typename tr::template RawKey<depth>;
+
+		NodeContext<depth, tr> context{};
+		UncompressedNodeContainer<depth, tr> nc{};
+		auto tt = TestTensor<depth, tr>::getPrimary();
+
+		std::vector<std::pair<Key, long>> entries;
+		for (unsigned long a = 1; a < 4; ++a)
+			for (unsigned long b = 1; b < 4; ++b)
+				entries.push_back({{a, b, a + b}, long(a * 10 + b)});
+		context.template bulk_set<depth>(nc, entries);
+		for (const auto &[key, value] : entries)
+			tt.set(key, value);
+		tt.checkContext(context);
+
+		SECTION("a single entry") {
+			// every node on the path of the key holds other entries, too. They change only the value.
+			context.template bulk_set<depth>(nc, {{{2, 2, 4}, 5}});
+			tt.set({2, 2, 4}, 5);
+			tt.checkContext(context);
+		}
+
+		SECTION("all entries") {
+			for (auto &[key, value] : entries)
+				value = -value;
+			context.template bulk_set<depth>(nc, entries);
+			for (const auto &[key, value] : entries)
+				tt.set(key, value);
+			tt.checkContext(context);
+		}
+
+		SECTION("together with new and removed entries") {
+			const std::vector<std::pair<Key, long>> changes{{{1, 1, 2}, 7}, {{1, 2, 3}, 0}, {{1, 3, 3}, 8}, {{3, 3, 6}, 9}, {{3, 1, 1}, 4}};
+			context.template bulk_set<depth>(nc, changes);
+			for (const auto &[key, value] : changes)
+				tt.set(key, value);
+			tt.checkContext(context);
+			for (const auto &[key, value] : changes)
+				REQUIRE(context.template get<depth>(nc, key) == value);
+		}
+	}
+
 
 };// namespace hypertrie::tests::node_context
 
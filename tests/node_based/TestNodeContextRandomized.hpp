@@ -1,13 +1,19 @@
 #ifndef HYPERTRIE_TESTNODECONTEXTRANDOMIZED_H
 #define HYPERTRIE_TESTNODECONTEXTRANDOMIZED_H
 
+#include <algorithm>
+#include <bitset>
 #include <iterator>
+#include <map>
+#include <stdexcept>
+#include <set>
 
 #include <Dice/hypertrie/internal/raw/storage/NodeContext.hpp>
 
 #include <fmt/format.h>
 
 #include "../utils/AssetGenerator.hpp"
+#include "../utils/GenerateTriples.hpp"
 #include "../utils/NameOfType.hpp"
 #include "TestTensor.hpp"
 
@@ -117,6 +123,62 @@ namespace hypertrie::tests::raw::node_context::randomized {
 			}
 	}
 
+	TEST_CASE("Test Randomized double bulk long -> bool, swizzled edges", "[NodeContext]") {
+		using tr = Hypertrie_internal_t<Hypertrie_t<unsigned long,
+				bool,
+				hypertrie::internal::container::tsl_sparse_map,
+				hypertrie::internal::container::tsl_sparse_set,
+				false,
+				true>>;
+		constexpr pos_type depth = 3;
+
+		using key_part_type = typename tr::key_part_type;
+		using value_type = typename tr::value_type;
+		using Key = typename tr::template RawKey<depth>;
+
+		static utils::RawGenerator<depth, key_part_type, value_type, 0, 10> gen{};
+
+		NodeContext<depth, tr> context{};
+		// create emtpy primary node
+		UncompressedNodeContainer<depth, tr> nc{};
+		auto tt = TestTensor<depth, tr>::getPrimary();
+
+
+		for (size_t count : iter::range(3,50))
+			SECTION("insert {} key "_format(count)) {
+				for (const auto i : iter::range(10)) {
+					SECTION("{}"_format(i)) {
+						// generate entries
+						auto temp_keys = gen.keys(2*count);
+						auto middle_it = temp_keys.begin();
+						std::advance(middle_it,count);
+						std::vector<std::vector<Key>> keyss{
+								{temp_keys.begin(), middle_it},
+								{middle_it, temp_keys.end()}};
+
+						std::vector<Key> inserted_keys{};
+						for (std::vector<Key> &keys: keyss){
+							// insert entries into test tensor
+							for (auto &key : keys) {
+								tt.set(key, true);
+							}
+
+							// bulk insert keys
+							context.template bulk_insert<depth>(nc, keys);
+							// check if they were inserted correctly
+							tt.checkContext(context);
+
+							// read twice: the first read fills the cached child pointers, the second one uses them
+							inserted_keys.insert(inserted_keys.end(), keys.begin(), keys.end());
+							for ([[maybe_unused]] auto round : iter::range(2))
+								for (const auto &key : inserted_keys)
+									REQUIRE(context.get(nc, key));
+						}
+					}
+				}
+			}
+	}
+
 	TEST_CASE("Test Randomized double bulk long -> bool, unused_lsb", "[NodeContext]") {
 		using tr = Hypertrie_internal_t<Hypertrie_t<unsigned long,
 				bool,
@@ -179,6 +241,429 @@ namespace hypertrie::tests::raw::node_context::randomized {
 			}
 	}
 
+	/**
+	 * Inserts entries into a context that indexes only positions 0 and 2 at depth 3 and only position 0 at depth 2.
+	 * Checks that the entries are retrievable, that reads do not index position 1, that the writer indexes it explicitly and that the
+	 * reference counts stay consistent.
+	 */
+	template<HypertrieInternalTrait tr>
+	void checkPartialPositionIndexes() {
+		constexpr pos_type depth = 3;
+
+		using key_part_type = typename tr::key_part_type;
+		using value_type = typename tr::value_type;
+		using Key = typename tr::template RawKey<depth>;
+		using SubKey = typename tr::template RawKey<depth - 1>;
+
+		static utils::RawGenerator<depth, key_part_type, value_type, 0, 10> gen{value_type(1), value_type(5)};
+
+		for (size_t count : iter::range(3, 50, 7))
+			SECTION("insert {} key "_format(count)) {
+				for (const auto i : iter::range(10)) {
+					SECTION("{}"_format(i)) {
+						NodeContext<depth, tr> context{};
+						context.storage.template indexedPositions<3>(std::bitset<3>{0b101});
+						context.storage.template indexedPositions<2>(std::bitset<2>{0b01});
+						UncompressedNodeContainer<depth, tr> nc{};
+						std::map<Key, value_type> entries{};
+
+						auto insert = [&](const auto &keys) {
+							if constexpr (tr::is_bool_valued) {
+								context.template bulk_insert<depth>(nc, {keys.begin(), keys.end()});
+								for (const auto &key : keys)
+									entries[key] = true;
+							} else {
+								for (const auto &key : keys) {
+									const value_type value = gen.value();
+									context.template set<depth>(nc, key, value);
+									entries[key] = value;
+								}
+							}
+						};
+
+						auto slices = [&]() {
+							std::map<key_part_type, std::map<SubKey, value_type>> slices{};
+							for (const auto &[key, value] : entries)
+								slices[key[1]][tr::template subkey<depth>(key, 1)] = value;
+							return slices;
+						};
+
+						auto check = [&]() {
+							for (const auto &[key, value] : entries)
+								REQUIRE(context.template get<depth>(nc, key) == value);
+
+							for (const auto &[key_part, slice_entries] : slices()) {
+								auto child = context.template getChild<depth>(nc, 1, key_part);
+								REQUIRE(not child.empty());
+								if (slice_entries.size() == 1)
+									REQUIRE(child.isCompressed());
+								else
+									REQUIRE(child.uncompressed_node()->size() == slice_entries.size());
+								for (const auto &[sub_key, value] : slice_entries)
+									REQUIRE(context.template get<depth - 1>(child, sub_key) == value);
+							}
+							REQUIRE(nc.uncompressed_node()->isIndexed(1));
+							REQUIRE(nc.uncompressed_node()->edges(1).size() == slices().size());
+						};
+
+						auto temp_keys = gen.keys(2 * count);
+						std::vector<Key> keys{temp_keys.begin(), temp_keys.end()};
+						if constexpr (tr::is_lsb_unused)
+							for (auto &key : keys)
+								for (auto &key_part : key)
+									key_part <<= 1;
+						std::vector<Key> first_keys{keys.begin(), keys.begin() + keys.size() / 2};
+						std::vector<Key> second_keys{keys.begin() + keys.size() / 2, keys.end()};
+
+						insert(first_keys);
+						REQUIRE(not nc.uncompressed_node()->isIndexed(1));
+						REQUIRE(nc.uncompressed_node()->edges(1).empty());
+
+						// reads count position 1 by a scan and do not index it
+						for (const auto &[key, value] : entries)
+							REQUIRE(context.template get<depth>(nc, key) == value);
+						REQUIRE(context.template getCards<depth>(nc, {1})[0] == slices().size());
+						REQUIRE_THROWS_AS(context.template getChild<depth>(nc, 1, slices().begin()->first), std::logic_error);
+						REQUIRE(not nc.uncompressed_node()->isIndexed(1));
+						REQUIRE(nc.uncompressed_node()->edges(1).empty());
+
+						// the writer indexes position 1 explicitly
+						context.template indexPosition<depth>(nc, 1);
+						check();
+
+						// the index is maintained by later inserts
+						insert(second_keys);
+						check();
+
+						// all nodes are freed when the last reference is removed
+						context.template decrRefCount<depth>(nc);
+						REQUIRE(context.storage.template getNodeStorage<3, NodeCompression::uncompressed>().empty());
+						REQUIRE(context.storage.template getNodeStorage<3, NodeCompression::compressed>().empty());
+						REQUIRE(context.storage.template getNodeStorage<2, NodeCompression::uncompressed>().empty());
+						REQUIRE(context.storage.template getNodeStorage<2, NodeCompression::compressed>().empty());
+						REQUIRE(context.storage.template getNodeStorage<1, NodeCompression::uncompressed>().empty());
+					}
+				}
+			}
+	}
+
+	TEST_CASE("Test Randomized partial position indexes long -> bool", "[NodeContext]") {
+		checkPartialPositionIndexes<default_bool_Hypertrie_internal_t>();
+	}
+
+	TEST_CASE("Test Randomized partial position indexes long -> bool, unused_lsb", "[NodeContext]") {
+		checkPartialPositionIndexes<Hypertrie_internal_t<Hypertrie_t<unsigned long,
+				bool,
+				hypertrie::internal::container::std_map,
+				hypertrie::internal::container::std_set,
+				true>>>();
+	}
+
+	TEST_CASE("Test Randomized partial position indexes long -> long", "[NodeContext]") {
+		checkPartialPositionIndexes<default_long_Hypertrie_internal_t>();
+	}
+
+	/**
+	 * Inserts random entries and removes them again in random order, either one by one or in random batches.
+	 * The structure of the context, including reference counts, is checked after every step.
+	 */
+	template<HypertrieInternalTrait tr>
+	void checkRemove(bool bulk) {
+		constexpr pos_type depth = 3;
+
+		using key_part_type = typename tr::key_part_type;
+		using value_type = typename tr::value_type;
+		using Key = typename tr::template RawKey<depth>;
+
+		static utils::RawGenerator<depth, key_part_type, value_type, 0, 6> gen{value_type(1), value_type(5)};
+
+		for (size_t count : iter::range(1, 60, 6))
+			SECTION("insert {} key "_format(count)) {
+				for (const auto i : iter::range(20)) {
+					SECTION("{}"_format(i)) {
+						NodeContext<depth, tr> context{};
+						UncompressedNodeContainer<depth, tr> nc{};
+						auto tt = TestTensor<depth, tr>::getPrimary();
+
+						auto temp_keys = gen.keys(count);
+						std::vector<Key> keys{temp_keys.begin(), temp_keys.end()};
+						if constexpr (tr::is_lsb_unused)
+							for (auto &key : keys)
+								for (auto &key_part : key)
+									key_part <<= 1;
+
+						for (const auto &key : keys) {
+							const value_type value = gen.value();
+							context.template set<depth>(nc, key, value);
+							tt.set(key, value);
+						}
+						tt.checkContext(context);
+
+						std::shuffle(keys.begin(), keys.end(), utils::defaultRandomNumberGenerator);
+						if (bulk) {
+							auto batch_begin = keys.begin();
+							while (batch_begin != keys.end()) {
+								const auto batch_size = std::min<long>(std::distance(batch_begin, keys.end()), 1 + gen.key()[0]);
+								std::vector<Key> batch{batch_begin, batch_begin + batch_size};
+								// keys that are not contained are ignored
+								Key absent_key = gen.key();
+								if constexpr (tr::is_lsb_unused)
+									for (auto &key_part : absent_key)
+										key_part <<= 1;
+								batch.push_back(absent_key);
+								batch.push_back(batch.front());
+								for (const auto &key : batch)
+									tt.set(key, value_type{});
+								context.template bulk_remove<depth>(nc, batch);
+								tt.checkContext(context);
+								batch_begin += batch_size;
+							}
+						} else {
+							for (const auto &key : keys) {
+								context.template set<depth>(nc, key, value_type{});
+								tt.set(key, value_type{});
+								REQUIRE(context.template get<depth>(nc, key) == value_type{});
+								tt.checkContext(context);
+							}
+						}
+						REQUIRE(nc.empty());
+					}
+				}
+			}
+	}
+
+	TEST_CASE("Test Randomized remove long -> bool", "[NodeContext]") {
+		checkRemove<default_bool_Hypertrie_internal_t>(false);
+	}
+
+	TEST_CASE("Test Randomized remove long -> bool, unused_lsb", "[NodeContext]") {
+		checkRemove<Hypertrie_internal_t<Hypertrie_t<unsigned long,
+				bool,
+				hypertrie::internal::container::std_map,
+				hypertrie::internal::container::std_set,
+				true>>>(false);
+	}
+
+	TEST_CASE("Test Randomized remove long -> long", "[NodeContext]") {
+		checkRemove<default_long_Hypertrie_internal_t>(false);
+	}
+
+	/**
+	 * Bulk inserts random keys with parallel modifications in two rounds. The result must be the same as with serial modifications.
+	 */
+	template<HypertrieInternalTrait tr>
+	void checkParallelBulk() {
+		constexpr pos_type depth = 3;
+
+		using key_part_type = typename tr::key_part_type;
+		using value_type = typename tr::value_type;
+		using Key = typename tr::template RawKey<depth>;
+
+		static utils::RawGenerator<depth, key_part_type, value_type, 0, 40> gen{};
+
+		for (const auto i : iter::range(3)) {
+			SECTION("{}"_format(i)) {
+				NodeContext<depth, tr> serial_context{};
+				NodeContext<depth, tr> parallel_context{};
+				parallel_context.storage.modificationThreads(4);
+				UncompressedNodeContainer<depth, tr> serial_nc{};
+				UncompressedNodeContainer<depth, tr> parallel_nc{};
+				auto tt = TestTensor<depth, tr>::getPrimary();
+
+				std::set<Key> inserted;
+				for (const size_t count : {3000, 2000}) {
+					std::vector<Key> keys;
+					for (auto key : gen.keys(count)) {
+						if constexpr (tr::is_lsb_unused)
+							for (auto &key_part : key)
+								key_part <<= 1;
+						if (inserted.insert(key).second)
+							keys.push_back(key);
+					}
+					for (const auto &key : keys)
+						tt.set(key, true);
+					serial_context.template bulk_insert<depth>(serial_nc, keys);
+					parallel_context.template bulk_insert<depth>(parallel_nc, keys);
+					REQUIRE(parallel_nc.hash() == serial_nc.hash());
+					tt.checkContext(parallel_context);
+				}
+			}
+		}
+	}
+
+	TEST_CASE("Test Randomized parallel bulk long -> bool", "[NodeContext]") {
+		checkParallelBulk<default_bool_Hypertrie_internal_t>();
+	}
+
+	TEST_CASE("Test Randomized parallel bulk long -> bool, unused_lsb", "[NodeContext]") {
+		checkParallelBulk<Hypertrie_internal_t<Hypertrie_t<unsigned long,
+				bool,
+				hypertrie::internal::container::std_map,
+				hypertrie::internal::container::std_set,
+				true>>>();
+	}
+
+	/**
+	 * Builds random tensors from scratch with the sorted bulk build and compares them with the result of the planned
+	 * modifications. Wide key parts need multiple radix sort passes.
+	 */
+	template<HypertrieInternalTrait tr>
+	void checkSortedBuild() {
+		constexpr pos_type depth = 3;
+
+		using key_part_type = typename tr::key_part_type;
+		using value_type = typename tr::value_type;
+		using Key = typename tr::template RawKey<depth>;
+		using Entry = typename RawEntry_t<depth, tr>::RawEntry;
+
+		static utils::RawGenerator<depth, key_part_type, value_type, 0, 40> gen{value_type(1), value_type(5)};
+
+		for (const key_part_type factor : {key_part_type(2), key_part_type(2'000'006)})
+			SECTION("key parts * {}"_format(factor)) {
+				for (const size_t count : {2, 30, 3000}) {
+					SECTION("{} keys"_format(count)) {
+						NodeContext<depth, tr> sorted_context{};
+						NodeContext<depth, tr> planned_context{};
+						// the sorted build is only used by a single thread
+						planned_context.storage.modificationThreads(2);
+						UncompressedNodeContainer<depth, tr> sorted_nc{};
+						UncompressedNodeContainer<depth, tr> planned_nc{};
+						auto tt = TestTensor<depth, tr>::getPrimary();
+
+						std::vector<Entry> entries;
+						for (auto key : gen.keys(count)) {
+							for (auto &key_part : key)
+								key_part *= factor;
+							const value_type value = gen.value();
+							entries.push_back(RawEntry_t<depth, tr>::make_Entry(key, value));
+							tt.set(key, value);
+						}
+						RekNodeModification<depth, depth, tr>{sorted_context.storage, sorted_nc}.apply_insert(entries);
+						RekNodeModification<depth, depth, tr>{planned_context.storage, planned_nc}.apply_insert(entries);
+						REQUIRE(sorted_nc.hash() == planned_nc.hash());
+						tt.checkContext(sorted_context);
+					}
+				}
+			}
+	}
+
+	TEST_CASE("Test Randomized sorted build long -> bool", "[NodeContext]") {
+		checkSortedBuild<default_bool_Hypertrie_internal_t>();
+	}
+
+	TEST_CASE("Test Randomized sorted build long -> bool, unused_lsb", "[NodeContext]") {
+		checkSortedBuild<Hypertrie_internal_t<Hypertrie_t<unsigned long,
+				bool,
+				hypertrie::internal::container::std_map,
+				hypertrie::internal::container::std_set,
+				true>>>();
+	}
+
+	TEST_CASE("Test Randomized sorted build long -> long", "[NodeContext]") {
+		checkSortedBuild<default_long_Hypertrie_internal_t>();
+	}
+
+	TEST_CASE("Test Randomized bulk remove long -> bool", "[NodeContext]") {
+		checkRemove<default_bool_Hypertrie_internal_t>(true);
+	}
+
+	TEST_CASE("Test Randomized bulk remove long -> bool, unused_lsb", "[NodeContext]") {
+		checkRemove<Hypertrie_internal_t<Hypertrie_t<unsigned long,
+				bool,
+				hypertrie::internal::container::std_map,
+				hypertrie::internal::container::std_set,
+				true>>>(true);
+	}
+
+	TEST_CASE("Test Randomized bulk remove long -> long", "[NodeContext]") {
+		checkRemove<default_long_Hypertrie_internal_t>(true);
+	}
+
+	/**
+	 * Sets random batches of entries with bulk_set. The keys repeat within and across batches, so values are combined
+	 * according to the policy. Some values are zero or sum up to zero and remove entries.
+	 */
+	template<HypertrieInternalTrait tr>
+	void checkBulkSet(DuplicatePolicy policy) {
+		constexpr pos_type depth = 3;
+
+		using key_part_type = typename tr::key_part_type;
+		using value_type = typename tr::value_type;
+		using Key = typename tr::template RawKey<depth>;
+
+		static utils::RawGenerator<depth, key_part_type, value_type, 0, 6> gen{};
+		// integral values keep sums exact for floating point value types
+		auto random_value = [&]() { return value_type(long(gen.key()[0]) - 2); };
+
+		for (size_t count : iter::range(1, 80, 13))
+			SECTION("batches of {} entries"_format(count)) {
+				for (const auto i : iter::range(10)) {
+					SECTION("{}"_format(i)) {
+						NodeContext<depth, tr> context{};
+						UncompressedNodeContainer<depth, tr> nc{};
+						auto tt = TestTensor<depth, tr>::getPrimary();
+						std::map<Key, value_type> expected;
+
+						for ([[maybe_unused]] const auto batch_number : iter::range(4)) {
+							std::vector<std::pair<Key, value_type>> batch;
+							std::map<Key, value_type> batch_values;
+							for (const auto &key : gen.keys(count)) {
+								const value_type value = random_value();
+								batch.push_back({key, value});
+								if (auto found = batch_values.find(key); found != batch_values.end())
+									found->second = combineDuplicate(policy, found->second, value);
+								else
+									batch_values[key] = value;
+							}
+							// a key that occurs twice in the batch
+							batch.push_back(batch.front());
+							batch_values[batch.front().first] = combineDuplicate(policy, batch_values[batch.front().first], batch.front().second);
+
+							for (const auto &[key, value] : batch_values) {
+								const value_type present = expected.count(key) ? expected[key] : value_type{};
+								const value_type result = (present == value_type{}) ? value : combineDuplicate(policy, present, value);
+								if (result == value_type{})
+									expected.erase(key);
+								else
+									expected[key] = result;
+								tt.set(key, result);
+							}
+
+							context.template bulk_set<depth>(nc, batch, policy);
+							tt.checkContext(context);
+							for (const auto &[key, value] : batch_values)
+								REQUIRE(context.template get<depth>(nc, key) == (expected.count(key) ? expected[key] : value_type{}));
+						}
+					}
+				}
+			}
+	}
+
+	TEST_CASE("Test Randomized bulk set long -> long", "[NodeContext]") {
+		using tr = default_long_Hypertrie_internal_t;
+		SECTION("overwrite") { checkBulkSet<tr>(DuplicatePolicy::overwrite); }
+		SECTION("sum") { checkBulkSet<tr>(DuplicatePolicy::sum); }
+		SECTION("max") { checkBulkSet<tr>(DuplicatePolicy::max); }
+	}
+
+	TEST_CASE("Test Randomized bulk set long -> double", "[NodeContext]") {
+		using tr = default_double_Hypertrie_internal_t;
+		SECTION("overwrite") { checkBulkSet<tr>(DuplicatePolicy::overwrite); }
+		SECTION("sum") { checkBulkSet<tr>(DuplicatePolicy::sum); }
+		SECTION("max") { checkBulkSet<tr>(DuplicatePolicy::max); }
+	}
+
+	TEST_CASE("Test Randomized bulk set long -> bool", "[NodeContext]") {
+		SECTION("default") { checkBulkSet<default_bool_Hypertrie_internal_t>(DuplicatePolicy::overwrite); }
+		SECTION("unused_lsb") {
+			checkBulkSet<Hypertrie_internal_t<Hypertrie_t<unsigned long,
+					bool,
+					hypertrie::internal::container::std_map,
+					hypertrie::internal::container::std_set,
+					true>>>(DuplicatePolicy::overwrite);
+		}
+	}
+
 	TEST_CASE("Test Randomized long -> bool", "[NodeContext]") {
 		using tr = default_bool_Hypertrie_internal_t;
 		constexpr pos_type depth = 3;
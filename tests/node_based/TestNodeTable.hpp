@@ -0,0 +1,88 @@
+#ifndef HYPERTRIE_TESTNODETABLE_HPP
+#define HYPERTRIE_TESTNODETABLE_HPP
+
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include <Dice/hypertrie/internal/raw/storage/NodeTable.hpp>
+
+namespace hypertrie::tests::raw::node_table {
+	using namespace hypertrie::internal::raw;
+
+	using Table = NodeTable<int>;
+
+	void checkEqual(const Table &table, const std::unordered_map<size_t, int *> &expected) {
+		REQUIRE(table.size() == expected.size());
+		for (const auto &[hash, node] : expected) {
+			auto found = table.find(hash);
+			REQUIRE(found != table.end());
+			REQUIRE(found->second == node);
+		}
+		size_t iterated = 0;
+		for (const auto &[hash, node] : table) {
+			REQUIRE(expected.at(hash.hash()) == node);
+			++iterated;
+		}
+		REQUIRE(iterated == expected.size());
+	}
+
+	TEST_CASE("insert, find and erase", "[NodeTable]") {
+		std::vector<int> nodes(2000);
+		Table table;
+		std::unordered_map<size_t, int *> expected;
+
+		REQUIRE(table.find(TensorHash(2)) == table.end());
+
+		std::mt19937_64 rand{42};
+		// few distinct high bits force long probe sequences and wrap-arounds
+		std::uniform_int_distribution<size_t> hash_dist{1, 3000};
+		for (size_t i = 0; i < 20000; ++i) {
+			const size_t hash = hash_dist(rand) << 1;
+			int *node = &nodes[hash % nodes.size()];
+			if (rand() % 3 == 0) {
+				REQUIRE(table.erase(TensorHash(hash)) == expected.erase(hash));
+			} else {
+				auto [it, inserted] = table.insert({hash, node});
+				REQUIRE(inserted == expected.insert({hash, node}).second);
+				REQUIRE(it->first.hash() == hash);
+			}
+		}
+		checkEqual(table, expected);
+
+		SECTION("operator[]") {
+			table[TensorHash(6002)] = &nodes[0];
+			expected[6002] = &nodes[0];
+			checkEqual(table, expected);
+		}
+
+		SECTION("findMany") {
+			std::vector<TensorHash> hashes;
+			for (size_t hash = 2; hash < 6002; hash += 2)
+				hashes.emplace_back(hash);
+			std::vector<int *> found(hashes.size());
+			table.findMany(hashes.data(), hashes.size(), found.data());
+			for (size_t i = 0; i < hashes.size(); ++i)
+				REQUIRE(found[i] == (expected.count(hashes[i].hash()) ? expected[hashes[i].hash()] : nullptr));
+		}
+
+		SECTION("revision") {
+			const auto revision = table.revision();
+			// move a node to another hash
+			auto *moved = table.begin()->second;
+			table.eraseMoved(table.begin());
+			table.insert({TensorHash(6004), moved});
+			REQUIRE(table.revision() == revision);
+			table.erase(TensorHash(6004));
+			REQUIRE(table.revision() != revision);
+		}
+
+		SECTION("clear") {
+			table.clear();
+			REQUIRE(table.empty());
+			REQUIRE(table.begin() == table.end());
+		}
+	}
+}// namespace hypertrie::tests::raw::node_table
+
+#endif//HYPERTRIE_TESTNODETABLE_HPP
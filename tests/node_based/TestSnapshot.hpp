@@ -0,0 +1,221 @@
+#ifndef HYPERTRIE_TESTSNAPSHOT_HPP
+#define HYPERTRIE_TESTSNAPSHOT_HPP
+
+#include <Dice/hypertrie/internal/Hypertrie.hpp>
+#include <Dice/hypertrie/internal/HypertrieContext.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <optional>
+
+#include <fmt/format.h>
+
+#include "../utils/AssetGenerator.hpp"
+
+namespace hypertrie::tests::snapshot {
+	using namespace hypertrie::tests::utils;
+	using namespace hypertrie::internal;
+
+	template<HypertrieTrait tr>
+	size_t nodeCount(const HypertrieContext<tr> &context) {
+		return context.memoryStats().total().node_count;
+	}
+
+	template<HypertrieTrait tr>
+	void requireEntries(const Hypertrie<tr> &hypertrie, const std::map<typename tr::Key, typename tr::value_type> &entries) {
+		REQUIRE(hypertrie.size() == entries.size());
+		for (const auto &[key, value] : entries)
+			REQUIRE(hypertrie[key] == value);
+	}
+
+	/**
+	 * Overwrites the hash fingerprint of a snapshot file as if it was written by a process with a different entry hash function.
+	 */
+	inline void changeHashFingerprint(const std::filesystem::path &path) {
+		std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+		file.seekp(7 * sizeof(std::uint64_t));
+		const std::uint64_t fingerprint = 42;
+		file.write(reinterpret_cast<const char *>(&fingerprint), sizeof(fingerprint));
+	}
+
+	template<HypertrieTrait tr, size_t depth>
+	void checkSnapshot() {
+		using key_part_type = typename tr::key_part_type;
+		using value_type = typename tr::value_type;
+		using Key = typename tr::Key;
+
+		// few key parts to get shared subhypertries
+		utils::RawGenerator<depth, key_part_type, value_type, 1, 15> gen{value_type(1), value_type(5)};
+		std::map<Key, value_type> entries;
+		for (const auto &[raw_key, value] : gen.entries((depth == 1) ? 10 : 200)) {
+			Key key(raw_key.begin(), raw_key.end());
+			if constexpr (tr::lsb_unused)
+				for (auto &key_part : key)
+					key_part <<= 1;
+			entries[key] = value;
+		}
+
+		const auto path = std::filesystem::temp_directory_path() / fmt::format("hypertrie_snapshot_{}.bin", depth);
+
+		HypertrieContext<tr> context;
+		Hypertrie<tr> hypertrie{depth, context};
+		for (const auto &[key, value] : entries)
+			hypertrie.set(key, value);
+		Hypertrie<tr> small{depth, context};
+		small.set(entries.begin()->first, entries.begin()->second);
+		Hypertrie<tr> empty{depth, context};
+		context.save(path, {hypertrie, small, empty});
+		const size_t saved_node_count = nodeCount(context);
+
+		SECTION("load into a new context") {
+			HypertrieContext<tr> loaded_context;
+			{
+				auto loaded = loaded_context.load(path);
+				REQUIRE(loaded.size() == 3);
+				requireEntries(loaded[0], entries);
+				requireEntries(loaded[1], {*entries.begin()});
+				REQUIRE(loaded[2].empty());
+				REQUIRE(loaded[0].hash() == hypertrie.hash());
+				REQUIRE(nodeCount(loaded_context) == saved_node_count);
+
+				// the loaded hypertries can be modified
+				loaded[1].set(std::next(entries.begin())->first, std::next(entries.begin())->second);
+				REQUIRE(loaded[1].size() == 2);
+				REQUIRE(loaded[1].hash() != small.hash());
+			}
+			REQUIRE(nodeCount(loaded_context) == 0);
+		}
+
+		SECTION("load into the same context") {
+			{
+				auto loaded = context.load(path);
+				REQUIRE(loaded.size() == 3);
+				requireEntries(loaded[0], entries);
+				REQUIRE(loaded[0].hash() == hypertrie.hash());
+				// all nodes are shared
+				REQUIRE(nodeCount(context) == saved_node_count);
+			}
+			REQUIRE(nodeCount(context) == saved_node_count);
+			requireEntries(hypertrie, entries);
+		}
+
+		SECTION("load a single hypertrie") {
+			hypertrie.save(path);
+			HypertrieContext<tr> loaded_context;
+			{
+				auto loaded = Hypertrie<tr>::load(path, loaded_context);
+				requireEntries(loaded, entries);
+				auto loaded_again = Hypertrie<tr>::load(path, loaded_context);
+				REQUIRE(loaded_again.hash() == loaded.hash());
+				context.save(path, {hypertrie, small});
+				REQUIRE_THROWS_AS(Hypertrie<tr>::load(path, loaded_context), std::runtime_error);
+			}
+			REQUIRE(nodeCount(loaded_context) == 0);
+		}
+
+		SECTION("rebuild if the hash function differs") {
+			changeHashFingerprint(path);
+			HypertrieContext<tr> loaded_context;
+			{
+				auto loaded = loaded_context.load(path);
+				REQUIRE(loaded.size() == 3);
+				requireEntries(loaded[0], entries);
+				requireEntries(loaded[1], {*entries.begin()});
+				REQUIRE(loaded[2].empty());
+				REQUIRE(loaded[0].hash() == hypertrie.hash());
+			}
+			REQUIRE(nodeCount(loaded_context) == 0);
+		}
+
+		std::filesystem::remove(path);
+	}
+
+	TEST_CASE("save and load snapshots bool", "[Snapshot]") {
+		utils::resetDefaultRandomNumberGenerator();
+		SECTION("depth 1") { checkSnapshot<default_bool_Hypertrie_t, 1>(); }
+		SECTION("depth 3") { checkSnapshot<default_bool_Hypertrie_t, 3>(); }
+	}
+
+	TEST_CASE("save and load snapshots bool unused lsb", "[Snapshot]") {
+		using tr = Hypertrie_t<unsigned long, bool, container::tsl_sparse_map, container::tsl_sparse_set, true>;
+		utils::resetDefaultRandomNumberGenerator();
+		SECTION("depth 2") { checkSnapshot<tr, 2>(); }
+		SECTION("depth 3") { checkSnapshot<tr, 3>(); }
+	}
+
+	TEST_CASE("save and load snapshots long", "[Snapshot]") {
+		utils::resetDefaultRandomNumberGenerator();
+		SECTION("depth 2") { checkSnapshot<default_long_Hypertrie_t, 2>(); }
+		SECTION("depth 3") { checkSnapshot<default_long_Hypertrie_t, 3>(); }
+	}
+
+	TEST_CASE("load invalid snapshots", "[Snapshot]") {
+		using tr = default_bool_Hypertrie_t;
+		const auto path = std::filesystem::temp_directory_path() / "hypertrie_snapshot_invalid.bin";
+		HypertrieContext<tr> context;
+		{
+			std::ofstream out(path, std::ios::binary);
+			out << "not a snapshot";
+		}
+		REQUIRE_THROWS_AS(context.load(path), std::runtime_error);
+
+		HypertrieContext<default_long_Hypertrie_t> long_context;
+		Hypertrie<default_long_Hypertrie_t> hypertrie{2, long_context};
+		hypertrie.set({1, 2}, 3);
+		hypertrie.save(path);
+		REQUIRE_THROWS_AS(context.load(path), std::runtime_error);
+		std::filesystem::remove(path);
+	}
+
+	TEST_CASE("failed loads leave the context unchanged", "[Snapshot]") {
+		using tr = default_long_Hypertrie_t;
+		const auto path = std::filesystem::temp_directory_path() / "hypertrie_snapshot_truncated.bin";
+		HypertrieContext<tr> context;
+		std::optional<Hypertrie<tr>> hypertrie{std::in_place, 3, context};
+		for (unsigned long key_part = 1; key_part < 20; ++key_part)
+			hypertrie->set({key_part % 4 + 1, key_part % 5 + 1, key_part}, long(key_part));
+		hypertrie->save(path);
+		const size_t node_count = nodeCount(context);
+		// the nodes of depth 1 are stored last. The nodes of the other depths are read before the load fails.
+		std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+
+		SECTION("into a new context") {
+			HypertrieContext<tr> loaded_context;
+			REQUIRE_THROWS_AS(loaded_context.load(path), std::runtime_error);
+			REQUIRE(nodeCount(loaded_context) == 0);
+		}
+
+		SECTION("into a context that shares the nodes") {
+			REQUIRE_THROWS_AS(context.load(path), std::runtime_error);
+			REQUIRE(nodeCount(context) == node_count);
+			// the references counted by the failed load are removed again
+			hypertrie.reset();
+			REQUIRE(nodeCount(context) == 0);
+		}
+		std::filesystem::remove(path);
+	}
+
+	TEST_CASE("load snapshots with corrupt counts", "[Snapshot]") {
+		using tr = default_long_Hypertrie_t;
+		const auto path = std::filesystem::temp_directory_path() / "hypertrie_snapshot_corrupt_count.bin";
+		HypertrieContext<tr> context;
+		Hypertrie<tr> hypertrie{2, context};
+		hypertrie.set({1, 2}, 3);
+		hypertrie.save(path);
+		{
+			// the root count follows the header of eight 64 bit fields
+			std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+			file.seekp(8 * sizeof(std::uint64_t));
+			const auto root_count = std::numeric_limits<std::uint64_t>::max();
+			file.write(reinterpret_cast<const char *>(&root_count), sizeof(root_count));
+		}
+		HypertrieContext<tr> loaded_context;
+		REQUIRE_THROWS_AS(loaded_context.load(path), std::runtime_error);
+		REQUIRE(nodeCount(loaded_context) == 0);
+		std::filesystem::remove(path);
+	}
+}// namespace hypertrie::tests::snapshot
+
+#endif//HYPERTRIE_TESTSNAPSHOT_HPP
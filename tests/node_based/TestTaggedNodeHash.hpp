@@ -126,6 +126,43 @@ namespace hypertrie::tests::raw::tagged_node_hash {
 		std::sort(hashes.begin(), hashes.end());
 	}
 
+	TEST_CASE("add and remove many entries at once", "[TensorHash]") {
+		constexpr auto depth = 3;
+		using value_type = double;
+		std::vector<std::pair<Key<depth>, value_type>> entries;
+		for (size_t i = 0; i < 11; ++i)
+			entries.push_back({Key<depth>{float(i), float(i % 3), -float(i)}, value_type(i) + 0.5});
+		auto key_of = [](const auto &entry) -> const Key<depth> & { return entry.first; };
+		auto value_of = [](const auto &entry) { return entry.second; };
+
+		const TensorHash hash = TNS::getCompressedNodeHash(entries[0].first, entries[0].second);
+		TensorHash one_by_one = hash;
+		for (size_t i = 1; i < entries.size(); ++i)
+			one_by_one.addEntry(entries[i].first, entries[i].second);
+
+		const TensorHash batched = TensorHash{hash}.addEntries(entries.begin() + 1, entries.end(), key_of, value_of);
+		REQUIRE(batched == one_by_one);
+		REQUIRE(TensorHash{batched}.removeEntries(entries.begin() + 1, entries.end(), key_of, value_of, true) == hash);
+	}
+
+	TEST_CASE("deterministic entry hash", "[TensorHash]") {
+		using IntKey = hypertrie::internal::RawKey<3, unsigned long>;
+		using Hasher = DeterministicEntryHash;
+		// the hash must not change between executions and builds, e.g. for hashes in snapshot files
+		if constexpr (Hasher::seed == 0x2d358dccaa6c78a5ULL)
+			REQUIRE(Hasher::hash(IntKey{1, 2, 3}, 4L) == 0x6727d3a0cbe21bd9ULL);
+
+		REQUIRE(Hasher::hash(IntKey{1, 2, 3}, 4L) != Hasher::hash(IntKey{3, 2, 1}, 4L));
+		REQUIRE(Hasher::hash(IntKey{1, 2, 3}, 4L) != Hasher::hash(IntKey{1, 2, 3}, 5L));
+		REQUIRE(Hasher::hash(IntKey{1, 2, 3}, 4.0) != Hasher::hash(IntKey{1, 2, 3}, 4L));
+		REQUIRE(Hasher::hash(IntKey{1, 2, 3}, true) != Hasher::hash(hypertrie::internal::RawKey<2, unsigned long>{1, 2}, 3L));
+		REQUIRE(Hasher::hash(IntKey{0, 0, 0}, true) != 0);
+		// the xor of the entries of a full 2x2 tensor must not cancel out
+		using PairKey = hypertrie::internal::RawKey<2, unsigned long>;
+		REQUIRE((Hasher::hash(PairKey{1, 3}, true) xor Hasher::hash(PairKey{1, 4}, true) xor
+				 Hasher::hash(PairKey{2, 3}, true) xor Hasher::hash(PairKey{2, 4}, true)) != 0);
+	}
+
 };// namespace hypertrie::tests::tagged_node_hash
 
 #endif//HYPERTRIE_TESTTAGGEDNODEHASH_HPP
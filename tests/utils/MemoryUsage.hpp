@@ -1,6 +1,11 @@
 #ifndef HYPERTRIE_MEMORYUSAGE_HPP
 #define HYPERTRIE_MEMORYUSAGE_HPP
 
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
 
 namespace hypertrie::tests::utils {
 	struct processMem_t {
@@ -0,0 +1,88 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <Dice/hypertrie/internal/raw/node/EntryHash.hpp>
+
+#include <fmt/format.h>
+
+using key_part_type = unsigned long;
+
+/**
+ * Hashes count entries of the given depth with the entry hash and prints the time per entry.
+ * The entries are hashed one after another (single) and with hashEntries (batched).
+ */
+template<size_t depth, typename EntryHasher, typename value_type>
+void run(const std::string &name, const std::vector<hypertrie::internal::RawKey<depth, key_part_type>> &keys, const std::vector<value_type> &values) {
+	using namespace fmt::literals;
+	using namespace std::chrono;
+	using Key = hypertrie::internal::RawKey<depth, key_part_type>;
+
+	std::vector<size_t> indices(keys.size());
+	for (size_t i = 0; i < indices.size(); ++i)
+		indices[i] = i;
+
+	auto start = steady_clock::now();
+	std::uint64_t single = 0;
+	for (size_t i = 0; i < keys.size(); ++i)
+		single ^= EntryHasher::hash(keys[i], values[i]);
+	auto end = steady_clock::now();
+	const double single_ns = double(duration_cast<nanoseconds>(end - start).count()) / keys.size();
+
+	start = steady_clock::now();
+	const std::uint64_t batched = hypertrie::internal::raw::hashEntries<EntryHasher>(
+			indices.begin(), indices.end(),
+			[&](size_t i) -> const Key & { return keys[i]; },
+			[&](size_t i) { return values[i]; });
+	end = steady_clock::now();
+	const double batched_ns = double(duration_cast<nanoseconds>(end - start).count()) / keys.size();
+
+	if (single != batched)
+		std::cerr << "batched hash differs from single hashes" << std::endl;
+	std::cout << "RawKey<{}> {:<14} single: {:6.2f} ns/entry, batched: {:6.2f} ns/entry\n"_format(depth, name, single_ns, batched_ns);
+}
+
+template<size_t depth, typename value_type>
+void runDepth(size_t count, std::mt19937_64 &rand) {
+	std::vector<hypertrie::internal::RawKey<depth, key_part_type>> keys(count);
+	std::vector<value_type> values(count);
+	for (size_t i = 0; i < count; ++i) {
+		for (auto &key_part : keys[i])
+			key_part = rand() % 100'000'000;
+		values[i] = value_type(rand() % 100 + 1);
+	}
+	run<depth, hypertrie::internal::raw::DeterministicEntryHash>("deterministic", keys, values);
+	run<depth, hypertrie::internal::raw::AbslEntryHash>("absl", keys, values);
+}
+
+template<typename value_type>
+void runAll(size_t count) {
+	std::mt19937_64 rand{42};
+	runDepth<1, value_type>(count, rand);
+	runDepth<2, value_type>(count, rand);
+	runDepth<3, value_type>(count, rand);
+	runDepth<4, value_type>(count, rand);
+	runDepth<5, value_type>(count, rand);
+}
+
+int main(int argc, char *argv[]) {
+	using namespace fmt::literals;
+
+	if (argc != 3 or (std::string{argv[1]} != "bool" and std::string{argv[1]} != "long" and std::string{argv[1]} != "double")) {
+		std::cerr << "Usage: {} bool|long|double <number of entries>"_format(argv[0]) << std::endl;
+		exit(EXIT_FAILURE);
+	}
+	const std::string value_type{argv[1]};
+	const size_t count = std::stoul(argv[2]);
+
+	std::cout << "{} entries with {} values\n"_format(count, value_type);
+	if (value_type == "bool")
+		runAll<bool>(count);
+	else if (value_type == "long")
+		runAll<long>(count);
+	else
+		runAll<double>(count);
+}
@@ -70,8 +70,6 @@ int main(int argc, char *argv[]) {
 	// create emtpy primary node
 	Hypertrie<tr> hypertrie (depth);
 
-	BulkInserter<tr> bulk_inserter{hypertrie};
-
 	std::ifstream file(rdf_file);
 
 	std::string line = "";
@@ -79,7 +77,8 @@ int main(int argc, char *argv[]) {
 	unsigned int total = 0;
 	auto start = steady_clock::now();
 	{
-		BulkInserter<tr> bulk_inserter{hypertrie};
+		// parsing continues while the previous batch is inserted in the background
+		AsyncBulkInserter<tr> bulk_inserter{hypertrie};
 		while (getline(file, line)) {
 			++total;
 			using boost::lexical_cast;
@@ -91,12 +90,14 @@ int main(int argc, char *argv[]) {
 			Key key{lexical_cast<key_part_type>(id_triple[0]), lexical_cast<key_part_type>(id_triple[1]), lexical_cast<key_part_type>(id_triple[2])};
 			bulk_inserter.add(std::move(key));
 		}
+		bulk_inserter.close();
 	}
 	auto end = steady_clock::now();
 	file.close();
 	std::cerr << "{:} mio triples processed."_format(double(total)) << std::endl;
 	std::cerr << "hypertrie entries: {:d}."_format(hypertrie.size()) << std::endl;
 	std::cerr << "hypertrie size estimation: {:d} kB."_format(get_memory_usage()) << std::endl;
+	std::cerr << "node storage:\n{}"_format(hypertrie.context()->memoryStats()) << std::endl;
 	auto duration = end - start;
 
 	std::cerr << "duration: {:d}.{:03d} s."_format(duration_cast<seconds>(duration).count(),
@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <Dice/hypertrie/hypertrie.hpp>
+
+#include <fmt/format.h>
+
+using tr = hypertrie::default_bool_Hypertrie_t;
+using Key = typename tr::Key;
+
+/**
+ * Looks up all keys one after another (single) and with contains_many (batched) and prints the time per lookup.
+ * @param name name of the key set
+ * @param hypertrie the hypertrie
+ * @param keys keys to be looked up
+ * @param expected number of keys that are expected to be contained
+ */
+void run(const std::string &name, const hypertrie::const_Hypertrie<tr> &hypertrie, const std::vector<Key> &keys, size_t expected) {
+	using namespace fmt::literals;
+	using namespace std::chrono;
+
+	auto start = steady_clock::now();
+	size_t found = 0;
+	for (const auto &key : keys)
+		found += hypertrie[key];
+	auto end = steady_clock::now();
+	const double single_ns = double(duration_cast<nanoseconds>(end - start).count()) / keys.size();
+
+	start = steady_clock::now();
+	const std::vector<bool> contained = hypertrie.contains_many(keys);
+	end = steady_clock::now();
+	const double batched_ns = double(duration_cast<nanoseconds>(end - start).count()) / keys.size();
+
+	if (found != expected or size_t(std::count(contained.begin(), contained.end(), true)) != expected)
+		std::cerr << "found {} and {} of {} expected keys\n"_format(found, std::count(contained.begin(), contained.end(), true), expected);
+	std::cout << "{:<8} single: {:6.1f} ns/lookup, batched: {:6.1f} ns/lookup\n"_format(name, single_ns, batched_ns);
+}
+
+/**
+ * Point lookups on skewed triples: the key parts at position 0 (subjects) are almost unique, the key parts at
+ * position 1 (predicates) and 2 (objects) come from small sets. Half of the probed keys are contained.
+ */
+int main(int argc, char *argv[]) {
+	using namespace fmt::literals;
+
+	if (argc != 2) {
+		std::cerr << "Usage: {} <number of triples>"_format(argv[0]) << std::endl;
+		exit(EXIT_FAILURE);
+	}
+	const size_t count = std::stoul(argv[1]);
+	std::mt19937_64 rand{42};
+	auto triple = [&]() -> Key { return {rand() % (count * 10) + 1, rand() % 10 + 1, rand() % 100 + 1}; };
+
+	hypertrie::HypertrieContext<tr> context;
+	hypertrie::Hypertrie<tr> hypertrie{3, context};
+	std::vector<Key> contained;
+	contained.reserve(count);
+	{
+		hypertrie::BulkInserter<tr> inserter{hypertrie, 0, hypertrie::BulkInserter<tr>::LookupMode::batched};
+		for (size_t i = 0; i < count; ++i) {
+			Key key = triple();
+			contained.push_back(key);
+			inserter.add(std::move(key));
+		}
+	}
+	std::cout << "{} triples, {} distinct\n"_format(count, hypertrie.size());
+
+	std::vector<Key> missing;
+	missing.reserve(count);
+	while (missing.size() < count) {
+		Key key = triple();
+		// objects above 100 are never inserted
+		key[2] += 100;
+		missing.push_back(key);
+	}
+
+	std::shuffle(contained.begin(), contained.end(), rand);
+	run("hits", hypertrie, contained, contained.size());
+	run("misses", hypertrie, missing, 0);
+}
@@ -0,0 +1,85 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <Dice/hypertrie/hypertrie.hpp>
+#include <Dice/hypertrie/internal/util/SlabAllocator.hpp>
+
+#include <fmt/format.h>
+
+#include "../tests/utils/MemoryUsage.hpp"
+
+
+using tr = hypertrie::Hypertrie_t<unsigned long,
+								  bool,
+								  hypertrie::internal::container::tsl_sparse_map,
+								  hypertrie::internal::container::tsl_sparse_set,
+								  false>;
+using tri = hypertrie::internal::raw::Hypertrie_internal_t<tr>;
+using hypertrie::tests::utils::get_memory_usage;
+using Node_t = hypertrie::internal::raw::CompressedNode<3, tri>;
+
+/**
+ * Allocates count compressed nodes, frees every second of them and allocates them again.
+ * Prints the time and the resident memory for each phase.
+ * @param allocate function that allocates a node for a key
+ * @param deallocate function that frees a node
+ * @param count number of nodes
+ */
+template<typename Allocate, typename Deallocate>
+void run(Allocate &&allocate, Deallocate &&deallocate, size_t count) {
+	using namespace fmt::literals;
+	using namespace std::chrono;
+
+	std::vector<Node_t *> nodes(count);
+	std::mt19937_64 rand{42};
+	const uint32_t mem_before = get_memory_usage().physicalMem;
+
+	auto start = steady_clock::now();
+	for (size_t i = 0; i < count; ++i)
+		nodes[i] = allocate(typename Node_t::RawKey{rand(), rand(), rand()});
+	auto end = steady_clock::now();
+	std::cout << "allocate: {} ms, {} kB\n"_format(duration_cast<milliseconds>(end - start).count(),
+												   get_memory_usage().physicalMem - mem_before);
+
+	start = steady_clock::now();
+	for (size_t i = 0; i < count; i += 2)
+		deallocate(nodes[i]);
+	for (size_t i = 0; i < count; i += 2)
+		nodes[i] = allocate(typename Node_t::RawKey{rand(), rand(), rand()});
+	end = steady_clock::now();
+	std::cout << "churn:    {} ms, {} kB\n"_format(duration_cast<milliseconds>(end - start).count(),
+												   get_memory_usage().physicalMem - mem_before);
+
+	start = steady_clock::now();
+	for (auto *node : nodes)
+		deallocate(node);
+	end = steady_clock::now();
+	std::cout << "free:     {} ms\n"_format(duration_cast<milliseconds>(end - start).count());
+}
+
+int main(int argc, char *argv[]) {
+	using namespace fmt::literals;
+
+	if (argc != 3 or (std::string{argv[1]} != "slab" and std::string{argv[1]} != "new")) {
+		std::cerr << "Usage: {} slab|new <number of nodes>"_format(argv[0]) << std::endl;
+		exit(EXIT_FAILURE);
+	}
+	const std::string mode{argv[1]};
+	const size_t count = std::stoul(argv[2]);
+
+	std::cout << "{} nodes of {} bytes with {}\n"_format(count, sizeof(Node_t), mode);
+	if (mode == "slab") {
+		hypertrie::internal::util::SlabAllocator<Node_t> allocator;
+		run([&](const auto &key) { return allocator.construct(key, 1); },
+			[&](Node_t *node) { allocator.destroy(node); },
+			count);
+		std::cout << "slab capacity: {} nodes, {} kB\n"_format(allocator.capacity(), allocator.allocatedBytes() / 1024);
+	} else {
+		run([](const auto &key) { return new Node_t{key, 1}; },
+			[](Node_t *node) { delete node; },
+			count);
+	}
+}